@@ -0,0 +1,278 @@
+// Statistical benchmark driver for the phelt/ suite (the phelt_bench CMake
+// target). Each script runs N times in a fresh embedding context; the driver
+// reports median, min and standard deviation per script, optionally writes
+// the results as JSON, and fails when a median regresses past a threshold
+// against a stored baseline file (itself a previous JSON result).
+//
+//     phelt_bench [-n runs] [-o results.json] [-b baseline.json]
+//                 [-t threshold%] [script.ph ...]
+//
+// With no scripts given the driver runs the default suite under phelt/, so
+// it expects to be invoked from the repository root. Script output is
+// silenced during timed runs. Builds with DEBUG_DISPATCH_STATS additionally
+// report interpreted instructions per second.
+
+#include "common.h"
+#include "phelt.h"
+#include "vm.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_BENCHMARKS 64
+#define MAX_RUNS 1000
+
+static const char* defaultScripts[] = {
+    "phelt/benchmark.ph",
+    "phelt/loops.ph",
+    "phelt/tree.ph",
+    "phelt/mand.ph",
+    "phelt/string.ph",
+};
+
+typedef struct {
+    const char* path;
+    double      times[MAX_RUNS];
+    double      median;
+    double      min;
+    double      stddev;
+    double      instructionsPerSec;
+} Benchmark;
+
+static double nowMs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+    double diff = *(const double*)a - *(const double*)b;
+    return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+// One timed run in a throwaway context, with stdout and stderr parked on
+// /dev/null so the scripts' own printing stays out of the report.
+static double timedRun(const char* path, const char* source, uint64_t* instructions)
+{
+    fflush(stdout);
+    fflush(stderr);
+    int savedOut = dup(STDOUT_FILENO);
+    int savedErr = dup(STDERR_FILENO);
+    int devNull  = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    dup2(devNull, STDERR_FILENO);
+
+#ifdef DEBUG_DISPATCH_STATS
+    dispatchStatsReset();
+#endif
+
+    PheltContext* context = pheltNewContext(0, 0);
+    double        start   = nowMs();
+    PheltStatus   status  = pheltRun(context, path, source);
+    double        elapsed = nowMs() - start;
+#ifdef DEBUG_DISPATCH_STATS
+    // freeVM dumps and resets the counters, so read them first.
+    *instructions += dispatchStatsTotal();
+#else
+    (void)instructions;
+#endif
+    pheltFreeContext(context);
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(savedOut, STDOUT_FILENO);
+    dup2(savedErr, STDERR_FILENO);
+    close(savedOut);
+    close(savedErr);
+    close(devNull);
+
+    if (status != PHELT_OK) {
+        fprintf(stderr, "phelt_bench: %s failed (%s)\n", path,
+            status == PHELT_COMPILE_ERROR ? "compile error" : "runtime error");
+        exit(1);
+    }
+
+    return elapsed;
+}
+
+static void runBenchmark(Benchmark* bench, int runs)
+{
+    utf8_int8_t* source = readFile(bench->path);
+
+    uint64_t instructions = 0;
+    for (int i = 0; i < runs; i++) {
+        bench->times[i] = timedRun(bench->path, source, &instructions);
+    }
+    free(source);
+
+    double sorted[MAX_RUNS];
+    memcpy(sorted, bench->times, sizeof(double) * runs);
+    qsort(sorted, runs, sizeof(double), compareDoubles);
+
+    bench->min    = sorted[0];
+    bench->median = runs % 2 == 1
+        ? sorted[runs / 2]
+        : (sorted[runs / 2 - 1] + sorted[runs / 2]) / 2.0;
+
+    double mean = 0.0;
+    for (int i = 0; i < runs; i++) {
+        mean += bench->times[i];
+    }
+    mean /= runs;
+    double variance = 0.0;
+    for (int i = 0; i < runs; i++) {
+        variance += (bench->times[i] - mean) * (bench->times[i] - mean);
+    }
+    bench->stddev = runs > 1 ? sqrt(variance / (runs - 1)) : 0.0;
+
+    double totalMs = mean * runs;
+    bench->instructionsPerSec = totalMs > 0.0
+        ? (double)instructions / (totalMs / 1000.0)
+        : 0.0;
+}
+
+static void writeResults(const char* path, Benchmark* benchmarks, int count, int runs)
+{
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        fprintf(stderr, "phelt_bench: could not write '%s'\n", path);
+        exit(1);
+    }
+
+    fprintf(out, "{\"runs\":%d,\"benchmarks\":[", runs);
+    for (int i = 0; i < count; i++) {
+        Benchmark* bench = &benchmarks[i];
+        fprintf(out,
+            "%s{\"name\":\"%s\",\"medianMs\":%.3f,\"minMs\":%.3f,"
+            "\"stddevMs\":%.3f,\"instructionsPerSec\":%.0f}",
+            i > 0 ? "," : "", bench->path, bench->median, bench->min,
+            bench->stddev, bench->instructionsPerSec);
+    }
+    fprintf(out, "]}\n");
+    fclose(out);
+}
+
+// Pull one benchmark's stored median out of a baseline JSON file written by
+// a previous -o run. A missing file is fatal; a missing entry just means
+// the benchmark is new.
+static bool baselineMedian(const char* baseline, const char* name, double* median)
+{
+    const char* at = baseline;
+    size_t      nameLength = strlen(name);
+    while ((at = strstr(at, "\"name\":\"")) != NULL) {
+        at += 8;
+        if (strncmp(at, name, nameLength) == 0 && at[nameLength] == '"') {
+            const char* value = strstr(at, "\"medianMs\":");
+            if (value == NULL)
+                return false;
+            *median = strtod(value + 11, NULL);
+            return true;
+        }
+    }
+    return false;
+}
+
+static char* readBaseline(const char* path)
+{
+    FILE* in = fopen(path, "r");
+    if (in == NULL) {
+        fprintf(stderr, "phelt_bench: could not read baseline '%s'\n", path);
+        exit(1);
+    }
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    rewind(in);
+    char* buffer = malloc(size + 1);
+    if (buffer == NULL || fread(buffer, 1, size, in) != (size_t)size) {
+        fprintf(stderr, "phelt_bench: could not read baseline '%s'\n", path);
+        exit(1);
+    }
+    buffer[size] = '\0';
+    fclose(in);
+    return buffer;
+}
+
+int main(int argc, char** argv)
+{
+    int         runs          = 5;
+    const char* resultsPath   = NULL;
+    const char* baselinePath  = NULL;
+    double      threshold     = 10.0;
+    const char* scripts[MAX_BENCHMARKS];
+    int         scriptCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            resultsPath = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threshold = strtod(argv[++i], NULL);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr,
+                "usage: phelt_bench [-n runs] [-o results.json]"
+                " [-b baseline.json] [-t threshold%%] [script.ph ...]\n");
+            return 1;
+        } else if (scriptCount < MAX_BENCHMARKS) {
+            scripts[scriptCount++] = argv[i];
+        }
+    }
+    if (runs < 1)
+        runs = 1;
+    if (runs > MAX_RUNS)
+        runs = MAX_RUNS;
+
+    if (scriptCount == 0) {
+        scriptCount = (int)(sizeof(defaultScripts) / sizeof(defaultScripts[0]));
+        for (int i = 0; i < scriptCount; i++) {
+            scripts[i] = defaultScripts[i];
+        }
+    }
+
+    static Benchmark benchmarks[MAX_BENCHMARKS];
+    for (int i = 0; i < scriptCount; i++) {
+        benchmarks[i].path = scripts[i];
+        runBenchmark(&benchmarks[i], runs);
+        printf("%-24s median %9.3fms  min %9.3fms  stddev %8.3fms",
+            benchmarks[i].path, benchmarks[i].median, benchmarks[i].min,
+            benchmarks[i].stddev);
+        if (benchmarks[i].instructionsPerSec > 0.0) {
+            printf("  %.0f instr/s", benchmarks[i].instructionsPerSec);
+        }
+        printf("\n");
+    }
+
+    if (resultsPath != NULL) {
+        writeResults(resultsPath, benchmarks, scriptCount, runs);
+    }
+
+    int failures = 0;
+    if (baselinePath != NULL) {
+        char* baseline = readBaseline(baselinePath);
+        for (int i = 0; i < scriptCount; i++) {
+            double base;
+            if (!baselineMedian(baseline, benchmarks[i].path, &base)) {
+                printf("%-24s no baseline entry\n", benchmarks[i].path);
+                continue;
+            }
+            double delta = (benchmarks[i].median - base) / base * 100.0;
+            printf("%-24s baseline %9.3fms  %+6.2f%%%s\n",
+                benchmarks[i].path, base, delta,
+                delta > threshold ? "  REGRESSION" : "");
+            if (delta > threshold)
+                failures++;
+        }
+        free(baseline);
+    }
+
+    return failures > 0 ? 1 : 0;
+}
@@ -5,12 +5,22 @@
 
 void initChunk(Chunk* chunk)
 {
-    chunk->count    = 0;
-    chunk->capacity = 0;
-    chunk->code     = NULL;
+    chunk->count         = 0;
+    chunk->capacity      = 0;
+    chunk->code          = NULL;
+    chunk->cacheCount    = 0;
+    chunk->cacheCapacity = 0;
+    chunk->caches        = NULL;
+
+    chunk->switchTableCount    = 0;
+    chunk->switchTableCapacity = 0;
+    chunk->switchTables        = NULL;
+
+    chunk->lineRuns        = NULL;
+    chunk->lineRunCount    = 0;
+    chunk->lineRunCapacity = 0;
 
     initValueArray(&chunk->constants);
-    initValueArray(&chunk->lines);
 }
 
 void writeChunk(Chunk* chunk, uint8_t byte, int line)
@@ -22,10 +32,53 @@ void writeChunk(Chunk* chunk, uint8_t byte, int line)
     }
 
     chunk->code[chunk->count] = byte;
-    writeValueArray(&chunk->lines, NUMBER_VAL(line));
+
+    // Extend the current line run, or open a new one for this offset.
+    if (chunk->lineRunCount == 0 || chunk->lineRuns[chunk->lineRunCount - 1].line != line) {
+        if (chunk->lineRunCapacity < chunk->lineRunCount + 1) {
+            int oldCapacity        = chunk->lineRunCapacity;
+            chunk->lineRunCapacity = GROW_CAPACITY(oldCapacity);
+            chunk->lineRuns        = GROW_ARRAY(LineRun, chunk->lineRuns, oldCapacity, chunk->lineRunCapacity);
+        }
+        chunk->lineRuns[chunk->lineRunCount].line  = line;
+        chunk->lineRuns[chunk->lineRunCount].start = chunk->count;
+        chunk->lineRunCount++;
+    }
+
     chunk->count++;
 }
 
+// Source line for the code byte at offset, by binary search over the runs.
+int getLine(Chunk* chunk, int offset)
+{
+    if (chunk->lineRunCount == 0)
+        return 0;
+
+    int lo  = 0;
+    int hi  = chunk->lineRunCount - 1;
+    int run = 0;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (chunk->lineRuns[mid].start <= offset) {
+            run = mid;
+            lo  = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return chunk->lineRuns[run].line;
+}
+
+// Rewind the chunk to an earlier length, dropping line runs that now
+// start past the end. Constants stay; unused slots are harmless.
+void truncateChunk(Chunk* chunk, int count)
+{
+    chunk->count = count;
+    while (chunk->lineRunCount > 0 && chunk->lineRuns[chunk->lineRunCount - 1].start >= count) {
+        chunk->lineRunCount--;
+    }
+}
+
 void remiteBytes(Chunk* chunk, int index, int amount)
 {
     if (index + amount >= chunk->count) {
@@ -35,9 +88,26 @@ void remiteBytes(Chunk* chunk, int index, int amount)
     memcpy((chunk->code + index), (chunk->code + index + amount), chunk->count - (index + amount));
     chunk->count -= amount;
 
-    for (int i = 0; i < amount; i++) {
-        removeValueArrayAt(&chunk->lines, index);
+    // Slide run starts past the removed range back, then drop runs that
+    // were shadowed (a later run landing on the same start wins) or that
+    // now repeat the previous run's line.
+    for (int i = 0; i < chunk->lineRunCount; i++) {
+        if (chunk->lineRuns[i].start > index) {
+            int start = chunk->lineRuns[i].start - amount;
+            chunk->lineRuns[i].start = start < index ? index : start;
+        }
+    }
+
+    int out = 0;
+    for (int i = 0; i < chunk->lineRunCount; i++) {
+        if (i + 1 < chunk->lineRunCount
+            && chunk->lineRuns[i + 1].start == chunk->lineRuns[i].start)
+            continue;
+        if (out > 0 && chunk->lineRuns[out - 1].line == chunk->lineRuns[i].line)
+            continue;
+        chunk->lineRuns[out++] = chunk->lineRuns[i];
     }
+    chunk->lineRunCount = out;
 }
 
 int addConstant(Chunk* chunk, Value value)
@@ -48,10 +118,48 @@ int addConstant(Chunk* chunk, Value value)
     return chunk->constants.count - 1;
 }
 
+int addCache(Chunk* chunk)
+{
+    if (chunk->cacheCapacity < chunk->cacheCount + 1) {
+        int oldCapacity      = chunk->cacheCapacity;
+        chunk->cacheCapacity = GROW_CAPACITY(oldCapacity);
+        chunk->caches        = GROW_ARRAY(InlineCache, chunk->caches, oldCapacity, chunk->cacheCapacity);
+    }
+
+    InlineCache* cache = &chunk->caches[chunk->cacheCount];
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        cache->entries[i].klass = NULL;
+        cache->entries[i].value = NIL_VAL;
+    }
+
+    return chunk->cacheCount++;
+}
+
+int addSwitchTable(Chunk* chunk)
+{
+    if (chunk->switchTableCapacity < chunk->switchTableCount + 1) {
+        int oldCapacity            = chunk->switchTableCapacity;
+        chunk->switchTableCapacity = GROW_CAPACITY(oldCapacity);
+        chunk->switchTables        = GROW_ARRAY(SwitchTable, chunk->switchTables, oldCapacity, chunk->switchTableCapacity);
+    }
+
+    SwitchTable* table   = &chunk->switchTables[chunk->switchTableCount];
+    table->enabled       = false;
+    table->defaultOffset = 0;
+    initTable(&table->offsets);
+
+    return chunk->switchTableCount++;
+}
+
 void freeChunk(Chunk* chunk)
 {
     FREE_ARRAY(uint8_t, chunk->code, chunk->capacity);
-    freeValueArray(&chunk->lines);
+    FREE_ARRAY(InlineCache, chunk->caches, chunk->cacheCapacity);
+    for (int i = 0; i < chunk->switchTableCount; i++) {
+        freeTable(&chunk->switchTables[i].offsets);
+    }
+    FREE_ARRAY(SwitchTable, chunk->switchTables, chunk->switchTableCapacity);
+    FREE_ARRAY(LineRun, chunk->lineRuns, chunk->lineRunCapacity);
     freeValueArray(&chunk->constants);
     initChunk(chunk);
 }
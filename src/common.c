@@ -1,33 +1,46 @@
 #include "common.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 utf8_int8_t* readFile(const char* path)
 {
-    FILE* file = fopen(path, "rb");
-    if (file == NULL) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
         fprintf(stderr, "Could not open file \"%s\".\n", path);
         exit(74);
     }
 
-    fseek(file, 0L, SEEK_END);
-    size_t fileSize = ftell(file);
-    rewind(file);
+    // One fstat for the size, then sized reads straight into the buffer —
+    // no stdio stream, no seek-to-end round trip. The scanner wants a
+    // NUL-terminated private copy, so a plain read beats mmap here.
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "Could not read file \"%s\".\n", path);
+        exit(74);
+    }
 
-    utf8_int8_t* buffer = (char*)malloc(fileSize + 1);
+    size_t       fileSize = (size_t)info.st_size;
+    utf8_int8_t* buffer   = (char*)malloc(fileSize + 1);
     if (buffer == NULL) {
         fprintf(stderr, "Not enough memory to read \"%s\".\n", path);
         exit(74);
     }
 
-    size_t bytesRead = fread(buffer, sizeof(char), fileSize, file);
-    if (bytesRead < fileSize) {
-        fprintf(stderr, "Could not read file \"%s\".\n", path);
-        exit(74);
+    size_t bytesRead = 0;
+    while (bytesRead < fileSize) {
+        ssize_t chunk = read(fd, buffer + bytesRead, fileSize - bytesRead);
+        if (chunk <= 0) {
+            fprintf(stderr, "Could not read file \"%s\".\n", path);
+            exit(74);
+        }
+        bytesRead += (size_t)chunk;
     }
 
     buffer[bytesRead] = '\0';
 
-    fclose(file);
+    close(fd);
     return buffer;
 }
 
@@ -70,28 +83,83 @@ const char* getFilePath(const char* path)
     return resolvedPath;
 }
 
+// Imports resolve the same (path, currentFile) pairs every time the
+// importing line executes, and resolution is a pure function of its inputs,
+// so results are interned here for the life of the process. Callers must
+// not free a resolved path; functions compiled from the file alias it as
+// their source for error traces anyway. Worker isolates resolve imports
+// concurrently, so the cache is guarded by a lock; two threads losing the
+// race over the same pair just intern it twice, and both entries stay
+// valid forever.
+typedef struct {
+    char*       path;
+    char*       currentFile;
+    const char* resolved;
+} ResolvedPath;
+
+static ResolvedPath*   resolvedPaths        = NULL;
+static int             resolvedPathCount    = 0;
+static int             resolvedPathCapacity = 0;
+static pthread_mutex_t resolvedPathLock     = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* cachedResolution(const char* path, const char* currentFile)
+{
+    const char* found = NULL;
+    pthread_mutex_lock(&resolvedPathLock);
+    for (int i = 0; i < resolvedPathCount; i++) {
+        if (strcmp(resolvedPaths[i].path, path) == 0
+            && strcmp(resolvedPaths[i].currentFile, currentFile) == 0) {
+            found = resolvedPaths[i].resolved;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&resolvedPathLock);
+    return found;
+}
+
+static void cacheResolution(const char* path, const char* currentFile, const char* resolved)
+{
+    pthread_mutex_lock(&resolvedPathLock);
+    if (resolvedPathCount == resolvedPathCapacity) {
+        resolvedPathCapacity = resolvedPathCapacity < 8 ? 8 : resolvedPathCapacity * 2;
+        resolvedPaths        = realloc(resolvedPaths, sizeof(ResolvedPath) * resolvedPathCapacity);
+    }
+    resolvedPaths[resolvedPathCount].path        = strdup(path);
+    resolvedPaths[resolvedPathCount].currentFile = strdup(currentFile);
+    resolvedPaths[resolvedPathCount].resolved    = resolved;
+    resolvedPathCount++;
+    pthread_mutex_unlock(&resolvedPathLock);
+}
+
 // check for a file relative to the current file, or in the current directory
 const char* resolveRelativePath(const char* path, const char* currentFile)
 {
+    const char* cached = cachedResolution(path, currentFile);
+    if (cached != NULL) {
+        return cached;
+    }
+
+    const char* resolved;
     const char* filePath = getFilePath(currentFile);
     if (filePath == NULL) {
-        return resolvePath(path);
+        resolved = resolvePath(path);
+    } else {
+        const char* withExtension = (char*)ensureExtension(path, ".ph");
+        char*       resolvedPath  = (char*)malloc(strlen(filePath) + strlen(withExtension) + 2);
+        strcpy(resolvedPath, filePath);
+        strcat(resolvedPath, "/");
+        strcat(resolvedPath, withExtension);
+        free((void*)withExtension);
+        free((void*)filePath);
+        resolved = resolvedPath;
     }
-    const char* withExtension = (char*)ensureExtension(path, ".ph");
-    char*       resolvedPath  = (char*)malloc(strlen(filePath) + strlen(withExtension) + 2);
-    strcpy(resolvedPath, filePath);
-    strcat(resolvedPath, "/");
-    strcat(resolvedPath, withExtension);
-    free((void*)filePath);
-    return resolvedPath;
+
+    cacheResolution(path, currentFile, resolved);
+    return resolved;
 }
 
 bool fileExists(const char* path)
 {
-    FILE* file = fopen(path, "rb");
-    if (file == NULL) {
-        return false;
-    }
-    fclose(file);
-    return true;
+    struct stat info;
+    return stat(path, &info) == 0;
 }
@@ -5,6 +5,16 @@
 #include "memory.h"
 #include "object.h"
 #include "scanner.h"
+#include "table.h"
+
+// From vm.h, which can't be included here: its call() declaration
+// collides with the parser's static call().
+void  push(Value value);
+Value pop(void);
+
+// from vm.c; vm.h can't be included here because its call() clashes with
+// the parser's call rule
+uint16_t globalSlot(Value name);
 
 typedef struct
 {
@@ -74,6 +84,10 @@ typedef struct Compiler {
     bool      isInLoop;
     JumpNode* breakNodes;
     int       loopStart;
+
+    // Maps constant values already in this function's pool to their index,
+    // so repeated mentions of a name or number share one slot.
+    Table constantIndexes;
 } Compiler;
 
 typedef struct ClassCompiler {
@@ -81,12 +95,14 @@ typedef struct ClassCompiler {
     bool                  hasSuperclass;
 } ClassCompiler;
 
-Parser         parser;
-Chunk*         compilingChunk;
-Compiler*      current        = NULL;
-ClassCompiler* currentClass   = NULL;
-int            anonymousCount = 0;
-bool           inParamList    = false;
+// Thread-local so worker isolates can compile concurrently without a
+// shared-parser lock; each OS thread gets its own compiler state.
+__thread Parser         parser;
+__thread Chunk*         compilingChunk;
+__thread Compiler*      current        = NULL;
+__thread ClassCompiler* currentClass   = NULL;
+__thread int            anonymousCount = 0;
+__thread bool           inParamList    = false;
 
 static Chunk* currentChunk(void)
 {
@@ -217,12 +233,30 @@ static void emitReturn(void)
 
 static uint16_t makeConstant(Value value)
 {
+    // Names and numbers repeat constantly in real code; reusing an
+    // existing slot keeps the pool small and stretches the index limit.
+    // Strings from the scanner are interned, so the lookup is cheap.
+    // Function constants are unique per definition and skip the map.
+    if (IS_NUMBER(value) || IS_STRING(value)) {
+        Value existing;
+        if (tableGet(&current->constantIndexes, value, &existing)) {
+            return (uint16_t)AS_NUMBER(existing);
+        }
+    }
+
+    // The function being compiled may already have been promoted by a
+    // collection that ran mid-compile, so new constants need the barrier.
+    writeBarrier((Obj*)current->function, value);
     int constant = addConstant(currentChunk(), value);
     if (constant > UINT8_MAX) {
         error("Too many constants in one chunk.");
         return 0;
     }
 
+    if (IS_NUMBER(value) || IS_STRING(value)) {
+        tableSet(&current->constantIndexes, value, NUMBER_VAL(constant));
+    }
+
     return constant;
 }
 
@@ -231,6 +265,11 @@ static void emitConstant(Value value)
     emitOpShort(OP_CONSTANT, makeConstant(value));
 }
 
+static void emitCache(void)
+{
+    emitShort((uint16_t)addCache(currentChunk()));
+}
+
 static void patchJump(int offset)
 {
     // -2 to adjust for the bytecode for the jump offset itself.
@@ -254,6 +293,7 @@ static void initCompiler(Compiler* compiler, FunctionType type)
     compiler->isInLoop   = false;
     compiler->breakNodes = NULL;
     compiler->loopStart  = 0;
+    initTable(&compiler->constantIndexes);
 
     current = compiler;
 
@@ -265,6 +305,7 @@ static void initCompiler(Compiler* compiler, FunctionType type)
         } else {
             current->function->name = copyString(parser.previous.start, parser.previous.length);
         }
+        writeBarrier((Obj*)current->function, OBJ_VAL(current->function->name));
     }
 
     Local* local      = &current->locals[current->localCount++];
@@ -290,6 +331,7 @@ static ObjFunction* endCompiler(void)
     }
 #endif
 
+    freeTable(&current->constantIndexes);
     current = current->enclosing;
 
     return function;
@@ -321,6 +363,7 @@ static void       declaration(void);
 static ParseRule* getRule(TokenType type);
 static void       parsePrecedence(Precedence precedence);
 static uint16_t   identifierConstant(Token* name);
+static uint16_t   identifierSlot(Token* name);
 static int        resolveLocal(Compiler* compiler, Token* name);
 static int        resolveUpvalue(Compiler* compiler, Token* name);
 static uint16_t   argumentList(void);
@@ -426,10 +469,12 @@ static void dot(bool canAssign)
     if (canAssign && match(TOKEN_EQUAL)) {
         expression();
         emitOpShort(OP_SET_PROPERTY, name);
+        emitCache();
     } else if (match(TOKEN_LEFT_PAREN)) {
         uint16_t argCount = argumentList();
         emitOpShort(OP_INVOKE, name);
         emitShort(argCount);
+        emitCache();
     } else {
         TokenType type = parser.current.type;
 
@@ -441,6 +486,7 @@ static void dot(bool canAssign)
             advance();
             emitByte(OP_DUP);
             emitOpShort(OP_GET_PROPERTY, name);
+            emitCache();
             expression();
 
             switch (type) {
@@ -462,6 +508,7 @@ static void dot(bool canAssign)
             }
 
             emitOpShort(OP_SET_PROPERTY, name);
+            emitCache();
             break;
         }
 
@@ -470,13 +517,16 @@ static void dot(bool canAssign)
             advance();
             emitByte(OP_DUP);
             emitOpShort(OP_GET_PROPERTY, name);
+            emitCache();
             emitByte(type == TOKEN_PLUS_PLUS ? OP_INCREMENT : OP_DECREMENT);
             emitOpShort(OP_SET_PROPERTY, name);
+            emitCache();
             break;
         }
 
         default:
             emitOpShort(OP_GET_PROPERTY, name);
+            emitCache();
         }
     }
 }
@@ -589,7 +639,7 @@ static void namedVariable(Token name, bool canAssign)
         getOp = OP_GET_UPVALUE;
         setOp = OP_SET_UPVALUE;
     } else {
-        arg   = identifierConstant(&name);
+        arg   = identifierSlot(&name);
         getOp = OP_GET_GLOBAL;
         setOp = OP_SET_GLOBAL;
     }
@@ -707,14 +757,39 @@ static void unary(bool canAssign)
     TokenType operatorType = parser.previous.type;
 
     // Compile the operand.
+    int operandStart = currentChunk()->count;
     parsePrecedence(PREC_UNARY);
 
-    // Emit the operator instruction.
+    // Emit the operator instruction, folding literal operands so that
+    // `-2` and `!true` become plain constants instead of run-time work.
+    Chunk* chunk = currentChunk();
     switch (operatorType) {
     case TOKEN_BANG:
+        if (chunk->count == operandStart + 1
+            && (chunk->code[operandStart] == OP_TRUE || chunk->code[operandStart] == OP_FALSE
+                || chunk->code[operandStart] == OP_NIL)) {
+            bool falsey              = chunk->code[operandStart] != OP_TRUE;
+            chunk->code[operandStart] = falsey ? OP_TRUE : OP_FALSE;
+            break;
+        }
+        if (chunk->count == operandStart + 3 && chunk->code[operandStart] == OP_CONSTANT) {
+            // Numbers and strings are truthy, so their negation is false.
+            truncateChunk(chunk, operandStart);
+            emitByte(OP_FALSE);
+            break;
+        }
         emitByte(OP_NOT);
         break;
     case TOKEN_MINUS:
+        if (chunk->count == operandStart + 3 && chunk->code[operandStart] == OP_CONSTANT) {
+            uint16_t arg = (uint16_t)((chunk->code[operandStart + 1] << 8) | chunk->code[operandStart + 2]);
+            Value    operand = chunk->constants.values[arg];
+            if (IS_NUMBER(operand)) {
+                truncateChunk(chunk, operandStart);
+                emitConstant(NUMBER_VAL(-AS_NUMBER(operand)));
+                break;
+            }
+        }
         emitByte(OP_NEGATE);
         break;
     default:
@@ -867,6 +942,13 @@ static uint16_t identifierConstant(Token* name)
     return makeConstant(OBJ_VAL(copyString(name->start, name->length)));
 }
 
+// Globals are addressed by slot index into vm.globalSlots, resolved once
+// at compile time instead of hashing the name on every access.
+static uint16_t identifierSlot(Token* name)
+{
+    return globalSlot(OBJ_VAL(copyString(name->start, name->length)));
+}
+
 static bool identifiersEqual(Token* a, Token* b)
 {
     if (a->length != b->length)
@@ -972,7 +1054,7 @@ static uint16_t parseVariable(const char* errorMessage)
     if (current->scopeDepth > 0)
         return 0;
 
-    return identifierConstant(&parser.previous);
+    return identifierSlot(&parser.previous);
 }
 
 static void markInitialized(void)
@@ -1078,10 +1160,11 @@ static void classDeclaration(void)
     Token className = parser.previous;
 
     uint16_t nameConstant = identifierConstant(&parser.previous);
+    uint16_t nameSlot     = current->scopeDepth > 0 ? 0 : identifierSlot(&parser.previous);
     declareVariable();
 
     emitOpShort(OP_CLASS, nameConstant);
-    defineVariable(nameConstant);
+    defineVariable(nameSlot);
     ClassCompiler classCompiler;
     classCompiler.hasSuperclass = false;
     classCompiler.enclosing     = currentClass;
@@ -1130,6 +1213,7 @@ static void classDeclaration(void)
 
             consume(TOKEN_SEMICOLON, "Expect ';' after property declaration.");
             emitOpShort(OP_SET_PROPERTY, property);
+            emitCache();
         } else {
             error("Expect method or property declarations.");
         }
@@ -1204,11 +1288,22 @@ static void switchStatement(void)
     consume(TOKEN_RIGHT_PAREN, "Expect ')' after value.");
     consume(TOKEN_LEFT_BRACE, "Expect '{' before switch cases.");
 
+    // Reserve a jump table up front; it is filled in and enabled after the
+    // cases are parsed, if every case value turned out to be a literal.
+    int switchIndex = addSwitchTable(currentChunk());
+    emitOpShort(OP_SWITCH, (uint16_t)switchIndex);
+
     int state = 0; // 0: before all cases, 1: before default, 2: after default.
     int caseEnds[MAX_CASES];
     int caseCount        = 0;
     int previousCaseSkip = -1;
 
+    Value caseValues[MAX_CASES];
+    int   caseOffsets[MAX_CASES];
+    int   tableCount    = 0;
+    bool  tableOk       = true;
+    int   defaultOffset = -1;
+
     while (!match(TOKEN_RIGHT_BRACE) && !check(TOKEN_EOF)) {
         if (match(TOKEN_CASE) || match(TOKEN_DEFAULT)) {
             TokenType caseType = parser.previous.type;
@@ -1231,19 +1326,41 @@ static void switchStatement(void)
 
                 // See if the case is equal to the value.
                 emitByte(OP_DUP);
+                int valueStart = currentChunk()->count;
                 expression();
 
                 consume(TOKEN_COLON, "Expect ':' after case value.");
 
+                // A literal case value (single OP_CONSTANT) is jump-table
+                // material; anything computed disables the table.
+                Value caseValue = NIL_VAL;
+                bool  literal   = false;
+                if (currentChunk()->count == valueStart + 3
+                    && currentChunk()->code[valueStart] == OP_CONSTANT) {
+                    uint16_t arg = (uint16_t)((currentChunk()->code[valueStart + 1] << 8)
+                        | currentChunk()->code[valueStart + 2]);
+                    caseValue = currentChunk()->constants.values[arg];
+                    literal   = IS_NUMBER(caseValue) || IS_STRING(caseValue);
+                }
+
                 emitByte(OP_EQUAL);
                 previousCaseSkip = emitJump(OP_JUMP_IF_FALSE);
 
                 // Pop the comparison result.
                 emitByte(OP_POP);
+
+                if (literal && tableCount < MAX_CASES) {
+                    caseValues[tableCount]  = caseValue;
+                    caseOffsets[tableCount] = currentChunk()->count;
+                    tableCount++;
+                } else {
+                    tableOk = false;
+                }
             } else {
                 state = 2;
                 consume(TOKEN_COLON, "Expect ':' after default.");
                 previousCaseSkip = -1;
+                defaultOffset    = currentChunk()->count;
             }
         } else {
             // Otherwise, it's a statement inside the current case.
@@ -1260,12 +1377,31 @@ static void switchStatement(void)
         emitByte(OP_POP);
     }
 
+    int endOffset = currentChunk()->count;
+
     // Patch all the case jumps to the end.
     for (int i = 0; i < caseCount; i++) {
         patchJump(caseEnds[i]);
     }
 
     emitByte(OP_POP); // The switch value.
+
+    // Every case value was a literal: fill in the table and switch the
+    // dispatch over. The compare chain stays in the chunk but is only
+    // reached when the table is disabled. The first occurrence of a
+    // duplicate value wins, matching chain order.
+    if (tableOk && tableCount >= SWITCH_TABLE_MIN_CASES) {
+        SwitchTable* table   = &currentChunk()->switchTables[switchIndex];
+        table->defaultOffset = defaultOffset >= 0 ? defaultOffset : endOffset;
+        for (int i = 0; i < tableCount; i++) {
+            Value existing;
+            if (!tableGet(&table->offsets, caseValues[i], &existing)) {
+                tableSet(&table->offsets, caseValues[i], NUMBER_VAL(caseOffsets[i]));
+                writeBarrier((Obj*)current->function, caseValues[i]);
+            }
+        }
+        table->enabled = true;
+    }
 }
 
 static void breakStatement(void)
@@ -1358,35 +1494,125 @@ static void forStatement(void)
     int loopStart      = currentChunk()->count;
     current->loopStart = loopStart;
     int exitJump       = -1;
+
+    // Counting-loop candidate: `i < limit` over a local, with the limit a
+    // local or a number constant. Filled in while the clauses are parsed.
+    int      condSlot     = -1;
+    bool     limitIsConst = false;
+    uint16_t limitArg     = 0;
+
     if (!match(TOKEN_SEMICOLON)) {
         expression();
         consume(TOKEN_SEMICOLON, "Expect ';' after loop condition.");
 
+        Chunk* chunk = currentChunk();
+        if (chunk->count == loopStart + 7
+            && chunk->code[loopStart] == OP_GET_LOCAL
+            && chunk->code[loopStart + 6] == OP_LESS) {
+            uint16_t slot = (uint16_t)((chunk->code[loopStart + 1] << 8) | chunk->code[loopStart + 2]);
+            uint16_t arg  = (uint16_t)((chunk->code[loopStart + 4] << 8) | chunk->code[loopStart + 5]);
+            if (chunk->code[loopStart + 3] == OP_GET_LOCAL) {
+                condSlot = slot;
+                limitArg = arg;
+            } else if (chunk->code[loopStart + 3] == OP_CONSTANT
+                && IS_NUMBER(chunk->constants.values[arg])) {
+                condSlot     = slot;
+                limitIsConst = true;
+                limitArg     = arg;
+            }
+        }
+
         // Jump out of the loop if the condition is false.
         exitJump = emitJump(OP_JUMP_IF_FALSE);
         emitByte(OP_POP); // Condition.
     }
 
+    bool fused    = false;
+    int  stubJump = -1;
     if (!match(TOKEN_RIGHT_PAREN)) {
+        int clauseStart    = currentChunk()->count;
         int bodyJump       = emitJump(OP_JUMP);
         int incrementStart = currentChunk()->count;
         expression();
+        int incrementEnd = currentChunk()->count;
         emitByte(OP_POP);
         consume(TOKEN_RIGHT_PAREN, "Expect ')' after for clauses.");
 
-        emitLoop(loopStart);
-        loopStart          = incrementStart;
-        current->loopStart = loopStart;
-        patchJump(bodyJump);
+        // A step of exactly one on the tested local (`i += 1`, `i++`,
+        // `i = i + 1`) fuses with the compare into OP_FOR_LOOP, emitted
+        // after the body instead of the usual increment trampoline.
+        Chunk* chunk   = currentChunk();
+        bool   stepOne = false;
+        if (condSlot != -1) {
+            if (incrementEnd == incrementStart + 7
+                && chunk->code[incrementStart] == OP_GET_LOCAL
+                && chunk->code[incrementStart + 3] == OP_INCREMENT
+                && chunk->code[incrementStart + 4] == OP_SET_LOCAL) {
+                uint16_t getSlot = (uint16_t)((chunk->code[incrementStart + 1] << 8) | chunk->code[incrementStart + 2]);
+                uint16_t setSlot = (uint16_t)((chunk->code[incrementStart + 5] << 8) | chunk->code[incrementStart + 6]);
+                stepOne          = getSlot == condSlot && setSlot == condSlot;
+            } else if (incrementEnd == incrementStart + 10
+                && chunk->code[incrementStart] == OP_GET_LOCAL
+                && chunk->code[incrementStart + 3] == OP_CONSTANT
+                && chunk->code[incrementStart + 6] == OP_ADD
+                && chunk->code[incrementStart + 7] == OP_SET_LOCAL) {
+                uint16_t getSlot = (uint16_t)((chunk->code[incrementStart + 1] << 8) | chunk->code[incrementStart + 2]);
+                uint16_t arg     = (uint16_t)((chunk->code[incrementStart + 4] << 8) | chunk->code[incrementStart + 5]);
+                uint16_t setSlot = (uint16_t)((chunk->code[incrementStart + 8] << 8) | chunk->code[incrementStart + 9]);
+                stepOne          = getSlot == condSlot && setSlot == condSlot
+                    && IS_NUMBER(chunk->constants.values[arg])
+                    && AS_NUMBER(chunk->constants.values[arg]) == 1;
+            }
+        }
+
+        if (stepOne) {
+            // Drop the increment code entirely; OP_FOR_LOOP reproduces it.
+            // The stub is a forward trampoline so continue still reaches
+            // the increment, which now lives after the body.
+            truncateChunk(chunk, clauseStart);
+            int skipStub       = emitJump(OP_JUMP);
+            stubJump           = emitJump(OP_JUMP);
+            current->loopStart = stubJump - 1;
+            patchJump(skipStub);
+            fused = true;
+        } else {
+            emitLoop(loopStart);
+            loopStart          = incrementStart;
+            current->loopStart = loopStart;
+            patchJump(bodyJump);
+        }
     }
 
+    int bodyStart = currentChunk()->count;
+
     current->isInLoop = true;
     statement();
-    emitLoop(loopStart);
 
-    if (exitJump != -1) {
+    if (fused) {
+        patchJump(stubJump);
+        emitByte(OP_FOR_LOOP);
+        emitShort((uint16_t)condSlot);
+        emitByte(limitIsConst ? 1 : 0);
+        emitShort(limitArg);
+
+        int back = currentChunk()->count + 2 - bodyStart;
+        if (back > UINT16_MAX)
+            error("Loop body too large.");
+        emitShort((uint16_t)back);
+
+        // Fall-through exits with nothing on the stack; hop over the POP
+        // that the condition's false path still needs.
+        int doneJump = emitJump(OP_JUMP);
         patchJump(exitJump);
         emitByte(OP_POP); // Condition.
+        patchJump(doneJump);
+    } else {
+        emitLoop(loopStart);
+
+        if (exitJump != -1) {
+            patchJump(exitJump);
+            emitByte(OP_POP); // Condition.
+        }
     }
 
     // patch break jump
@@ -1395,12 +1621,69 @@ static void forStatement(void)
     endScope();
 }
 
+// Classify the condition just compiled into [start, count): 1 if it is a
+// literal that is always truthy, -1 if always falsey, 0 if only known at
+// run time. Matches the VM's isFalsey: only nil and false are falsey.
+static int staticCondition(int start)
+{
+    Chunk* chunk = currentChunk();
+    if (chunk->count == start + 1) {
+        switch (chunk->code[start]) {
+        case OP_TRUE:
+            return 1;
+        case OP_FALSE:
+        case OP_NIL:
+            return -1;
+        default:
+            return 0;
+        }
+    }
+    if (chunk->count == start + 3 && chunk->code[start] == OP_CONSTANT) {
+        // Numbers and strings; both are truthy.
+        return 1;
+    }
+    return 0;
+}
+
+// Compile a statement, then throw its code away. A branch proven dead at
+// compile time still has to parse (and report its errors), but nothing of
+// it may remain: the chunk is rewound and break jumps recorded inside the
+// discarded region are unhooked so they are never patched into live code.
+static void discardStatement(void)
+{
+    int       start      = currentChunk()->count;
+    JumpNode* breakNodes = current->breakNodes;
+
+    statement();
+
+    truncateChunk(currentChunk(), start);
+    current->breakNodes = breakNodes;
+}
+
 static void ifStatement(void)
 {
     consume(TOKEN_LEFT_PAREN, "Expect '(' after 'if'.");
+    int conditionStart = currentChunk()->count;
     expression();
     consume(TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
 
+    // A literal condition decides the branch now: drop the condition,
+    // keep only the live arm, and emit no jump scaffolding at all.
+    int verdict = staticCondition(conditionStart);
+    if (verdict != 0) {
+        truncateChunk(currentChunk(), conditionStart);
+        if (verdict > 0) {
+            statement();
+            if (match(TOKEN_ELSE))
+                discardStatement();
+        } else {
+            discardStatement();
+            if (match(TOKEN_ELSE))
+                statement();
+        }
+        return;
+    }
+
     int thenJump = emitJump(OP_JUMP_IF_FALSE);
     emitByte(OP_POP);
     statement();
@@ -1441,8 +1724,21 @@ static void returnStatement(void)
             error("Can't return a value from an initializer.");
         }
 
+        int exprStart = currentChunk()->count;
         expression();
         consume(TOKEN_SEMICOLON, "Expect ';' after return value.");
+
+        // A call whose result is returned directly is a tail call; the
+        // VM reuses the current frame for it instead of pushing one.
+        Chunk* chunk = currentChunk();
+        int    last  = exprStart;
+        for (int scan = exprStart; scan < chunk->count; scan = moveForward(chunk, scan)) {
+            last = scan;
+        }
+        if (chunk->code[last] == OP_CALL) {
+            chunk->code[last] = OP_TAIL_CALL;
+        }
+
         emitByte(OP_RETURN);
     }
 }
@@ -1521,31 +1817,34 @@ static void statement(void)
 
 static void optimizeBinaryConst(Chunk* chunk, int* index)
 {
-    Value*   constants = chunk->constants.values;
-    uint8_t* code      = chunk->code;
+    uint8_t* code = chunk->code;
 
     uint16_t arg1 = (code[*index + 1] << 8) | code[*index + 2];
     uint16_t arg2 = (code[*index + 4] << 8) | code[*index + 5];
 
-#define BINARY_OP(op)                                 \
-    {                                                 \
-        double b        = AS_NUMBER(constants[arg2]); \
-        double a        = AS_NUMBER(constants[arg1]); \
-        constants[arg1] = NUMBER_VAL(a op b);         \
+    // Constant slots are shared between load sites, so the folded value
+    // gets a fresh slot instead of clobbering arg1 in place.
+    Value result = NIL_VAL;
+
+#define BINARY_OP(op)                                              \
+    {                                                              \
+        double b = AS_NUMBER(chunk->constants.values[arg2]);       \
+        double a = AS_NUMBER(chunk->constants.values[arg1]);       \
+        result   = NUMBER_VAL(a op b);                             \
     }
 
-#define BINARY_OP_INT(op)                                  \
-    {                                                      \
-        int b           = (int)AS_NUMBER(constants[arg2]); \
-        int a           = (int)AS_NUMBER(constants[arg1]); \
-        constants[arg1] = NUMBER_VAL(a op b);              \
+#define BINARY_OP_INT(op)                                          \
+    {                                                              \
+        int b  = (int)AS_NUMBER(chunk->constants.values[arg2]);    \
+        int a  = (int)AS_NUMBER(chunk->constants.values[arg1]);    \
+        result = NUMBER_VAL(a op b);                               \
     }
 
-#define BINARY_OP_BOOL(op)                            \
-    {                                                 \
-        double b        = AS_NUMBER(constants[arg2]); \
-        double a        = AS_NUMBER(constants[arg1]); \
-        constants[arg1] = BOOL_VAL(a op b);           \
+#define BINARY_OP_BOOL(op)                                         \
+    {                                                              \
+        double b = AS_NUMBER(chunk->constants.values[arg2]);       \
+        double a = AS_NUMBER(chunk->constants.values[arg1]);       \
+        result   = BOOL_VAL(a op b);                               \
     }
 
     switch (chunk->code[*index + 6]) {
@@ -1589,14 +1888,141 @@ static void optimizeBinaryConst(Chunk* chunk, int* index)
         break;
     }
 
+    int folded        = addConstant(chunk, result);
+    code[*index + 1]  = (uint8_t)(folded >> 8);
+    code[*index + 2]  = (uint8_t)(folded & 0xff);
+
     remiteBytes(chunk, *index + 3, 4);
 }
 
-void optimizeChunk(Chunk* chunk)
+static bool jumpsInto(int* dests, int destCount, int start, int end)
+{
+    for (int* dest = dests; dest < dests + destCount; dest++) {
+        if (*dest > start && *dest < end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Superinstruction fusion. Every fused encoding is byte-for-byte the same
+// size as the sequence it replaces (trailing bytes become padding the
+// dispatch loop skips), so jump offsets and the line array stay valid and
+// no relocation is needed.
+static void fuseSuperinstructions(Chunk* chunk)
 {
     Value*   constants = chunk->constants.values;
     uint8_t* code      = chunk->code;
 
+    // collect jump destinations; fusing across one would break it
+    int destCount = 0;
+    for (int i = 0; i < chunk->count;) {
+        uint8_t instruction = code[i];
+        if (instruction == OP_JUMP || instruction == OP_JUMP_IF_FALSE || instruction == OP_LOOP) {
+            destCount++;
+        }
+        i = moveForward(chunk, i);
+    }
+
+    int dests[destCount];
+    memset(dests, 0, sizeof(dests));
+
+    int destIndex = 0;
+    for (int i = 0; i < chunk->count;) {
+        uint8_t instruction = code[i];
+        if (instruction == OP_JUMP || instruction == OP_JUMP_IF_FALSE) {
+            uint16_t target    = (uint16_t)((code[i + 1] << 8) | code[i + 2]);
+            dests[destIndex++] = i + 3 + target;
+        } else if (instruction == OP_LOOP) {
+            uint16_t target    = (uint16_t)((code[i + 1] << 8) | code[i + 2]);
+            dests[destIndex++] = i + 3 - target;
+        }
+        i = moveForward(chunk, i);
+    }
+
+    for (int i = 0; i < chunk->count;) {
+        int movement = moveForward(chunk, i);
+
+        switch (code[i]) {
+        case OP_GET_LOCAL: {
+            // GET_LOCAL slot; CONSTANT k; ADD (7 bytes)
+            if (i + 7 <= chunk->count && code[i + 3] == OP_CONSTANT && code[i + 6] == OP_ADD
+                && !jumpsInto(dests, destCount, i, i + 7)) {
+                uint16_t arg = (uint16_t)((code[i + 4] << 8) | code[i + 5]);
+                if (IS_NUMBER(constants[arg])) {
+                    code[i]     = OP_GET_LOCAL_CONSTANT_ADD;
+                    code[i + 3] = arg >> 8;
+                    code[i + 4] = arg & 0xff;
+                    i += 7;
+                    continue;
+                }
+            }
+            break;
+        }
+        case OP_LESS: {
+            // LESS; JUMP_IF_FALSE offset (4 bytes)
+            if (i + 4 <= chunk->count && code[i + 1] == OP_JUMP_IF_FALSE
+                && !jumpsInto(dests, destCount, i, i + 4)) {
+                code[i]     = OP_LESS_JUMP_IF_FALSE;
+                code[i + 1] = code[i + 2];
+                code[i + 2] = code[i + 3];
+                i += 4;
+                continue;
+            }
+            break;
+        }
+        case OP_CONSTANT: {
+            // CONSTANT k; CALL argc (6 bytes)
+            if (i + 6 <= chunk->count && code[i + 3] == OP_CALL
+                && !jumpsInto(dests, destCount, i, i + 6)) {
+                code[i]     = OP_CONSTANT_CALL;
+                code[i + 3] = code[i + 4];
+                code[i + 4] = code[i + 5];
+                i += 6;
+                continue;
+            }
+            break;
+        }
+        case OP_INCREMENT: {
+            // INCREMENT; SET_LOCAL slot; POP (5 bytes)
+            if (i + 5 <= chunk->count && code[i + 1] == OP_SET_LOCAL && code[i + 4] == OP_POP
+                && !jumpsInto(dests, destCount, i, i + 5)) {
+                code[i]     = OP_INCREMENT_SET_LOCAL_POP;
+                code[i + 1] = code[i + 2];
+                code[i + 2] = code[i + 3];
+                i += 5;
+                continue;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        i = movement;
+    }
+}
+
+void optimizeChunk(Chunk* chunk)
+{
+    uint8_t* code = chunk->code;
+
+    // The byte-removing rewrites below (and fusing across case bodies)
+    // would invalidate the absolute offsets an enabled switch jump table
+    // holds; leave such chunks exactly as emitted.
+    for (int t = 0; t < chunk->switchTableCount; t++) {
+        if (chunk->switchTables[t].enabled)
+            return;
+    }
+
+    // Likewise OP_FOR_LOOP: its back edge isn't in the jump bookkeeping
+    // here, so shifting bytes under it would corrupt the loop.
+    for (int i = 0; i < chunk->count;) {
+        if (code[i] == OP_FOR_LOOP)
+            return;
+        i = moveForward(chunk, i);
+    }
+
     int passes = 0;
     int folds  = 0;
 
@@ -1662,10 +2088,17 @@ void optimizeChunk(Chunk* chunk)
                 case OP_SHIFT_RIGHT:
                 case OP_LESS:
                 case OP_GREATER:
-                    if (IS_NUMBER(constants[arg1]) && IS_NUMBER(constants[arg2])) {
+                    // Re-read the array each time; folding appends and
+                    // may reallocate it.
+                    if (IS_NUMBER(chunk->constants.values[arg1])
+                        && IS_NUMBER(chunk->constants.values[arg2])) {
                         optimizeBinaryConst(chunk, &i);
                         folds++;
                         currentAdjustment += 4;
+                    } else {
+                        // Non-numeric operands (string + string) can't
+                        // fold; step past or the scan never advances.
+                        i = movement;
                     }
                     break;
                 default:
@@ -1991,6 +2424,8 @@ void optimizeChunk(Chunk* chunk)
     UNUSED(folds);
     // printf("Optimization Passes: %d\n", passes);
     // printf("Constant Folds: %d\n", folds);
+
+    fuseSuperinstructions(chunk);
 }
 
 ObjFunction* compile(const char* sourcePath, utf8_int8_t* source)
@@ -2010,7 +2445,11 @@ ObjFunction* compile(const char* sourcePath, utf8_int8_t* source)
 
     ObjFunction* function = endCompiler();
 #ifdef CHUNK_OPTIMIZATION
+    // Folding appends constants and can collect; the finished function is
+    // no longer on the compiler chain, so root it across the pass.
+    push(OBJ_VAL(function));
     optimizeChunk(&function->chunk);
+    pop();
 #endif
     // exit(1);
     function->source = sourcePath;
@@ -57,23 +57,6 @@ static int constantInstruction(const char* name, Chunk* chunk, int offset)
     return offset + 3;
 }
 
-static int constantInstructionCompound(const char* name, Chunk* chunk, int offset, int length)
-{
-    printf("%-16s ", name);
-
-    for (int i = 0; i < length; i++) {
-        uint16_t constant = (uint16_t)(chunk->code[offset + 1 + (i * 2)] << 8);
-        constant |= chunk->code[offset + 2 + (i * 2)];
-        printf("%4d '", constant);
-        printValue(chunk->constants.values[constant]);
-        printf("'");
-    }
-
-    printf("\n");
-
-    return offset + 1 + (length * 2);
-}
-
 static int shortInstructionCompound(const char* name, Chunk* chunk, int offset, int length)
 {
     printf("%-16s ", name);
@@ -101,6 +84,32 @@ static int invokeInstruction(const char* name, Chunk* chunk, int offset)
     return offset + 5;
 }
 
+static int cachedConstantInstruction(const char* name, Chunk* chunk, int offset)
+{
+    uint16_t constant = (uint16_t)(chunk->code[offset + 1] << 8);
+    constant |= chunk->code[offset + 2];
+    uint16_t cache = (uint16_t)(chunk->code[offset + 3] << 8);
+    cache |= chunk->code[offset + 4];
+    printf("%-16s %4d '", name, constant);
+    printValue(chunk->constants.values[constant]);
+    printf("' (cache %d)\n", cache);
+    return offset + 5;
+}
+
+static int cachedInvokeInstruction(const char* name, Chunk* chunk, int offset)
+{
+    uint16_t constant = (uint16_t)(chunk->code[offset + 1] << 8);
+    constant |= chunk->code[offset + 2];
+    uint16_t argCount = (uint16_t)(chunk->code[offset + 3] << 8);
+    argCount |= chunk->code[offset + 4];
+    uint16_t cache = (uint16_t)(chunk->code[offset + 5] << 8);
+    cache |= chunk->code[offset + 6];
+    printf("%-16s (%d args) %4d '", name, argCount, constant);
+    printValue(chunk->constants.values[constant]);
+    printf("' (cache %d)\n", cache);
+    return offset + 7;
+}
+
 static int simpleInstruction(const char* name, int offset)
 {
     printf("%s\n", name);
@@ -130,6 +139,46 @@ static int jumpInstruction(const char* name, int sign, Chunk* chunk, int offset)
     return offset + 3;
 }
 
+static int localConstantAddInstruction(const char* name, Chunk* chunk, int offset)
+{
+    uint16_t slot = (uint16_t)(chunk->code[offset + 1] << 8);
+    slot |= chunk->code[offset + 2];
+    uint16_t constant = (uint16_t)(chunk->code[offset + 3] << 8);
+    constant |= chunk->code[offset + 4];
+    printf("%-16s %4d %4d '", name, slot, constant);
+    printValue(chunk->constants.values[constant]);
+    printf("'\n");
+    return offset + 7;
+}
+
+static int lessJumpInstruction(const char* name, Chunk* chunk, int offset)
+{
+    uint16_t jump = (uint16_t)(chunk->code[offset + 1] << 8);
+    jump |= chunk->code[offset + 2];
+    printf("%-16s %4d -> %d\n", name, offset, offset + 4 + jump);
+    return offset + 4;
+}
+
+static int constantCallInstruction(const char* name, Chunk* chunk, int offset)
+{
+    uint16_t constant = (uint16_t)(chunk->code[offset + 1] << 8);
+    constant |= chunk->code[offset + 2];
+    uint16_t argCount = (uint16_t)(chunk->code[offset + 3] << 8);
+    argCount |= chunk->code[offset + 4];
+    printf("%-16s (%d args) %4d '", name, argCount, constant);
+    printValue(chunk->constants.values[constant]);
+    printf("'\n");
+    return offset + 6;
+}
+
+static int incrementLocalInstruction(const char* name, Chunk* chunk, int offset)
+{
+    uint16_t slot = (uint16_t)(chunk->code[offset + 1] << 8);
+    slot |= chunk->code[offset + 2];
+    printf("%-16s %4d\n", name, slot);
+    return offset + 5;
+}
+
 int disassembleInstruction(Chunk* chunk, int offset, bool flow)
 {
     OpCode instruction   = chunk->code[offset];
@@ -304,8 +353,8 @@ int disassembleInstruction(Chunk* chunk, int offset, bool flow)
         }
     }
 
-    int line = AS_NUMBER(chunk->lines.values[offset]);
-    int prev = AS_NUMBER(chunk->lines.values[offset - 1]);
+    int line = getLine(chunk, offset);
+    int prev = getLine(chunk, offset - 1);
 
     if (offset > 0 && line == prev) {
         printf("   | ");
@@ -336,6 +385,12 @@ int disassembleInstruction(Chunk* chunk, int offset, bool flow)
         return simpleInstruction("OP_LESS", offset);
     case OP_ADD:
         return simpleInstruction("OP_ADD", offset);
+    case OP_ADD_NUMBER:
+        return simpleInstruction("OP_ADD_NUMBER", offset);
+    case OP_ADD_STRING:
+        return simpleInstruction("OP_ADD_STRING", offset);
+    case OP_ADD_DUNDER:
+        return simpleInstruction("OP_ADD_DUNDER", offset);
     case OP_SUBTRACT:
         return simpleInstruction("OP_SUBTRACT", offset);
     case OP_MULTIPLY:
@@ -362,6 +417,14 @@ int disassembleInstruction(Chunk* chunk, int offset, bool flow)
         return simpleInstruction("OP_INCREMENT", offset);
     case OP_DECREMENT:
         return simpleInstruction("OP_DECREMENT", offset);
+    case OP_GET_LOCAL_CONSTANT_ADD:
+        return localConstantAddInstruction("OP_GET_LOCAL_CONSTANT_ADD", chunk, offset);
+    case OP_LESS_JUMP_IF_FALSE:
+        return lessJumpInstruction("OP_LESS_JUMP_IF_FALSE", chunk, offset);
+    case OP_CONSTANT_CALL:
+        return constantCallInstruction("OP_CONSTANT_CALL", chunk, offset);
+    case OP_INCREMENT_SET_LOCAL_POP:
+        return incrementLocalInstruction("OP_INCREMENT_SET_LOCAL_POP", chunk, offset);
     case OP_POP:
         return simpleInstruction("OP_POP", offset);
     case OP_POP_N:
@@ -385,31 +448,42 @@ int disassembleInstruction(Chunk* chunk, int offset, bool flow)
     case OP_SET_LOCAL_4:
         return shortInstructionCompound("OP_SET_LOCAL_4", chunk, offset, 4);
     case OP_GET_GLOBAL:
-        return constantInstruction("OP_GET_GLOBAL", chunk, offset);
+        return shortInstruction("OP_GET_GLOBAL", chunk, offset);
     case OP_GET_GLOBAL_2:
-        return constantInstructionCompound("OP_GET_GLOBAL_2", chunk, offset, 2);
+        return shortInstructionCompound("OP_GET_GLOBAL_2", chunk, offset, 2);
     case OP_GET_GLOBAL_3:
-        return constantInstructionCompound("OP_GET_GLOBAL_3", chunk, offset, 3);
+        return shortInstructionCompound("OP_GET_GLOBAL_3", chunk, offset, 3);
     case OP_GET_GLOBAL_4:
-        return constantInstructionCompound("OP_GET_GLOBAL_4", chunk, offset, 4);
+        return shortInstructionCompound("OP_GET_GLOBAL_4", chunk, offset, 4);
     case OP_DEFINE_GLOBAL:
-        return constantInstruction("OP_DEFINE_GLOBAL", chunk, offset);
+        return shortInstruction("OP_DEFINE_GLOBAL", chunk, offset);
     case OP_SET_GLOBAL:
-        return constantInstruction("OP_SET_GLOBAL", chunk, offset);
+        return shortInstruction("OP_SET_GLOBAL", chunk, offset);
     case OP_GET_UPVALUE:
         return shortInstruction("OP_GET_UPVALUE", chunk, offset);
     case OP_SET_UPVALUE:
         return shortInstruction("OP_SET_UPVALUE", chunk, offset);
     case OP_GET_PROPERTY:
-        return constantInstruction("OP_GET_PROPERTY", chunk, offset);
+        return cachedConstantInstruction("OP_GET_PROPERTY", chunk, offset);
     case OP_SET_PROPERTY:
-        return constantInstruction("OP_SET_PROPERTY", chunk, offset);
+        return cachedConstantInstruction("OP_SET_PROPERTY", chunk, offset);
     case OP_GET_SUPER:
         return constantInstruction("OP_GET_SUPER", chunk, offset);
     case OP_SET_TABLE:
         return shortInstruction("OP_SET_TABLE", chunk, offset);
     case OP_SET_ARRAY:
         return shortInstruction("OP_SET_ARRAY", chunk, offset);
+    case OP_SWITCH:
+        return shortInstruction("OP_SWITCH", chunk, offset);
+    case OP_FOR_LOOP: {
+        uint16_t slot    = (uint16_t)((chunk->code[offset + 1] << 8) | chunk->code[offset + 2]);
+        uint8_t  isConst = chunk->code[offset + 3];
+        uint16_t limit   = (uint16_t)((chunk->code[offset + 4] << 8) | chunk->code[offset + 5]);
+        uint16_t back    = (uint16_t)((chunk->code[offset + 6] << 8) | chunk->code[offset + 7]);
+        printf("%-16s %4d %s %4d -> %d\n", "OP_FOR_LOOP", slot,
+            isConst ? "const" : "local", limit, offset + 8 - back);
+        return offset + 8;
+    }
     case OP_JUMP:
         return jumpInstruction("OP_JUMP", 1, chunk, offset);
     case OP_FORMAT:
@@ -424,17 +498,21 @@ int disassembleInstruction(Chunk* chunk, int offset, bool flow)
         return shortInstruction("OP_CALL", chunk, offset);
     case OP_CALL_BLIND:
         return shortInstruction("OP_CALL_BLIND", chunk, offset);
+    case OP_TAIL_CALL:
+        return shortInstruction("OP_TAIL_CALL", chunk, offset);
     case OP_INDEX:
         return simpleInstruction("OP_INDEX", offset);
     case OP_SET_INDEX:
         return simpleInstruction("OP_SET_INDEX", offset);
     case OP_INVOKE:
-        return invokeInstruction("OP_INVOKE", chunk, offset);
+        return cachedInvokeInstruction("OP_INVOKE", chunk, offset);
     case OP_SUPER_INVOKE:
         return invokeInstruction("OP_SUPER_INVOKE", chunk, offset);
     case OP_CLOSURE: {
         offset++;
-        uint8_t constant = chunk->code[offset++];
+        uint16_t constant = (uint16_t)(chunk->code[offset] << 8);
+        constant |= chunk->code[offset + 1];
+        offset += 2;
         printf("%-16s %4d ", "OP_CLOSURE", constant);
         printValue(chunk->constants.values[constant]);
         printf("\n");
@@ -442,9 +520,10 @@ int disassembleInstruction(Chunk* chunk, int offset, bool flow)
         ObjFunction* function = AS_FUNCTION(chunk->constants.values[constant]);
         for (int j = 0; j < function->upvalueCount; j++) {
             int isLocal = chunk->code[offset++];
-            int index   = chunk->code[offset++];
+            int index   = (chunk->code[offset] << 8) | chunk->code[offset + 1];
+            offset += 2;
             printf("%04d      |                     %s %d\n",
-                offset - 2, isLocal ? "local" : "upvalue", index);
+                offset - 3, isLocal ? "local" : "upvalue", index);
         }
 
         return offset;
@@ -497,6 +576,9 @@ int moveForward(Chunk* chunk, int offset)
     case OP_LESS:
         return offset + 1;
     case OP_ADD:
+    case OP_ADD_NUMBER:
+    case OP_ADD_STRING:
+    case OP_ADD_DUNDER:
         return offset + 1;
     case OP_SUBTRACT:
         return offset + 1;
@@ -520,6 +602,14 @@ int moveForward(Chunk* chunk, int offset)
         return offset + 1;
     case OP_DECREMENT:
         return offset + 1;
+    case OP_GET_LOCAL_CONSTANT_ADD:
+        return offset + 7;
+    case OP_LESS_JUMP_IF_FALSE:
+        return offset + 4;
+    case OP_CONSTANT_CALL:
+        return offset + 6;
+    case OP_INCREMENT_SET_LOCAL_POP:
+        return offset + 5;
     case OP_NOT:
         return offset + 1;
     case OP_NEGATE:
@@ -561,15 +651,19 @@ int moveForward(Chunk* chunk, int offset)
     case OP_SET_UPVALUE:
         return offset + 3;
     case OP_GET_PROPERTY:
-        return offset + 3;
+        return offset + 5;
     case OP_SET_PROPERTY:
-        return offset + 3;
+        return offset + 5;
     case OP_GET_SUPER:
         return offset + 3;
     case OP_SET_TABLE:
         return offset + 3;
     case OP_SET_ARRAY:
         return offset + 3;
+    case OP_SWITCH:
+        return offset + 3;
+    case OP_FOR_LOOP:
+        return offset + 8;
     case OP_JUMP:
         return offset + 3;
     case OP_FORMAT:
@@ -584,21 +678,24 @@ int moveForward(Chunk* chunk, int offset)
         return offset + 3;
     case OP_CALL_BLIND:
         return offset + 3;
+    case OP_TAIL_CALL:
+        return offset + 3;
     case OP_INDEX:
         return offset + 1;
     case OP_SET_INDEX:
         return offset + 1;
     case OP_INVOKE:
-        return offset + 5;
+        return offset + 7;
     case OP_SUPER_INVOKE:
         return offset + 5;
     case OP_CLOSURE: {
         offset++;
-        uint8_t      constant = chunk->code[offset++];
+        uint16_t constant = (uint16_t)(chunk->code[offset] << 8);
+        constant |= chunk->code[offset + 1];
+        offset += 2;
         ObjFunction* function = AS_FUNCTION(chunk->constants.values[constant]);
         for (int j = 0; j < function->upvalueCount; j++) {
-            offset++; // isLocal
-            offset++; // index
+            offset += 3; // isLocal + 16-bit index
         }
         return offset;
     }
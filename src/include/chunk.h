@@ -2,6 +2,7 @@
 #define phelt_chunk_h
 
 #include "common.h"
+#include "table.h"
 #include "value.h"
 
 typedef enum {
@@ -10,19 +11,65 @@ typedef enum {
 #undef OPCODE
 } OpCode;
 
+#define CACHE_ENTRIES 2
+
+// One entry of a per-call-site inline cache. klass is NULL while empty.
+typedef struct
+{
+    Obj*  klass;
+    Value value;
+} CacheEntry;
+
+typedef struct
+{
+    CacheEntry entries[CACHE_ENTRIES];
+} InlineCache;
+
+// One run of line information: every code byte from start until the next
+// run's start was emitted for this source line. Runs are sorted by start,
+// so a lookup is a binary search instead of an 8-byte entry per code byte.
+typedef struct
+{
+    int line;
+    int start;
+} LineRun;
+
+// Jump table for a switch whose case values are all literals: offsets maps
+// each case value to the code offset of its body, defaultOffset is where a
+// miss lands. OP_SWITCH does one hash lookup instead of walking the compare
+// chain; a table left disabled makes OP_SWITCH a no-op and the chain runs.
+typedef struct
+{
+    bool  enabled;
+    int   defaultOffset;
+    Table offsets;
+} SwitchTable;
+
 typedef struct
 {
-    int        count;
-    int        capacity;
-    uint8_t*   code;
-    ValueArray lines;
-    ValueArray constants;
+    int          count;
+    int          capacity;
+    uint8_t*     code;
+    int          cacheCount;
+    int          cacheCapacity;
+    InlineCache* caches;
+    int          switchTableCount;
+    int          switchTableCapacity;
+    SwitchTable* switchTables;
+    LineRun*     lineRuns;
+    int          lineRunCount;
+    int          lineRunCapacity;
+    ValueArray   constants;
 } Chunk;
 
 void initChunk(Chunk* chunk);
 void writeChunk(Chunk* chunk, uint8_t byte, int line);
+void truncateChunk(Chunk* chunk, int count);
 void remiteBytes(Chunk* chunk, int index, int amount);
 int  addConstant(Chunk* chunk, Value value);
+int  getLine(Chunk* chunk, int offset);
+int  addCache(Chunk* chunk);
+int  addSwitchTable(Chunk* chunk);
 void freeChunk(Chunk* chunk);
 
 #endif
@@ -5,12 +5,15 @@
 // #define DEBUG_TRACE_EXECUTION
 // #define DEBUG_STRESS_GC
 // #define DEBUG_LOG_GC
+// #define DEBUG_DISPATCH_STATS
 
 #define NAN_BOXING
+#define BASELINE_JIT
 #define UINT8_COUNT (UINT8_MAX + 1)
 #define UINT16_COUNT (UINT16_MAX + 1)
 #define COMPUTED_GOTO
 #define CHUNK_OPTIMIZATION
+#define CHUNK_CACHE
 
 #define TEMPLATE_BUFFER 1024
 
@@ -25,6 +28,7 @@
 
 utf8_int8_t* readFile(const char* path);
 bool         fileExists(const char* path);
+const char*  ensureExtension(const char* path, const char* extension);
 const char*  resolvePath(const char* path);
 const char*  getFilePath(const char* path);
 const char*  resolveRelativePath(const char* path, const char* currentFile);
@@ -8,6 +8,10 @@
 
 #define MAX_CASES 256
 
+// Minimum literal case count before a switch gets a jump table; below
+// this the compare chain is at least as fast as a hash lookup.
+#define SWITCH_TABLE_MIN_CASES 4
+
 ObjFunction* compile(const char* sourcePath, utf8_int8_t* source);
 void         markCompilerRoots(void);
 
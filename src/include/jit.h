@@ -0,0 +1,62 @@
+#ifndef phelt_jit_h
+#define phelt_jit_h
+
+#include "common.h"
+#include "object.h"
+#include "value.h"
+
+// Baseline template JIT. Functions that cross JIT_THRESHOLD entries plus
+// loop back-edges get their chunk translated to native code one opcode at a
+// time: stack traffic, locals and jumps are emitted inline, arithmetic and
+// comparisons call small helpers that mirror the interpreter's fast paths,
+// and everything else (calls, allocations, property access) becomes a deopt
+// site that hands the exact bytecode offset back to the interpreter. The
+// translated subset never allocates, so jitted code needs no GC safepoints;
+// any opcode that could collect deopts first. The VM stack is the JIT's
+// stack, kept in a register and flushed on exit, which makes deopt free:
+// the interpreter just resumes at the returned offset.
+//
+// Translation currently targets x86-64 with NaN boxing; elsewhere (and in
+// tracing or dispatch-stats builds, which want to observe every opcode) the
+// hooks compile away.
+#if defined(BASELINE_JIT) && defined(__x86_64__) && defined(NAN_BOXING) \
+    && !defined(DEBUG_TRACE_EXECUTION) && !defined(DEBUG_DISPATCH_STATS)
+#define JIT_AVAILABLE
+#endif
+
+#define JIT_THRESHOLD 256
+
+// ObjFunction.jit holds NULL (cold), JIT_REJECTED (translation attempted
+// and declined), or a JitCode the interpreter may enter at function start.
+#define JIT_REJECTED ((JitCode*)(uintptr_t)1)
+
+struct JitCode {
+    void*  code; // executable mapping, entered at offset 0
+    size_t size;
+};
+
+void jitCompile(ObjFunction* function);
+void jitFree(ObjFunction* function);
+
+// Runs the translation from the top of the function with the frame's slots
+// and the live stack top; returns the bytecode offset the interpreter
+// should resume from.
+int jitEnter(ObjFunction* function, Value* slots, Value** stackTop);
+
+static inline bool jitReady(JitCode* jit)
+{
+    return (uintptr_t)jit > (uintptr_t)JIT_REJECTED;
+}
+
+static inline void jitCountHot(ObjFunction* function)
+{
+#ifdef JIT_AVAILABLE
+    if (function->jit == NULL && ++function->hotness == JIT_THRESHOLD) {
+        jitCompile(function);
+    }
+#else
+    UNUSED(function);
+#endif
+}
+
+#endif
@@ -19,9 +19,29 @@
 #define FREE_ARRAY(type, pointer, oldCount) \
     reallocate(pointer, sizeof(type) * (oldCount), 0)
 
+// Collector telemetry for this thread's VM (debug.gcStats): cumulative
+// per-phase timings in nanoseconds and stop-the-world pause tracking.
+typedef struct {
+    uint64_t minorCollections;
+    uint64_t majorCollections;
+    uint64_t markNs;
+    uint64_t traceNs;
+    uint64_t sweepNs;
+    uint64_t totalPauseNs;
+    uint64_t maxPauseNs;
+} GcStats;
+
+const GcStats* gcStats(void);
+
+// Shallow heap census (debug.heapSnapshot): object counts and bytes grouped
+// by type, and instances additionally grouped by class name.
+void heapSnapshot(FILE* out);
+
 void* reallocate(void* pointer, size_t oldSize, size_t newSize);
 void  markObject(Obj* object);
 void  markValue(Value value);
+void  writeBarrier(Obj* owner, Value value);
+void  markWrite(Value value);
 void  collectGarbage(void);
 void  freeObjects(void);
 
@@ -16,5 +16,8 @@ extern bool array_map(int argCount, Value* args);
 extern bool array_filter(int argCount, Value* args);
 extern bool array_reduce(int argCount, Value* args);
 extern bool array_flatten(int argCount, Value* args);
+extern bool array_pmap(int argCount, Value* args);
+extern bool array_pfilter(int argCount, Value* args);
+extern bool array_preduce(int argCount, Value* args);
 
 #endif
@@ -4,5 +4,10 @@
 #include "native.h"
 
 bool debug_frame(int argCount, Value* args);
+bool debug_profileStart(int argCount, Value* args);
+bool debug_dispatchStats(int argCount, Value* args);
+bool debug_gcStats(int argCount, Value* args);
+bool debug_heapSnapshot(int argCount, Value* args);
+bool debug_profileStop(int argCount, Value* args);
 
 #endif
@@ -9,6 +9,9 @@ extern bool file_mkstemps(int argCount, Value* args);
 extern bool file_close(int argCount, Value* args);
 extern bool file_write(int argCount, Value* args);
 extern bool file_read(int argCount, Value* args);
+extern bool file_mmap(int argCount, Value* args);
+extern bool file_lines(int argCount, Value* args);
+extern bool file_nextLine(int argCount, Value* args);
 extern bool file_seek(int argCount, Value* args);
 extern bool file_tell(int argCount, Value* args);
 extern bool file_flush(int argCount, Value* args);
@@ -19,6 +22,6 @@ extern bool file_putc(int argCount, Value* args);
 extern bool file_remove(int argCount, Value* args);
 extern bool file_rename(int argCount, Value* args);
 
-extern void fileCallback(Table* table);
+extern void fileCallback(ObjTable* table);
 
 #endif
@@ -10,5 +10,6 @@ extern bool http_patch(int argCount, Value* args);
 extern bool http_delete(int argCount, Value* args);
 extern bool http_head(int argCount, Value* args);
 extern bool http_options(int argCount, Value* args);
+extern bool http_batch(int argCount, Value* args);
 
 #endif
@@ -0,0 +1,16 @@
+#ifndef PHELT_NATIVE_LOOP_H
+#define PHELT_NATIVE_LOOP_H
+
+#include "native.h"
+
+extern bool loop_timer(int argCount, Value* args);
+extern bool loop_readFile(int argCount, Value* args);
+extern bool loop_fetch(int argCount, Value* args);
+extern bool loop_pending(int argCount, Value* args);
+extern bool loop_run(int argCount, Value* args);
+
+// Called from markRoots: pending callbacks live in C structs between
+// ticks, invisible to the collector without this.
+void markLoopRoots(void);
+
+#endif
@@ -23,6 +23,11 @@ extern bool math_norm(int argCount, Value* args);
 extern bool math_seed(int argCount, Value* args);
 extern bool math_rand(int argCount, Value* args);
 extern bool math_round(int argCount, Value* args);
-extern void mathCallback(Table* table);
+extern bool math_sum(int argCount, Value* args);
+extern bool math_dot(int argCount, Value* args);
+extern bool math_scale(int argCount, Value* args);
+extern bool math_minmax(int argCount, Value* args);
+extern bool math_apply(int argCount, Value* args);
+extern void mathCallback(ObjTable* table);
 
 #endif
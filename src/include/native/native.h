@@ -11,10 +11,12 @@
 #include "native/file.h"
 #include "native/http.h"
 #include "native/json.h"
+#include "native/loop.h"
 #include "native/math.h"
 #include "native/string.h"
 #include "native/system.h"
 #include "native/table.h"
+#include "native/worker.h"
 
 typedef struct {
     const char* name;
@@ -28,7 +30,7 @@ typedef struct {
 
 typedef struct {
     const char* name;
-    void (*callback)(Table*);
+    void (*callback)(ObjTable*);
 } NativeModuleCallback;
 
 extern NativeFnEntry        globalFns[];
@@ -0,0 +1,13 @@
+#ifndef PHELT_NATIVE_WORKER_H
+#define PHELT_NATIVE_WORKER_H
+
+#include "native.h"
+
+extern bool worker_spawn(int argCount, Value* args);
+extern bool worker_send(int argCount, Value* args);
+extern bool worker_receive(int argCount, Value* args);
+extern bool worker_reply(int argCount, Value* args);
+extern bool worker_take(int argCount, Value* args);
+extern bool worker_join(int argCount, Value* args);
+
+#endif
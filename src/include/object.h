@@ -25,7 +25,7 @@
 #define AS_INSTANCE(value) ((ObjInstance*)AS_OBJ(value))
 #define AS_NATIVE(value) (((ObjNative*)AS_OBJ(value))->function)
 #define AS_STRING(value) ((ObjString*)AS_OBJ(value))
-#define AS_CSTRING(value) (((ObjString*)AS_OBJ(value))->chars)
+#define AS_CSTRING(value) (stringChars((ObjString*)AS_OBJ(value)))
 #define AS_TABLE(value) ((ObjTable*)AS_OBJ(value))
 #define AS_ARRAY(value) ((ObjArray*)AS_OBJ(value))
 
@@ -40,19 +40,55 @@ typedef enum {
     OBJ_UPVALUE,
     OBJ_TABLE,
     OBJ_ARRAY,
+    OBJ_SHAPE,
 } ObjType;
 
+// Packed header: the type tag and GC bits share a single word. The heap is
+// tracked externally in the VM's object registry, so objects carry no list
+// pointer of their own.
 struct Obj {
-    ObjType     type;
-    bool        isMarked;
-    struct Obj* next;
+    ObjType type : 8;
+    bool    isMarked : 1;
+    // Generation bits: objects start young and are promoted once they
+    // survive a collection. isRemembered flags old objects sitting in the
+    // remembered set because a young pointer was stored into them.
+    bool    isOld : 1;
+    bool    isRemembered : 1;
 };
 
+// Growable append buffer shared by the string headers produced along one
+// concatenation chain. Every header is an immutable prefix of data; only
+// the longest prefix (the tip, length == used) is ever extended, so older
+// prefixes stay byte-stable. refs counts the headers pointing in.
+typedef struct {
+    int  capacity;
+    int  used;
+    int  refs;
+    char data[];
+} StringBuffer;
+
 struct ObjString {
     Obj      obj;
     int      length;
     char*    chars;
     uint32_t hash;
+    // Concatenation results point into a shared StringBuffer and defer
+    // both interning and hashing; ordinary strings have a NULL buffer,
+    // sit in vm.strings and carry their hash from birth.
+    StringBuffer* buffer;
+    bool          interned;
+    bool          hashed;
+    // True when every byte is plain ASCII, so byte offsets and codepoint
+    // indexes coincide and indexing needs no UTF-8 walk.
+    bool ascii;
+    // True when chars points into a read-only file mapping (file.mmap):
+    // the bytes belong to the kernel's page cache, not the GC heap, and
+    // are released with munmap instead of FREE_ARRAY.
+    bool mapped;
+    // Short strings keep their characters inline at the tail of this same
+    // allocation, with chars pointing at embedded; long strings fall back
+    // to a separate buffer.
+    char embedded[];
 };
 
 typedef struct ObjUpvalue {
@@ -62,6 +98,9 @@ typedef struct ObjUpvalue {
     struct ObjUpvalue* next;
 } ObjUpvalue;
 
+typedef struct JitCode JitCode;
+typedef struct ObjClosure ObjClosure;
+
 typedef struct {
     Obj         obj;
     int         arity;
@@ -70,26 +109,78 @@ typedef struct {
     Chunk       chunk;
     ObjString*  name;
     const char* source;
+    // A zero-upvalue function closes over nothing, so every evaluation of
+    // the literal shares this one closure instead of allocating afresh.
+    ObjClosure* sharedClosure;
+    // Entry and loop back-edge count; once it crosses JIT_THRESHOLD the
+    // chunk is translated (or rejected) exactly once.
+    uint32_t hotness;
+    JitCode* jit;
 } ObjFunction;
 
-typedef struct {
+struct ObjClosure {
     Obj          obj;
     ObjFunction* function;
     ObjUpvalue** upvalues;
     int          upvalueCount;
-} ObjClosure;
+};
 
-typedef struct {
+// A hidden class describing the field layout of instances initialized the
+// same way. Instances sharing a shape store their fields in a flat slot
+// array; slots maps field name to slot index, edges maps field name to the
+// shape an instance transitions to when that field is first added.
+typedef struct ObjShape {
+    Obj              obj;
+    struct ObjShape* parent;
+    Value            name;
+    int              slot;
+    int              slotCount;
+    Table            edges;
+    Table            slots;
+} ObjShape;
+
+// Operator IDs for the per-class dunder vtable; one slot per overloadable
+// operator, filled when OP_METHOD defines the matching __-method.
+typedef enum {
+    OPERATOR_ADD,
+    OPERATOR_SUB,
+    OPERATOR_MUL,
+    OPERATOR_DIV,
+    OPERATOR_GT,
+    OPERATOR_GTE,
+    OPERATOR_LT,
+    OPERATOR_LTE,
+    OPERATOR_EQ,
+    OPERATOR_NEQ,
+    OPERATOR_AND,
+    OPERATOR_OR,
+    OPERATOR_XOR,
+    OPERATOR_MOD,
+    OPERATOR_NOT,
+    OPERATOR_RSHIFT,
+    OPERATOR_LSHIFT,
+    OPERATOR_COUNT,
+} Operator;
+
+typedef struct ObjClass {
     Obj        obj;
     ObjString* name;
+    ObjShape*  shape;
     Table      methods;
     Table      fields;
+    // Inheritance links to the parent instead of copying its tables:
+    // methods holds only this class's own definitions, and lookups walk
+    // the chain (resolved results land in the call-site inline caches).
+    struct ObjClass* superclass;
+    ObjClosure*      operators[OPERATOR_COUNT];
 } ObjClass;
 
 typedef struct {
     Obj       obj;
     ObjClass* klass;
-    Table     fields;
+    ObjShape* shape;
+    int       slotCapacity;
+    Value*    slots;
 } ObjInstance;
 
 typedef struct {
@@ -117,6 +208,7 @@ typedef struct {
 
 ObjBoundMethod* newBoundMethod(Value receiver, ObjClosure* method);
 ObjClass*       newClass(ObjString* name);
+bool            classMethod(ObjClass* klass, Value name, Value* method);
 ObjInstance*    newInstance(ObjClass* klass);
 
 ObjClosure*  newClosure(ObjFunction* function);
@@ -125,11 +217,22 @@ ObjNative*   newNative(NativeFn function);
 
 ObjString* takeString(char* chars, int length);
 ObjString* copyString(const char* chars, int length);
+ObjString* mappedString(char* chars, int length);
+ObjString* uninternedString(const char* chars, int length);
+ObjString* concatStrings(ObjString* a, ObjString* b);
 ObjString* formatString(const char* format, ...);
 char*      copyStringRaw(const char* chars, int length);
+char*      stringChars(ObjString* string);
+uint32_t   stringHash(ObjString* string);
+void       releaseStringBuffer(StringBuffer* buffer);
 
 ObjUpvalue* newUpvalue(Value* slot);
 
+ObjShape* newShape(ObjShape* parent, Value name);
+ObjShape* shapeAdvance(ObjShape* shape, Value name);
+bool      instanceGetField(ObjInstance* instance, Value name, Value* value);
+void      instanceSetField(ObjInstance* instance, Value name, Value value);
+
 ObjTable* newTable(void);
 ObjArray* newArray(void);
 
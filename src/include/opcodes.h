@@ -14,6 +14,9 @@ OPCODE(LESS_EQUAL)
 
 // Binary
 OPCODE(ADD)
+OPCODE(ADD_NUMBER)
+OPCODE(ADD_STRING)
+OPCODE(ADD_DUNDER)
 OPCODE(SUBTRACT)
 OPCODE(MULTIPLY)
 OPCODE(DIVIDE)
@@ -30,6 +33,13 @@ OPCODE(NEGATE)
 OPCODE(INCREMENT)
 OPCODE(DECREMENT)
 
+// Superinstructions (fused by optimizeChunk, same size as the
+// sequences they replace)
+OPCODE(GET_LOCAL_CONSTANT_ADD)
+OPCODE(LESS_JUMP_IF_FALSE)
+OPCODE(CONSTANT_CALL)
+OPCODE(INCREMENT_SET_LOCAL_POP)
+
 // Expressions
 OPCODE(POP)
 OPCODE(POP_N)
@@ -61,11 +71,14 @@ OPCODE(FORMAT)
 // Statements
 OPCODE(IMPORT)
 OPCODE(DUMP)
+OPCODE(SWITCH)
+OPCODE(FOR_LOOP)
 OPCODE(JUMP)
 OPCODE(JUMP_IF_FALSE)
 OPCODE(LOOP)
 OPCODE(CALL)
 OPCODE(CALL_BLIND)
+OPCODE(TAIL_CALL)
 OPCODE(INDEX)
 OPCODE(SET_INDEX)
 OPCODE(INVOKE)
@@ -0,0 +1,38 @@
+#ifndef phelt_phelt_h
+#define phelt_phelt_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Public embedding API for libphelt. A PheltContext is a fully isolated
+// interpreter — its own heap, globals, string table and stack — so one
+// resident process can keep several warm contexts around and run scripts
+// without paying interpreter start-up per invocation. Contexts are not
+// thread-safe: only one may run at a time, and calls into the API switch
+// the active context as needed.
+typedef struct PheltContext PheltContext;
+
+typedef enum {
+    PHELT_OK,
+    PHELT_COMPILE_ERROR,
+    PHELT_RUNTIME_ERROR
+} PheltStatus;
+
+// Pass 0 for either limit to take the interpreter defaults.
+PheltContext* pheltNewContext(int frameLimit, size_t stackSlots);
+void          pheltFreeContext(PheltContext* context);
+
+// Compiles and runs source in the context. sourcePath names the script in
+// error traces and compiled-chunk caching; pass NULL for in-memory source.
+PheltStatus pheltRun(PheltContext* context, const char* sourcePath, const char* source);
+
+// Exchange values with a context through its global scope. Getters return
+// false when the global is undefined or has a different type. The pointer
+// from pheltGetString is owned by the context and is only guaranteed to
+// survive until the next pheltRun or pheltSet call on it.
+bool        pheltGetNumber(PheltContext* context, const char* name, double* value);
+const char* pheltGetString(PheltContext* context, const char* name);
+void        pheltSetNumber(PheltContext* context, const char* name, double value);
+void        pheltSetString(PheltContext* context, const char* name, const char* value);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef phelt_serialize_h
+#define phelt_serialize_h
+
+#include "common.h"
+#include "object.h"
+
+ObjFunction* readChunkCache(const char* sourcePath);
+void         writeChunkCache(const char* sourcePath, ObjFunction* function);
+
+#endif
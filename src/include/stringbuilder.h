@@ -0,0 +1,42 @@
+#ifndef phelt_stringbuilder_h
+#define phelt_stringbuilder_h
+
+#include "object.h"
+
+// Bytes of inline storage every builder starts with. Most built strings —
+// interpolated templates, formatted error text — fit here and never touch
+// the heap.
+#define SB_SEED_SIZE 256
+
+// Growable append buffer for assembling strings. Seeded from an inline
+// stack array and spilled to a GC-accounted heap buffer only when the
+// text outgrows it; sbFinish hands the heap buffer to takeString without
+// a final copy. One builder serves formatString, stringValue and the
+// OP_FORMAT template handler, which used to each roll their own
+// fixed-size or per-call buffers.
+typedef struct {
+    char*  chars;
+    size_t length;
+    size_t capacity;
+    char   seed[SB_SEED_SIZE];
+} StringBuilder;
+
+void sbInit(StringBuilder* sb);
+void sbAppend(StringBuilder* sb, const char* bytes, size_t count);
+void sbAppendChar(StringBuilder* sb, char c);
+void sbAppendCString(StringBuilder* sb, const char* chars);
+// Appends a number the way stringValue always has (%.14g), with a digit
+// loop covering integral values so the common case skips printf parsing.
+void sbAppendNumber(StringBuilder* sb, double number);
+// Appends any value as text; strings and numbers take direct paths.
+void sbAppendValue(StringBuilder* sb, Value value);
+void sbAppendVFormat(StringBuilder* sb, const char* format, va_list args);
+
+// Finish and hand the text to the VM as a string; the builder is spent.
+ObjString* sbFinish(StringBuilder* sb);
+// Finish into a malloc'd C string instead; the builder is spent.
+char* sbToCString(StringBuilder* sb);
+// Abandon without producing anything (error paths).
+void sbDiscard(StringBuilder* sb);
+
+#endif
@@ -14,7 +14,15 @@ typedef struct
 {
     unsigned int count;
     unsigned int capacity;
-    Entry*       entries;
+    // Slots holding the deleted sentinel. They stay probeable until the
+    // next rebuild sweeps them out, so they weigh on the load factor the
+    // same as live entries.
+    unsigned int tombstones;
+    // One control byte per slot: a seven-bit fragment of the key's hash for
+    // full slots, or an empty/deleted sentinel. Lookups probe this array a
+    // group at a time and only touch an Entry on a fragment match.
+    uint8_t* ctrl;
+    Entry*   entries;
 } Table;
 
 void       initTable(Table* table);
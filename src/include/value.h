@@ -2,6 +2,7 @@
 #define phelt_value_h
 
 #include "common.h"
+#include <math.h>
 #include <string.h>
 
 typedef struct Obj       Obj;
@@ -17,25 +18,44 @@ typedef struct ObjString ObjString;
 #define TAG_TRUE 3  // 011.
 #define TAG_EMPTY 4 // 100.
 
+// Small integers ride inside the quiet-NaN space with bit 48 set and the
+// value in the low 32 bits. NUMBER_VAL canonicalizes integral doubles to
+// this form, so equal numbers always have equal bit patterns and the
+// arithmetic opcodes can take an integer fast path.
+#define TAG_INT ((uint64_t)0x0001000000000000)
+
+// Raw pointers share the sign-bit quiet-NaN namespace with heap objects.
+// Everything stored as a pointer value (FILE*, pool blocks, malloc results)
+// is at least 16-byte aligned, so bit 0 tags them apart from Obj* — without
+// it the GC would mark through foreign pointers as if they were objects.
+#define TAG_POINTER ((uint64_t)0x1)
+
 typedef uint64_t Value;
 
 #define IS_BOOL(value) (((value) | 1) == TRUE_VAL)
 #define IS_NIL(value) ((value) == NIL_VAL)
 #define IS_EMPTY(value) ((value) == EMPTY_VAL)
-#define IS_POINTER(value) (((value) & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT))
-#define IS_NUMBER(value) (((value)&QNAN) != QNAN)
+#define IS_POINTER(value) \
+    (((value) & (QNAN | SIGN_BIT | TAG_POINTER)) == (QNAN | SIGN_BIT | TAG_POINTER))
+#define IS_INT(value) (((value) & (QNAN | SIGN_BIT | TAG_INT)) == (QNAN | TAG_INT))
+#define IS_NUMBER(value) ((((value)&QNAN) != QNAN) || IS_INT(value))
 #define IS_OBJ(value) \
-    (((value) & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT))
+    (((value) & (QNAN | SIGN_BIT | TAG_POINTER)) == (QNAN | SIGN_BIT))
 
 #define AS_BOOL(value) ((value) == TRUE_VAL)
+#define AS_INT(value) ((int32_t)(uint32_t)(value))
 #define AS_NUMBER(value) valueToNum(value)
 #define AS_OBJ(value) \
     ((Obj*)(uintptr_t)((value) & ~(SIGN_BIT | QNAN)))
 #define AS_POINTER(value) \
-    ((void*)(uintptr_t)((value) & ~(SIGN_BIT | QNAN)))
+    ((void*)(uintptr_t)((value) & ~(SIGN_BIT | QNAN | TAG_POINTER)))
+
+#define INT_VAL(i) ((Value)(QNAN | TAG_INT | (uint32_t)(i)))
 
 static inline double valueToNum(Value value)
 {
+    if (IS_INT(value))
+        return (double)AS_INT(value);
     double num;
     memcpy(&num, &value, sizeof(Value));
     return num;
@@ -47,13 +67,18 @@ static inline double valueToNum(Value value)
 #define NIL_VAL ((Value)(uint64_t)(QNAN | TAG_NIL))
 #define EMPTY_VAL ((Value)(uint64_t)(QNAN | TAG_EMPTY))
 #define POINTER_VAL(obj) \
-    (Value)(SIGN_BIT | QNAN | (uint64_t)(uintptr_t)(obj))
+    (Value)(SIGN_BIT | QNAN | TAG_POINTER | (uint64_t)(uintptr_t)(obj))
 #define NUMBER_VAL(num) numToValue(num)
 #define OBJ_VAL(obj) \
     (Value)(SIGN_BIT | QNAN | (uint64_t)(uintptr_t)(obj))
 
 static inline Value numToValue(double num)
 {
+    if (num >= -2147483648.0 && num <= 2147483647.0) {
+        int32_t i = (int32_t)num;
+        if ((double)i == num && !(i == 0 && signbit(num)))
+            return INT_VAL(i);
+    }
     Value value;
     memcpy(&value, &num, sizeof(double));
     return value;
@@ -92,10 +117,12 @@ typedef struct
 #define IS_NIL(value) ((value).type == VAL_NIL)
 #define IS_EMPTY(value) ((value).type == VAL_EMPTY)
 #define IS_NUMBER(value) ((value).type == VAL_NUMBER)
+#define IS_INT(value) false
 #define IS_OBJ(value) ((value).type == VAL_OBJ)
 #define IS_POINTER(value) ((value).type == VAL_POINTER)
 
 #define AS_BOOL(value) ((value).as.boolean)
+#define AS_INT(value) ((int32_t)(value).as.number)
 #define AS_NUMBER(value) ((value).as.number)
 #define AS_OBJ(value) ((value).as.obj)
 #define AS_POINTER(value) ((value).as.pointer)
@@ -104,6 +131,7 @@ typedef struct
 #define NIL_VAL ((Value) { VAL_NIL, { .number = 0 } })
 #define EMPTY_VAL ((Value) { VAL_EMPTY, { .number = 0 } })
 #define NUMBER_VAL(value) ((Value) { VAL_NUMBER, { .number = value } })
+#define INT_VAL(value) ((Value) { VAL_NUMBER, { .number = (double)(value) } })
 #define OBJ_VAL(object) ((Value) { VAL_OBJ, { .obj = (Obj*)object } })
 #define POINTER_VAL(value) ((Value) { VAL_POINTER, { .pointer = value } })
 
@@ -113,7 +141,12 @@ typedef struct
 {
     unsigned int capacity;
     unsigned int count;
-    Value*       values;
+    // True while every element is a number. NaN-boxed numbers carry no heap
+    // references, so an all-number array is effectively an unboxed numeric
+    // buffer: the collector skips tracing it and equality runs bitwise over
+    // it. Cleared (never re-set) on the first non-number store.
+    bool   allNumbers;
+    Value* values;
 } ValueArray;
 
 bool        valuesEqual(Value a, Value b);
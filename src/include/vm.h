@@ -10,8 +10,14 @@
 #include "utf8.h"
 #include "value.h"
 
-#define FRAMES_MAX 64
-#define STACK_MAX (FRAMES_MAX * UINT16_COUNT)
+// Default limits, overridable per process at initVM(frameLimit,
+// stackSlots). Frames start at FRAMES_INITIAL and double on demand up to
+// the limit. The value stack is one anonymous mapping of stackSlots
+// slots reserved up front: it can never move (native frames hold raw
+// Value* into it), and untouched pages cost address space, not RSS.
+#define FRAMES_INITIAL 64
+#define FRAMES_MAX 4096
+#define STACK_MAX (64 * UINT16_COUNT)
 
 typedef struct {
     ObjClosure* closure;
@@ -21,13 +27,27 @@ typedef struct {
 
 typedef struct
 {
-    CallFrame   frames[FRAMES_MAX];
+    CallFrame*  frames;
     int         frameCount;
+    int         frameCapacity;
+    int         frameLimit;
     bool        errorState;
-    Value       stack[STACK_MAX];
+    Value*      stack;
     Value*      stackTop;
+    size_t      stackSlots;
     Table       globals;
+    Table       globalIndexes;
+    ValueArray  globalSlots;
+    ValueArray  globalNames;
+    Table       modules;
     Table       strings;
+    // Single-entry codepoint-to-byte position cache for indexing into
+    // multibyte strings; a character-by-character scan resumes from the
+    // previous position instead of rewalking from the head each time.
+    ObjString* indexCacheString;
+    int        indexCacheCp;
+    int        indexCacheByte;
+    ObjShape*  rootShape;
     ObjUpvalue* openUpvalues;
 
     ObjString* initString;
@@ -53,7 +73,28 @@ typedef struct
     size_t bytesAllocated;
     size_t nextGC;
 
-    Obj* objects;
+    // Object registry: every live object in allocation order, old generation
+    // first. Sweeping is a linear scan that compacts the array in place, so
+    // there is no pointer chase and objects need no intrusive list link.
+    Obj** objects;
+    int   objectCount;
+    int   objectCapacity;
+
+    // Generational state: the first oldCount registry entries survived at
+    // least one collection, oldBytes is the heap size after the last
+    // collection, and gcMinor is set while a minor collection is running so
+    // marking can skip the old generation.
+    int    oldCount;
+    size_t oldBytes;
+    bool   gcMinor;
+
+    // True while an incremental major cycle is in its marking phase; the
+    // gray stack then doubles as the pending work list between increments.
+    bool gcMarking;
+
+    int   rememberedCount;
+    int   rememberedCapacity;
+    Obj** rememberedSet;
 
     int   grayCount;
     int   grayCapacity;
@@ -66,15 +107,35 @@ typedef enum {
     INTERPRET_RUNTIME_ERROR
 } InterpretResult;
 
-extern VM vm;
+extern __thread VM vm;
 
-void            initVM(void);
+// Pass 0 for either limit to take the FRAMES_MAX / STACK_MAX defaults.
+void            initVM(int frameLimit, size_t stackSlots);
 void            freeVM(void);
 InterpretResult interpret(const char* sourcePath, utf8_int8_t* source);
 void            push(Value value);
 Value           pop(void);
 bool            call(ObjClosure* closure, int argCount);
+uint16_t        globalSlot(Value name);
 InterpretResult run(void);
 void            defineNative(Table* dest, const char* name, NativeFn function);
 
+// Sampling profiler (exposed through debug.profileStart/profileStop): a
+// SIGPROF handler snapshots the frame stack at hz samples per second, and
+// profileStop() returns the collapsed-stack report. Pass 0 for the default
+// frequency. markProfilerRoots keeps sampled functions alive across
+// collections while a profile is open.
+bool       profileStart(int hz);
+ObjString* profileStop(void);
+void       markProfilerRoots(void);
+
+// Dispatch statistics (DEBUG_DISPATCH_STATS builds only): per-opcode
+// execution counts, opcode-pair counts and branch-taken ratios, dumped as a
+// text table at exit or on demand via debug.dispatchStats().
+#ifdef DEBUG_DISPATCH_STATS
+void     dispatchStatsDump(FILE* out);
+void     dispatchStatsReset(void);
+uint64_t dispatchStatsTotal(void);
+#endif
+
 #endif
@@ -0,0 +1,999 @@
+#include "jit.h"
+#include "vm.h"
+
+#ifdef JIT_AVAILABLE
+
+#include <sys/mman.h>
+
+// ---------------------------------------------------------------------------
+// Helpers called from generated code.
+//
+// Stack helpers take the live stack top and return the new one, or 0 to
+// deopt; a deopting helper must leave the stack and locals untouched so the
+// interpreter can re-execute the opcode from scratch. Branch helpers fold
+// the branch decision into the return value. Every helper mirrors its
+// interpreter case in vm.c exactly — same fast paths, same canonical
+// NUMBER_VAL boxing — and none of them allocate.
+// ---------------------------------------------------------------------------
+
+static uintptr_t jitAddNumber(Value* stackTop)
+{
+    Value b = stackTop[-1];
+    Value a = stackTop[-2];
+    if (!IS_NUMBER(a) || !IS_NUMBER(b))
+        return 0;
+    if (IS_INT(a) && IS_INT(b)) {
+        int32_t sum;
+        if (__builtin_add_overflow(AS_INT(a), AS_INT(b), &sum)) {
+            stackTop[-2] = NUMBER_VAL((double)AS_INT(a) + (double)AS_INT(b));
+        } else {
+            stackTop[-2] = INT_VAL(sum);
+        }
+    } else {
+        stackTop[-2] = NUMBER_VAL(AS_NUMBER(a) + AS_NUMBER(b));
+    }
+    return (uintptr_t)(stackTop - 1);
+}
+
+static uintptr_t jitSubtract(Value* stackTop)
+{
+    Value b = stackTop[-1];
+    Value a = stackTop[-2];
+    if (IS_INT(a) && IS_INT(b)) {
+        int32_t diff;
+        if (__builtin_sub_overflow(AS_INT(a), AS_INT(b), &diff)) {
+            stackTop[-2] = NUMBER_VAL((double)AS_INT(a) - (double)AS_INT(b));
+        } else {
+            stackTop[-2] = INT_VAL(diff);
+        }
+        return (uintptr_t)(stackTop - 1);
+    }
+    if (!IS_NUMBER(a) || !IS_NUMBER(b))
+        return 0;
+    stackTop[-2] = NUMBER_VAL(AS_NUMBER(a) - AS_NUMBER(b));
+    return (uintptr_t)(stackTop - 1);
+}
+
+#define JIT_BINARY(name, valueType, op)                          \
+    static uintptr_t name(Value* stackTop)                       \
+    {                                                            \
+        Value b = stackTop[-1];                                  \
+        Value a = stackTop[-2];                                  \
+        if (!IS_NUMBER(a) || !IS_NUMBER(b))                      \
+            return 0;                                            \
+        stackTop[-2] = valueType(AS_NUMBER(a) op AS_NUMBER(b));  \
+        return (uintptr_t)(stackTop - 1);                        \
+    }
+
+#define JIT_BINARY_INT(name, op)                                           \
+    static uintptr_t name(Value* stackTop)                                 \
+    {                                                                      \
+        Value b = stackTop[-1];                                            \
+        Value a = stackTop[-2];                                            \
+        if (!IS_NUMBER(a) || !IS_NUMBER(b))                                \
+            return 0;                                                      \
+        stackTop[-2] = NUMBER_VAL((int)AS_NUMBER(a) op(int) AS_NUMBER(b)); \
+        return (uintptr_t)(stackTop - 1);                                  \
+    }
+
+JIT_BINARY(jitMultiply, NUMBER_VAL, *)
+JIT_BINARY(jitDivide, NUMBER_VAL, /)
+JIT_BINARY(jitLess, BOOL_VAL, <)
+JIT_BINARY(jitLessEqual, BOOL_VAL, <=)
+JIT_BINARY(jitGreater, BOOL_VAL, >)
+JIT_BINARY(jitGreaterEqual, BOOL_VAL, >=)
+JIT_BINARY_INT(jitModulo, %)
+JIT_BINARY_INT(jitBitwiseAnd, &)
+JIT_BINARY_INT(jitBitwiseOr, |)
+JIT_BINARY_INT(jitBitwiseXor, ^)
+JIT_BINARY_INT(jitShiftLeft, <<)
+JIT_BINARY_INT(jitShiftRight, >>)
+
+#undef JIT_BINARY
+#undef JIT_BINARY_INT
+
+static uintptr_t jitEqual(Value* stackTop, uint32_t negated)
+{
+    Value b = stackTop[-1];
+    Value a = stackTop[-2];
+    // Instances may carry __eq and arrays compare structurally; both go
+    // through the interpreter.
+    if (IS_INSTANCE(a) && IS_INSTANCE(b))
+        return 0;
+    if (IS_ARRAY(a) && IS_ARRAY(b))
+        return 0;
+    bool equal   = valuesEqual(a, b);
+    stackTop[-2] = BOOL_VAL(negated ? !equal : equal);
+    return (uintptr_t)(stackTop - 1);
+}
+
+static uintptr_t jitNot(Value* stackTop)
+{
+    if (IS_INSTANCE(stackTop[-1]) && IS_INSTANCE(stackTop[-2]))
+        return 0;
+    Value a      = stackTop[-1];
+    stackTop[-1] = BOOL_VAL(a == NIL_VAL || a == FALSE_VAL);
+    return (uintptr_t)stackTop;
+}
+
+static uintptr_t jitNegate(Value* stackTop)
+{
+    Value a = stackTop[-1];
+    if (!IS_NUMBER(a))
+        return 0;
+    stackTop[-1] = NUMBER_VAL(-AS_NUMBER(a));
+    return (uintptr_t)stackTop;
+}
+
+static uintptr_t jitIncrement(Value* stackTop)
+{
+    Value a = stackTop[-1];
+    if (IS_INT(a) && AS_INT(a) != INT32_MAX) {
+        stackTop[-1] = INT_VAL(AS_INT(a) + 1);
+        return (uintptr_t)stackTop;
+    }
+    if (!IS_NUMBER(a))
+        return 0;
+    stackTop[-1] = NUMBER_VAL(AS_NUMBER(a) + 1);
+    return (uintptr_t)stackTop;
+}
+
+static uintptr_t jitDecrement(Value* stackTop)
+{
+    Value a = stackTop[-1];
+    if (IS_INT(a) && AS_INT(a) != INT32_MIN) {
+        stackTop[-1] = INT_VAL(AS_INT(a) - 1);
+        return (uintptr_t)stackTop;
+    }
+    if (!IS_NUMBER(a))
+        return 0;
+    stackTop[-1] = NUMBER_VAL(AS_NUMBER(a) - 1);
+    return (uintptr_t)stackTop;
+}
+
+static uintptr_t jitLocalConstantAdd(Value* stackTop, Value* slots, uint32_t slot, Value constant)
+{
+    Value local = slots[slot];
+    if (IS_INT(local) && IS_INT(constant)) {
+        int32_t sum;
+        if (__builtin_add_overflow(AS_INT(local), AS_INT(constant), &sum)) {
+            stackTop[0] = NUMBER_VAL(AS_NUMBER(local) + AS_NUMBER(constant));
+        } else {
+            stackTop[0] = INT_VAL(sum);
+        }
+    } else if (IS_NUMBER(local)) {
+        stackTop[0] = NUMBER_VAL(AS_NUMBER(local) + AS_NUMBER(constant));
+    } else {
+        return 0;
+    }
+    return (uintptr_t)(stackTop + 1);
+}
+
+static uintptr_t jitIncrementSetLocalPop(Value* stackTop, Value* slots, uint32_t slot)
+{
+    Value a = stackTop[-1];
+    if (IS_INT(a) && AS_INT(a) != INT32_MAX) {
+        slots[slot] = INT_VAL(AS_INT(a) + 1);
+    } else if (IS_NUMBER(a)) {
+        slots[slot] = NUMBER_VAL(AS_NUMBER(a) + 1);
+    } else {
+        return 0;
+    }
+    return (uintptr_t)(stackTop - 1);
+}
+
+// Pops both operands, pushes the comparison result, and reports the branch
+// in bit 0 of the returned stack top (taken when the comparison is false,
+// matching OP_LESS_JUMP_IF_FALSE).
+static uintptr_t jitLessJump(Value* stackTop)
+{
+    Value b = stackTop[-1];
+    Value a = stackTop[-2];
+    if (!IS_NUMBER(a) || !IS_NUMBER(b))
+        return 0;
+    bool less;
+    if (IS_INT(a) && IS_INT(b)) {
+        less = AS_INT(a) < AS_INT(b);
+    } else {
+        less = AS_NUMBER(a) < AS_NUMBER(b);
+    }
+    stackTop[-2] = BOOL_VAL(less);
+    return (uintptr_t)(stackTop - 1) | (less ? 0 : 1);
+}
+
+// Returns 0 to deopt, 1 to fall through, 2 to take the back edge.
+static uintptr_t jitForLoop(Value* slots, uint32_t slot, Value limitConst,
+    uint32_t limitSlot, uint32_t limitIsConst)
+{
+    Value induction = slots[slot];
+    Value limit     = limitIsConst ? limitConst : slots[limitSlot];
+    if (!IS_NUMBER(induction) || !IS_NUMBER(limit))
+        return 0;
+    double next = AS_NUMBER(induction) + 1;
+    slots[slot] = NUMBER_VAL(next);
+    return next < AS_NUMBER(limit) ? 2 : 1;
+}
+
+// Compound global reads check every slot before pushing anything so a
+// deopt re-executes the whole opcode without double-pushing.
+static uintptr_t jitGetGlobal(Value* stackTop, uint32_t slot)
+{
+    Value value = vm.globalSlots.values[slot];
+    if (IS_EMPTY(value))
+        return 0;
+    stackTop[0] = value;
+    return (uintptr_t)(stackTop + 1);
+}
+
+static uintptr_t jitGetGlobal2(Value* stackTop, uint32_t a, uint32_t b)
+{
+    Value va = vm.globalSlots.values[a];
+    Value vb = vm.globalSlots.values[b];
+    if (IS_EMPTY(va) || IS_EMPTY(vb))
+        return 0;
+    stackTop[0] = va;
+    stackTop[1] = vb;
+    return (uintptr_t)(stackTop + 2);
+}
+
+static uintptr_t jitGetGlobal3(Value* stackTop, uint32_t a, uint32_t b, uint32_t c)
+{
+    Value va = vm.globalSlots.values[a];
+    Value vb = vm.globalSlots.values[b];
+    Value vc = vm.globalSlots.values[c];
+    if (IS_EMPTY(va) || IS_EMPTY(vb) || IS_EMPTY(vc))
+        return 0;
+    stackTop[0] = va;
+    stackTop[1] = vb;
+    stackTop[2] = vc;
+    return (uintptr_t)(stackTop + 3);
+}
+
+static uintptr_t jitGetGlobal4(Value* stackTop, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    Value va = vm.globalSlots.values[a];
+    Value vb = vm.globalSlots.values[b];
+    Value vc = vm.globalSlots.values[c];
+    Value vd = vm.globalSlots.values[d];
+    if (IS_EMPTY(va) || IS_EMPTY(vb) || IS_EMPTY(vc) || IS_EMPTY(vd))
+        return 0;
+    stackTop[0] = va;
+    stackTop[1] = vb;
+    stackTop[2] = vc;
+    stackTop[3] = vd;
+    return (uintptr_t)(stackTop + 4);
+}
+
+// ---------------------------------------------------------------------------
+// x86-64 emitter.
+//
+// Register plan, all callee-saved so helper calls need no spills:
+//   rbx = frame slots        r13 = stack top        r12 = &vm.stackTop
+// Generated code returns the bytecode offset to resume from in eax; the
+// epilogue flushes r13 back through r12 first.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint8_t* bytes;
+    size_t   count;
+    size_t   capacity;
+    bool     ok;
+} CodeBuffer;
+
+// Forward jump fixups; a target of -1 patches to the epilogue.
+typedef struct {
+    size_t  at;
+    int32_t targetBc;
+} JumpPatch;
+
+typedef struct {
+    JumpPatch* patches;
+    int        count;
+    int        capacity;
+} PatchList;
+
+static void emit8(CodeBuffer* buf, uint8_t byte)
+{
+    if (buf->count == buf->capacity) {
+        buf->capacity = buf->capacity < 256 ? 256 : buf->capacity * 2;
+        uint8_t* next = realloc(buf->bytes, buf->capacity);
+        if (next == NULL) {
+            buf->ok = false;
+            return;
+        }
+        buf->bytes = next;
+    }
+    buf->bytes[buf->count++] = byte;
+}
+
+static void emit32(CodeBuffer* buf, uint32_t word)
+{
+    emit8(buf, word & 0xff);
+    emit8(buf, (word >> 8) & 0xff);
+    emit8(buf, (word >> 16) & 0xff);
+    emit8(buf, (word >> 24) & 0xff);
+}
+
+static void emit64(CodeBuffer* buf, uint64_t word)
+{
+    emit32(buf, (uint32_t)word);
+    emit32(buf, (uint32_t)(word >> 32));
+}
+
+static void addPatch(PatchList* list, size_t at, int32_t targetBc)
+{
+    if (list->count == list->capacity) {
+        list->capacity   = list->capacity < 16 ? 16 : list->capacity * 2;
+        JumpPatch* grown = realloc(list->patches, sizeof(JumpPatch) * list->capacity);
+        if (grown == NULL)
+            return; // buf->ok catches the paired emit failure.
+        list->patches = grown;
+    }
+    list->patches[list->count].at       = at;
+    list->patches[list->count].targetBc = targetBc;
+    list->count++;
+}
+
+// mov rax, value; mov [r13], rax; add r13, 8
+static void emitPushValue(CodeBuffer* buf, Value value)
+{
+    emit8(buf, 0x48);
+    emit8(buf, 0xb8);
+    emit64(buf, value);
+    emit8(buf, 0x49);
+    emit8(buf, 0x89);
+    emit8(buf, 0x45);
+    emit8(buf, 0x00);
+    emit8(buf, 0x49);
+    emit8(buf, 0x83);
+    emit8(buf, 0xc5);
+    emit8(buf, 0x08);
+}
+
+// mov rax, [rbx + slot*8]; mov [r13], rax; add r13, 8
+static void emitGetLocal(CodeBuffer* buf, uint32_t slot)
+{
+    emit8(buf, 0x48);
+    emit8(buf, 0x8b);
+    emit8(buf, 0x83);
+    emit32(buf, slot * 8);
+    emit8(buf, 0x49);
+    emit8(buf, 0x89);
+    emit8(buf, 0x45);
+    emit8(buf, 0x00);
+    emit8(buf, 0x49);
+    emit8(buf, 0x83);
+    emit8(buf, 0xc5);
+    emit8(buf, 0x08);
+}
+
+// mov rax, [r13 - depth*8]; mov [rbx + slot*8], rax
+static void emitSetLocal(CodeBuffer* buf, uint32_t slot, int depth)
+{
+    emit8(buf, 0x49);
+    emit8(buf, 0x8b);
+    emit8(buf, 0x45);
+    emit8(buf, (uint8_t)(int8_t)(-8 * depth));
+    emit8(buf, 0x48);
+    emit8(buf, 0x89);
+    emit8(buf, 0x83);
+    emit32(buf, slot * 8);
+}
+
+// sub r13, n*8
+static void emitDrop(CodeBuffer* buf, uint32_t n)
+{
+    emit8(buf, 0x49);
+    emit8(buf, 0x81);
+    emit8(buf, 0xed);
+    emit32(buf, n * 8);
+}
+
+// mov rax, helper; call rax
+static void emitCall(CodeBuffer* buf, uintptr_t helper)
+{
+    emit8(buf, 0x48);
+    emit8(buf, 0xb8);
+    emit64(buf, (uint64_t)helper);
+    emit8(buf, 0xff);
+    emit8(buf, 0xd0);
+}
+
+// test rax, rax; jnz past the stub; mov eax, bcOffset; jmp epilogue
+static void emitDeoptOnZero(CodeBuffer* buf, PatchList* patches, int bcOffset)
+{
+    emit8(buf, 0x48);
+    emit8(buf, 0x85);
+    emit8(buf, 0xc0);
+    emit8(buf, 0x75);
+    emit8(buf, 0x0a);
+    emit8(buf, 0xb8);
+    emit32(buf, (uint32_t)bcOffset);
+    emit8(buf, 0xe9);
+    addPatch(patches, buf->count, -1);
+    emit32(buf, 0);
+}
+
+// Unconditional deopt: mov eax, bcOffset; jmp epilogue
+static void emitDeopt(CodeBuffer* buf, PatchList* patches, int bcOffset)
+{
+    emit8(buf, 0xb8);
+    emit32(buf, (uint32_t)bcOffset);
+    emit8(buf, 0xe9);
+    addPatch(patches, buf->count, -1);
+    emit32(buf, 0);
+}
+
+// A stack helper already ran and rax is nonzero: mov r13, rax
+static void emitTakeStackTop(CodeBuffer* buf)
+{
+    emit8(buf, 0x49);
+    emit8(buf, 0x89);
+    emit8(buf, 0xc5);
+}
+
+// mov rdi, r13 — first argument of every stack helper.
+static void emitStackTopArg(CodeBuffer* buf)
+{
+    emit8(buf, 0x4c);
+    emit8(buf, 0x89);
+    emit8(buf, 0xef);
+}
+
+// The whole template for a plain stack helper: call, deopt on 0, take the
+// returned stack top.
+static void emitStackHelper(CodeBuffer* buf, PatchList* patches, int bcOffset, uintptr_t helper)
+{
+    emitStackTopArg(buf);
+    emitCall(buf, helper);
+    emitDeoptOnZero(buf, patches, bcOffset);
+    emitTakeStackTop(buf);
+}
+
+static uint16_t readShort(const uint8_t* code, int offset)
+{
+    return (uint16_t)((code[offset] << 8) | code[offset + 1]);
+}
+
+// Mirrors the operand widths the interpreter reads (debug.c moveForward);
+// a negative result rejects the function.
+static int instructionLength(Chunk* chunk, int offset)
+{
+    switch (chunk->code[offset]) {
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_EQUAL:
+    case OP_NOT_EQUAL:
+    case OP_GREATER:
+    case OP_GREATER_EQUAL:
+    case OP_LESS:
+    case OP_LESS_EQUAL:
+    case OP_ADD:
+    case OP_ADD_NUMBER:
+    case OP_ADD_STRING:
+    case OP_ADD_DUNDER:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_MODULO:
+    case OP_BITWISE_AND:
+    case OP_BITWISE_OR:
+    case OP_BITWISE_XOR:
+    case OP_SHIFT_LEFT:
+    case OP_SHIFT_RIGHT:
+    case OP_NOT:
+    case OP_NEGATE:
+    case OP_INCREMENT:
+    case OP_DECREMENT:
+    case OP_POP:
+    case OP_DUP:
+    case OP_INDEX:
+    case OP_SET_INDEX:
+    case OP_CLOSE_UPVALUE:
+    case OP_RETURN:
+    case OP_REENTER:
+    case OP_INHERIT:
+    case OP_IMPORT:
+    case OP_SLICE:
+    case OP_DUMP:
+        return 1;
+    case OP_POP_N:
+        return 2;
+    case OP_CONSTANT:
+    case OP_GET_LOCAL:
+    case OP_SET_LOCAL:
+    case OP_GET_GLOBAL:
+    case OP_DEFINE_GLOBAL:
+    case OP_SET_GLOBAL:
+    case OP_GET_UPVALUE:
+    case OP_SET_UPVALUE:
+    case OP_GET_SUPER:
+    case OP_SET_TABLE:
+    case OP_SET_ARRAY:
+    case OP_SWITCH:
+    case OP_JUMP:
+    case OP_JUMP_IF_FALSE:
+    case OP_LOOP:
+    case OP_CALL:
+    case OP_CALL_BLIND:
+    case OP_TAIL_CALL:
+    case OP_CLASS:
+    case OP_METHOD:
+    case OP_FORMAT:
+        return 3;
+    case OP_LESS_JUMP_IF_FALSE:
+        return 4;
+    case OP_GET_LOCAL_2:
+    case OP_SET_LOCAL_2:
+    case OP_GET_GLOBAL_2:
+    case OP_GET_PROPERTY:
+    case OP_SET_PROPERTY:
+    case OP_SUPER_INVOKE:
+    case OP_INCREMENT_SET_LOCAL_POP:
+        return 5;
+    case OP_CONSTANT_CALL:
+        return 6;
+    case OP_GET_LOCAL_3:
+    case OP_SET_LOCAL_3:
+    case OP_GET_GLOBAL_3:
+    case OP_GET_LOCAL_CONSTANT_ADD:
+    case OP_INVOKE:
+        return 7;
+    case OP_FOR_LOOP:
+        return 8;
+    case OP_GET_LOCAL_4:
+    case OP_SET_LOCAL_4:
+    case OP_GET_GLOBAL_4:
+        return 9;
+    case OP_CLOSURE: {
+        uint16_t     constant = readShort(chunk->code, offset + 1);
+        ObjFunction* function = AS_FUNCTION(chunk->constants.values[constant]);
+        return 3 + function->upvalueCount * 3;
+    }
+    default:
+        return -1;
+    }
+}
+
+void jitCompile(ObjFunction* function)
+{
+    // Mark the attempt up front so a rejection is never retried.
+    function->jit = JIT_REJECTED;
+
+    Chunk* chunk = &function->chunk;
+    int    count = (int)chunk->count;
+    if (count == 0 || count > UINT16_MAX)
+        return;
+
+    int32_t* nativeOffset = malloc(sizeof(int32_t) * count);
+    if (nativeOffset == NULL)
+        return;
+    for (int i = 0; i < count; i++) {
+        nativeOffset[i] = -1;
+    }
+
+    CodeBuffer buf     = { NULL, 0, 0, true };
+    PatchList  jumps   = { NULL, 0, 0 }; // resolve through nativeOffset
+    PatchList  patches = { NULL, 0, 0 }; // resolve to the epilogue
+
+    // Prologue: push rbx/r12/r13, rbx = slots (rdi), r12 = &stackTop (rsi),
+    // r13 = *r12. Three pushes also realign the stack for helper calls.
+    emit8(&buf, 0x53);
+    emit8(&buf, 0x41);
+    emit8(&buf, 0x54);
+    emit8(&buf, 0x41);
+    emit8(&buf, 0x55);
+    emit8(&buf, 0x48);
+    emit8(&buf, 0x89);
+    emit8(&buf, 0xfb);
+    emit8(&buf, 0x49);
+    emit8(&buf, 0x89);
+    emit8(&buf, 0xf4);
+    emit8(&buf, 0x4c);
+    emit8(&buf, 0x8b);
+    emit8(&buf, 0x2e);
+
+    bool reject       = false;
+    bool entryDeopts  = false;
+    int  instructions = 0;
+    int  deoptStubs   = 0;
+    for (int offset = 0; offset < count && !reject;) {
+        int length = instructionLength(chunk, offset);
+        if (length < 0 || offset + length > count) {
+            reject = true;
+            break;
+        }
+        nativeOffset[offset] = (int32_t)buf.count;
+
+        const uint8_t* code = chunk->code;
+        switch (code[offset]) {
+        case OP_CONSTANT:
+            emitPushValue(&buf, chunk->constants.values[readShort(code, offset + 1)]);
+            break;
+        case OP_NIL:
+            emitPushValue(&buf, NIL_VAL);
+            break;
+        case OP_TRUE:
+            emitPushValue(&buf, TRUE_VAL);
+            break;
+        case OP_FALSE:
+            emitPushValue(&buf, FALSE_VAL);
+            break;
+        case OP_POP:
+            emitDrop(&buf, 1);
+            break;
+        case OP_POP_N:
+            emitDrop(&buf, code[offset + 1]);
+            break;
+        case OP_DUP:
+            // mov rax, [r13-8]; push it again.
+            emit8(&buf, 0x49);
+            emit8(&buf, 0x8b);
+            emit8(&buf, 0x45);
+            emit8(&buf, 0xf8);
+            emit8(&buf, 0x49);
+            emit8(&buf, 0x89);
+            emit8(&buf, 0x45);
+            emit8(&buf, 0x00);
+            emit8(&buf, 0x49);
+            emit8(&buf, 0x83);
+            emit8(&buf, 0xc5);
+            emit8(&buf, 0x08);
+            break;
+        case OP_GET_LOCAL:
+            emitGetLocal(&buf, readShort(code, offset + 1));
+            break;
+        case OP_GET_LOCAL_2:
+        case OP_GET_LOCAL_3:
+        case OP_GET_LOCAL_4: {
+            int slots = 2 + (code[offset] - OP_GET_LOCAL_2);
+            for (int i = 0; i < slots; i++) {
+                emitGetLocal(&buf, readShort(code, offset + 1 + i * 2));
+            }
+            break;
+        }
+        case OP_SET_LOCAL:
+            emitSetLocal(&buf, readShort(code, offset + 1), 1);
+            break;
+        case OP_SET_LOCAL_2:
+        case OP_SET_LOCAL_3:
+        case OP_SET_LOCAL_4: {
+            int slots = 2 + (code[offset] - OP_SET_LOCAL_2);
+            for (int i = 0; i < slots; i++) {
+                emitSetLocal(&buf, readShort(code, offset + 1 + i * 2), i + 1);
+            }
+            break;
+        }
+        case OP_ADD_NUMBER:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitAddNumber);
+            break;
+        case OP_SUBTRACT:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitSubtract);
+            break;
+        case OP_MULTIPLY:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitMultiply);
+            break;
+        case OP_DIVIDE:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitDivide);
+            break;
+        case OP_MODULO:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitModulo);
+            break;
+        case OP_BITWISE_AND:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitBitwiseAnd);
+            break;
+        case OP_BITWISE_OR:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitBitwiseOr);
+            break;
+        case OP_BITWISE_XOR:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitBitwiseXor);
+            break;
+        case OP_SHIFT_LEFT:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitShiftLeft);
+            break;
+        case OP_SHIFT_RIGHT:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitShiftRight);
+            break;
+        case OP_LESS:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitLess);
+            break;
+        case OP_LESS_EQUAL:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitLessEqual);
+            break;
+        case OP_GREATER:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitGreater);
+            break;
+        case OP_GREATER_EQUAL:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitGreaterEqual);
+            break;
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+            emitStackTopArg(&buf);
+            // mov esi, negated
+            emit8(&buf, 0xbe);
+            emit32(&buf, code[offset] == OP_NOT_EQUAL ? 1 : 0);
+            emitCall(&buf, (uintptr_t)jitEqual);
+            emitDeoptOnZero(&buf, &patches, offset);
+            emitTakeStackTop(&buf);
+            break;
+        case OP_NOT:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitNot);
+            break;
+        case OP_NEGATE:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitNegate);
+            break;
+        case OP_INCREMENT:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitIncrement);
+            break;
+        case OP_DECREMENT:
+            emitStackHelper(&buf, &patches, offset, (uintptr_t)jitDecrement);
+            break;
+        case OP_GET_LOCAL_CONSTANT_ADD: {
+            uint16_t slot     = readShort(code, offset + 1);
+            Value    constant = chunk->constants.values[readShort(code, offset + 3)];
+            emitStackTopArg(&buf);
+            // mov rsi, rbx; mov edx, slot; mov rcx, constant
+            emit8(&buf, 0x48);
+            emit8(&buf, 0x89);
+            emit8(&buf, 0xde);
+            emit8(&buf, 0xba);
+            emit32(&buf, slot);
+            emit8(&buf, 0x48);
+            emit8(&buf, 0xb9);
+            emit64(&buf, constant);
+            emitCall(&buf, (uintptr_t)jitLocalConstantAdd);
+            emitDeoptOnZero(&buf, &patches, offset);
+            emitTakeStackTop(&buf);
+            break;
+        }
+        case OP_INCREMENT_SET_LOCAL_POP: {
+            uint16_t slot = readShort(code, offset + 1);
+            emitStackTopArg(&buf);
+            // mov rsi, rbx; mov edx, slot
+            emit8(&buf, 0x48);
+            emit8(&buf, 0x89);
+            emit8(&buf, 0xde);
+            emit8(&buf, 0xba);
+            emit32(&buf, slot);
+            emitCall(&buf, (uintptr_t)jitIncrementSetLocalPop);
+            emitDeoptOnZero(&buf, &patches, offset);
+            emitTakeStackTop(&buf);
+            break;
+        }
+        case OP_GET_GLOBAL: {
+            emitStackTopArg(&buf);
+            emit8(&buf, 0xbe); // mov esi, slot
+            emit32(&buf, readShort(code, offset + 1));
+            emitCall(&buf, (uintptr_t)jitGetGlobal);
+            emitDeoptOnZero(&buf, &patches, offset);
+            emitTakeStackTop(&buf);
+            break;
+        }
+        case OP_GET_GLOBAL_2:
+        case OP_GET_GLOBAL_3:
+        case OP_GET_GLOBAL_4: {
+            const uintptr_t       helpers[]   = { (uintptr_t)jitGetGlobal2, (uintptr_t)jitGetGlobal3, (uintptr_t)jitGetGlobal4 };
+            static const uint8_t  argOps[][2] = { { 0xbe, 0 }, { 0xba, 0 }, { 0xb9, 0 }, { 0xb8, 1 } };
+            int                   slots      = 2 + (code[offset] - OP_GET_GLOBAL_2);
+            emitStackTopArg(&buf);
+            for (int i = 0; i < slots; i++) {
+                // mov esi/edx/ecx/r8d, slot
+                if (argOps[i][1])
+                    emit8(&buf, 0x41);
+                emit8(&buf, argOps[i][0]);
+                emit32(&buf, readShort(code, offset + 1 + i * 2));
+            }
+            emitCall(&buf, helpers[slots - 2]);
+            emitDeoptOnZero(&buf, &patches, offset);
+            emitTakeStackTop(&buf);
+            break;
+        }
+        case OP_JUMP: {
+            uint16_t jump = readShort(code, offset + 1);
+            emit8(&buf, 0xe9);
+            addPatch(&jumps, buf.count, offset + 3 + jump);
+            emit32(&buf, 0);
+            break;
+        }
+        case OP_LOOP: {
+            uint16_t jump = readShort(code, offset + 1);
+            emit8(&buf, 0xe9);
+            addPatch(&jumps, buf.count, offset + 3 - jump);
+            emit32(&buf, 0);
+            break;
+        }
+        case OP_JUMP_IF_FALSE: {
+            // Falsey is nil or false; compare against both immediates and
+            // branch without disturbing the stack, like the interpreter.
+            uint16_t jump   = readShort(code, offset + 1);
+            int32_t  target = offset + 3 + jump;
+            // mov rax, [r13-8]
+            emit8(&buf, 0x49);
+            emit8(&buf, 0x8b);
+            emit8(&buf, 0x45);
+            emit8(&buf, 0xf8);
+            for (int pass = 0; pass < 2; pass++) {
+                // mov rcx, NIL_VAL / FALSE_VAL; cmp rax, rcx; je target
+                emit8(&buf, 0x48);
+                emit8(&buf, 0xb9);
+                emit64(&buf, pass == 0 ? NIL_VAL : FALSE_VAL);
+                emit8(&buf, 0x48);
+                emit8(&buf, 0x39);
+                emit8(&buf, 0xc8);
+                emit8(&buf, 0x0f);
+                emit8(&buf, 0x84);
+                addPatch(&jumps, buf.count, target);
+                emit32(&buf, 0);
+            }
+            break;
+        }
+        case OP_LESS_JUMP_IF_FALSE: {
+            uint16_t jump = readShort(code, offset + 1);
+            emitStackTopArg(&buf);
+            emitCall(&buf, (uintptr_t)jitLessJump);
+            emitDeoptOnZero(&buf, &patches, offset);
+            // mov rcx, rax; and rax, -2; mov r13, rax; test cl, 1; jnz target
+            emit8(&buf, 0x48);
+            emit8(&buf, 0x89);
+            emit8(&buf, 0xc1);
+            emit8(&buf, 0x48);
+            emit8(&buf, 0x83);
+            emit8(&buf, 0xe0);
+            emit8(&buf, 0xfe);
+            emitTakeStackTop(&buf);
+            emit8(&buf, 0xf6);
+            emit8(&buf, 0xc1);
+            emit8(&buf, 0x01);
+            emit8(&buf, 0x0f);
+            emit8(&buf, 0x85);
+            addPatch(&jumps, buf.count, offset + 4 + jump);
+            emit32(&buf, 0);
+            break;
+        }
+        case OP_FOR_LOOP: {
+            uint16_t slot         = readShort(code, offset + 1);
+            uint8_t  limitIsConst = code[offset + 3];
+            uint16_t limitArg     = readShort(code, offset + 4);
+            uint16_t back         = readShort(code, offset + 6);
+            Value    limitConst   = limitIsConst ? chunk->constants.values[limitArg] : NIL_VAL;
+            // mov rdi, rbx; mov esi, slot; mov rdx, limitConst;
+            // mov ecx, limitArg; mov r8d, limitIsConst
+            emit8(&buf, 0x48);
+            emit8(&buf, 0x89);
+            emit8(&buf, 0xdf);
+            emit8(&buf, 0xbe);
+            emit32(&buf, slot);
+            emit8(&buf, 0x48);
+            emit8(&buf, 0xba);
+            emit64(&buf, limitConst);
+            emit8(&buf, 0xb9);
+            emit32(&buf, limitArg);
+            emit8(&buf, 0x41);
+            emit8(&buf, 0xb8);
+            emit32(&buf, limitIsConst);
+            emitCall(&buf, (uintptr_t)jitForLoop);
+            emitDeoptOnZero(&buf, &patches, offset);
+            // cmp eax, 2; je back edge
+            emit8(&buf, 0x83);
+            emit8(&buf, 0xf8);
+            emit8(&buf, 0x02);
+            emit8(&buf, 0x0f);
+            emit8(&buf, 0x84);
+            addPatch(&jumps, buf.count, offset + 8 - back);
+            emit32(&buf, 0);
+            break;
+        }
+        default:
+            // Everything that can call, allocate, error or touch objects
+            // runs in the interpreter.
+            emitDeopt(&buf, &patches, offset);
+            deoptStubs++;
+            if (offset == 0)
+                entryDeopts = true;
+            break;
+        }
+
+        instructions++;
+        offset += length;
+    }
+
+    // Entry is the only way in (no on-stack replacement), so a function
+    // whose first opcode deopts — or one that is mostly deopt stubs — would
+    // charge every call the native round trip for nothing. Leave those to
+    // the interpreter.
+    if (entryDeopts || deoptStubs * 2 > instructions) {
+        reject = true;
+    }
+
+    // Epilogue: flush the stack top and return the resume offset in eax.
+    int32_t epilogue = (int32_t)buf.count;
+    emit8(&buf, 0x4d);
+    emit8(&buf, 0x89);
+    emit8(&buf, 0x2c);
+    emit8(&buf, 0x24);
+    emit8(&buf, 0x41);
+    emit8(&buf, 0x5d);
+    emit8(&buf, 0x41);
+    emit8(&buf, 0x5c);
+    emit8(&buf, 0x5b);
+    emit8(&buf, 0xc3);
+
+    if (!reject && buf.ok) {
+        for (int i = 0; i < patches.count && !reject; i++) {
+            int32_t rel = epilogue - (int32_t)(patches.patches[i].at + 4);
+            memcpy(buf.bytes + patches.patches[i].at, &rel, sizeof(rel));
+        }
+        for (int i = 0; i < jumps.count && !reject; i++) {
+            int32_t targetBc = jumps.patches[i].targetBc;
+            if (targetBc < 0 || targetBc >= count || nativeOffset[targetBc] < 0) {
+                reject = true;
+                break;
+            }
+            int32_t rel = nativeOffset[targetBc] - (int32_t)(jumps.patches[i].at + 4);
+            memcpy(buf.bytes + jumps.patches[i].at, &rel, sizeof(rel));
+        }
+    }
+
+    if (!reject && buf.ok) {
+        void* mapped = mmap(NULL, buf.count, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped != MAP_FAILED) {
+            memcpy(mapped, buf.bytes, buf.count);
+            if (mprotect(mapped, buf.count, PROT_READ | PROT_EXEC) == 0) {
+                JitCode* jit = malloc(sizeof(JitCode));
+                if (jit != NULL) {
+                    jit->code     = mapped;
+                    jit->size     = buf.count;
+                    function->jit = jit;
+                } else {
+                    munmap(mapped, buf.count);
+                }
+            } else {
+                munmap(mapped, buf.count);
+            }
+        }
+    }
+
+    free(buf.bytes);
+    free(jumps.patches);
+    free(patches.patches);
+    free(nativeOffset);
+}
+
+int jitEnter(ObjFunction* function, Value* slots, Value** stackTop)
+{
+    typedef int (*JitEntry)(Value* slots, Value** stackTop);
+    return ((JitEntry)(uintptr_t)function->jit->code)(slots, stackTop);
+}
+
+void jitFree(ObjFunction* function)
+{
+    if (!jitReady(function->jit))
+        return;
+    munmap(function->jit->code, function->jit->size);
+    free(function->jit);
+    function->jit = NULL;
+}
+
+#else
+
+void jitCompile(ObjFunction* function)
+{
+    function->jit = JIT_REJECTED;
+}
+
+int jitEnter(ObjFunction* function, Value* slots, Value** stackTop)
+{
+    UNUSED(function);
+    UNUSED(slots);
+    UNUSED(stackTop);
+    return 0;
+}
+
+void jitFree(ObjFunction* function)
+{
+    UNUSED(function);
+}
+
+#endif
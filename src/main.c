@@ -30,7 +30,7 @@ static void runFile(const char* path)
 
 int main(int argc, const char* argv[])
 {
-    initVM();
+    initVM(0, 0);
 
     if (argc == 1) {
         repl();
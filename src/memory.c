@@ -1,12 +1,146 @@
 #include "memory.h"
 #include "compiler.h"
+#include "jit.h"
 #include "vm.h"
+#include <sys/mman.h>
+#include <time.h>
 
 #ifdef DEBUG_LOG_GC
 #include "debug.h"
 #endif
 
 #define GC_HEAP_GROW_FACTOR 2
+#define GC_NURSERY_SIZE (256 * 1024)
+// Marking budget of one increment of a major cycle, per allocation event.
+#define GC_PAUSE_BUDGET_NS (200 * 1000)
+
+static void beginMark(void);
+static void incrementalMark(void);
+
+// Telemetry is per VM like the collector itself; reading it costs nothing
+// beyond the clock_gettime calls around each phase.
+static __thread GcStats stats;
+
+const GcStats* gcStats(void)
+{
+    return &stats;
+}
+
+static uint64_t nowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void recordPause(uint64_t ns)
+{
+    stats.totalPauseNs += ns;
+    if (ns > stats.maxPauseNs)
+        stats.maxPauseNs = ns;
+}
+
+// Small allocations are served from per-size-class freelists carved out of
+// slab pages instead of going to the system allocator. Blocks are 16-byte
+// granular up to 256 bytes, which covers every Obj header struct and the
+// small char/Entry arrays that dominate the allocation profile. The slab
+// registry stays sorted so poolOwns() can tell pool blocks from pointers
+// that entered the funnel via plain malloc (e.g. takeString buffers).
+//
+// The pool is thread-local, matching the __thread VM: worker isolates
+// allocate concurrently, and VM memory never crosses threads (messages
+// travel as plain malloc'd copies), so each thread owns its freelists and
+// slabs outright and the hot path stays lock-free. Slabs are not returned
+// when a worker thread exits — the same process-lifetime policy as before,
+// now bounded per isolate.
+#define POOL_ALIGN 16
+#define POOL_MAX_SIZE 256
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_CLASS_COUNT (POOL_MAX_SIZE / POOL_ALIGN)
+
+typedef struct PoolBlock {
+    struct PoolBlock* next;
+} PoolBlock;
+
+static __thread PoolBlock* poolClasses[POOL_CLASS_COUNT];
+static __thread char**     poolSlabs;
+static __thread int        poolSlabCount;
+static __thread int        poolSlabCapacity;
+
+static int poolClass(size_t size)
+{
+    return (int)((size + POOL_ALIGN - 1) / POOL_ALIGN) - 1;
+}
+
+static bool poolOwns(void* pointer)
+{
+    int lo = 0;
+    int hi = poolSlabCount - 1;
+    while (lo <= hi) {
+        int   mid  = (lo + hi) / 2;
+        char* base = poolSlabs[mid];
+        if ((char*)pointer < base) {
+            hi = mid - 1;
+        } else if ((char*)pointer >= base + POOL_SLAB_SIZE) {
+            lo = mid + 1;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Carve a fresh slab into blocks of one size class and thread them onto its
+// freelist. Slabs live for the whole process; freed blocks go back on the
+// list, never to the system allocator.
+static void poolGrow(int index)
+{
+    char* slab = (char*)malloc(POOL_SLAB_SIZE);
+    if (slab == NULL)
+        exit(1);
+
+    if (poolSlabCapacity < poolSlabCount + 1) {
+        poolSlabCapacity = poolSlabCapacity < 8 ? 8 : poolSlabCapacity * 2;
+        poolSlabs        = (char**)realloc(poolSlabs, sizeof(char*) * poolSlabCapacity);
+        if (poolSlabs == NULL)
+            exit(1);
+    }
+
+    // Keep the registry sorted for the membership binary search.
+    int at = poolSlabCount;
+    while (at > 0 && poolSlabs[at - 1] > slab) {
+        poolSlabs[at] = poolSlabs[at - 1];
+        at--;
+    }
+    poolSlabs[at] = slab;
+    poolSlabCount++;
+
+    size_t blockSize = (size_t)(index + 1) * POOL_ALIGN;
+    for (size_t offset = 0; offset + blockSize <= POOL_SLAB_SIZE; offset += blockSize) {
+        PoolBlock* block   = (PoolBlock*)(slab + offset);
+        block->next        = poolClasses[index];
+        poolClasses[index] = block;
+    }
+}
+
+static void* poolAlloc(size_t size)
+{
+    int index = poolClass(size);
+    if (poolClasses[index] == NULL)
+        poolGrow(index);
+
+    PoolBlock* block   = poolClasses[index];
+    poolClasses[index] = block->next;
+    return block;
+}
+
+static void poolRelease(void* pointer, size_t size)
+{
+    int        index   = poolClass(size);
+    PoolBlock* block   = (PoolBlock*)pointer;
+    block->next        = poolClasses[index];
+    poolClasses[index] = block;
+}
 
 void* reallocate(void* pointer, size_t oldSize, size_t newSize)
 {
@@ -16,16 +150,46 @@ void* reallocate(void* pointer, size_t oldSize, size_t newSize)
 #ifdef DEBUG_STRESS_GC
         collectGarbage();
 #endif
-        if (vm.bytesAllocated > vm.nextGC) {
+        if (vm.gcMarking) {
+            incrementalMark();
+        } else if (vm.bytesAllocated > vm.nextGC) {
+            beginMark();
+        } else if (vm.bytesAllocated > vm.oldBytes + GC_NURSERY_SIZE) {
             collectGarbage();
         }
     }
 
     if (newSize == 0) {
-        free(pointer);
+        if (pointer != NULL) {
+            if (poolOwns(pointer)) {
+                poolRelease(pointer, oldSize);
+            } else {
+                free(pointer);
+            }
+        }
         return NULL;
     }
 
+    if (pointer == NULL) {
+        void* result = newSize <= POOL_MAX_SIZE ? poolAlloc(newSize) : malloc(newSize);
+        if (result == NULL)
+            exit(1);
+        return result;
+    }
+
+    if (poolOwns(pointer)) {
+        // Same size class: the block already fits.
+        if (newSize <= POOL_MAX_SIZE && poolClass(newSize) == poolClass(oldSize))
+            return pointer;
+
+        void* result = newSize <= POOL_MAX_SIZE ? poolAlloc(newSize) : malloc(newSize);
+        if (result == NULL)
+            exit(1);
+        memcpy(result, pointer, oldSize < newSize ? oldSize : newSize);
+        poolRelease(pointer, oldSize);
+        return result;
+    }
+
     void* result = realloc(pointer, newSize);
 
     if (result == NULL)
@@ -53,10 +217,17 @@ static void freeObject(Obj* object)
     }
     case OBJ_INSTANCE: {
         ObjInstance* instance = (ObjInstance*)object;
-        freeTable(&instance->fields);
+        FREE_ARRAY(Value, instance->slots, instance->slotCapacity);
         FREE(ObjInstance, object);
         break;
     }
+    case OBJ_SHAPE: {
+        ObjShape* shape = (ObjShape*)object;
+        freeTable(&shape->edges);
+        freeTable(&shape->slots);
+        FREE(ObjShape, object);
+        break;
+    }
     case OBJ_CLOSURE: {
         ObjClosure* closure = (ObjClosure*)object;
         FREE_ARRAY(ObjUpvalue*, closure->upvalues, closure->upvalueCount);
@@ -65,6 +236,7 @@ static void freeObject(Obj* object)
     }
     case OBJ_FUNCTION: {
         ObjFunction* function = (ObjFunction*)object;
+        jitFree(function);
         freeChunk(&function->chunk);
         FREE(ObjFunction, object);
         break;
@@ -74,8 +246,20 @@ static void freeObject(Obj* object)
         break;
     case OBJ_STRING: {
         ObjString* string = (ObjString*)object;
-        FREE_ARRAY(char, string->chars, string->length + 1);
-        FREE(ObjString, object);
+        if (vm.indexCacheString == string)
+            vm.indexCacheString = NULL;
+        if (string->mapped) {
+            munmap(string->chars, string->length + 1);
+            FREE(ObjString, object);
+        } else if (string->buffer != NULL) {
+            releaseStringBuffer(string->buffer);
+            FREE(ObjString, object);
+        } else if (string->chars == string->embedded) {
+            reallocate(object, sizeof(ObjString) + string->length + 1, 0);
+        } else {
+            FREE_ARRAY(char, string->chars, string->length + 1);
+            FREE(ObjString, object);
+        }
         break;
     }
     case OBJ_UPVALUE:
@@ -92,14 +276,13 @@ static void freeObject(Obj* object)
 
 void freeObjects(void)
 {
-    Obj* object = vm.objects;
-    while (object != NULL) {
-        Obj* next = object->next;
-        freeObject(object);
-        object = next;
+    for (int i = 0; i < vm.objectCount; i++) {
+        freeObject(vm.objects[i]);
     }
 
+    free(vm.objects);
     free(vm.grayStack);
+    free(vm.rememberedSet);
 }
 
 void markObject(Obj* object)
@@ -110,6 +293,11 @@ void markObject(Obj* object)
     if (object->isMarked)
         return;
 
+    // Minor collections treat the whole old generation as live; young
+    // objects it points at are reached through the remembered set instead.
+    if (vm.gcMinor && object->isOld)
+        return;
+
 #ifdef DEBUG_LOG_GC
     printf("%p mark ", (void*)object);
     printValue(OBJ_VAL(object));
@@ -135,8 +323,45 @@ void markValue(Value value)
         markObject(AS_OBJ(value));
 }
 
+// Tri-color barrier: while incremental marking runs, gray any value being
+// stored into the heap so it cannot end up hidden behind a black object.
+void markWrite(Value value)
+{
+    if (vm.gcMarking)
+        markValue(value);
+}
+
+// Record an old object that just had a young value stored into it so minor
+// collections re-trace it. Mirrors the gray stack: plain realloc, because
+// growing the remembered set must never trigger a collection itself.
+void writeBarrier(Obj* owner, Value value)
+{
+    markWrite(value);
+
+    if (owner == NULL || !owner->isOld || owner->isRemembered)
+        return;
+
+    if (!IS_OBJ(value) || AS_OBJ(value)->isOld)
+        return;
+
+    owner->isRemembered = true;
+
+    if (vm.rememberedCapacity < vm.rememberedCount + 1) {
+        vm.rememberedCapacity = GROW_CAPACITY(vm.rememberedCapacity);
+        vm.rememberedSet      = (Obj**)realloc(vm.rememberedSet, sizeof(Obj*) * vm.rememberedCapacity);
+        if (vm.rememberedSet == NULL)
+            exit(1);
+    }
+
+    vm.rememberedSet[vm.rememberedCount++] = owner;
+}
+
 static void markArray(ValueArray* array)
 {
+    // An all-number array holds no heap references; nothing to trace.
+    if (array->allNumbers)
+        return;
+
     for (unsigned int i = 0; i < array->count; i++) {
         markValue(array->values[i]);
     }
@@ -160,14 +385,31 @@ static void blackenObject(Obj* object)
     case OBJ_CLASS: {
         ObjClass* klass = (ObjClass*)object;
         markObject((Obj*)klass->name);
+        markObject((Obj*)klass->superclass);
         markTable(&klass->methods);
         markTable(&klass->fields);
+        for (int i = 0; i < OPERATOR_COUNT; i++) {
+            markObject((Obj*)klass->operators[i]);
+        }
         break;
     }
     case OBJ_INSTANCE: {
         ObjInstance* instance = (ObjInstance*)object;
         markObject((Obj*)instance->klass);
-        markTable(&instance->fields);
+        markObject((Obj*)instance->shape);
+        if (instance->shape != NULL) {
+            for (int i = 0; i < instance->shape->slotCount; i++) {
+                markValue(instance->slots[i]);
+            }
+        }
+        break;
+    }
+    case OBJ_SHAPE: {
+        ObjShape* shape = (ObjShape*)object;
+        markObject((Obj*)shape->parent);
+        markValue(shape->name);
+        markTable(&shape->edges);
+        markTable(&shape->slots);
         break;
     }
     case OBJ_CLOSURE: {
@@ -181,7 +423,18 @@ static void blackenObject(Obj* object)
     case OBJ_FUNCTION: {
         ObjFunction* function = (ObjFunction*)object;
         markObject((Obj*)function->name);
+        markObject((Obj*)function->sharedClosure);
         markArray(&function->chunk.constants);
+        for (int i = 0; i < function->chunk.switchTableCount; i++) {
+            markTable(&function->chunk.switchTables[i].offsets);
+        }
+        for (int i = 0; i < function->chunk.cacheCount; i++) {
+            InlineCache* cache = &function->chunk.caches[i];
+            for (int j = 0; j < CACHE_ENTRIES; j++) {
+                markObject(cache->entries[j].klass);
+                markValue(cache->entries[j].value);
+            }
+        }
         break;
     }
     case OBJ_UPVALUE:
@@ -220,7 +473,14 @@ static void markRoots(void)
     }
 
     markTable(&vm.globals);
+    markTable(&vm.globalIndexes);
+    markArray(&vm.globalSlots);
+    markArray(&vm.globalNames);
+    markTable(&vm.modules);
+    markObject((Obj*)vm.rootShape);
     markCompilerRoots();
+    markLoopRoots();
+    markProfilerRoots();
     markObject((Obj*)vm.initString);
     markObject((Obj*)vm.strString);
     markObject((Obj*)vm.addString);
@@ -228,8 +488,11 @@ static void markRoots(void)
     markObject((Obj*)vm.mulString);
     markObject((Obj*)vm.divString);
     markObject((Obj*)vm.gtString);
+    markObject((Obj*)vm.gteString);
     markObject((Obj*)vm.ltString);
+    markObject((Obj*)vm.lteString);
     markObject((Obj*)vm.eqString);
+    markObject((Obj*)vm.neqString);
     markObject((Obj*)vm.andString);
     markObject((Obj*)vm.orString);
     markObject((Obj*)vm.xorString);
@@ -247,42 +510,193 @@ static void traceReferences(void)
     }
 }
 
+// Gray every remembered object so its young referents get traced. The
+// objects themselves are old and therefore live for this collection.
+static void markRemembered(void)
+{
+    for (int i = 0; i < vm.rememberedCount; i++) {
+        Obj* object      = vm.rememberedSet[i];
+        object->isMarked = true;
+
+        if (vm.grayCapacity < vm.grayCount + 1) {
+            vm.grayCapacity = GROW_CAPACITY(vm.grayCapacity);
+            vm.grayStack    = (Obj**)realloc(vm.grayStack, sizeof(Obj*) * vm.grayCapacity);
+        }
+
+        if (vm.grayStack == NULL)
+            exit(1);
+
+        vm.grayStack[vm.grayCount++] = object;
+    }
+}
+
+// Every minor collection promotes all survivors, so afterwards no old
+// object can point at a young one and the set can be dropped wholesale.
+static void clearRemembered(void)
+{
+    for (int i = 0; i < vm.rememberedCount; i++) {
+        vm.rememberedSet[i]->isMarked     = false;
+        vm.rememberedSet[i]->isRemembered = false;
+    }
+    vm.rememberedCount = 0;
+}
+
+// Drop the set without touching mark bits; used while finishing a major
+// cycle, where the marks still decide what the sweep keeps.
+static void resetRemembered(void)
+{
+    for (int i = 0; i < vm.rememberedCount; i++) {
+        vm.rememberedSet[i]->isRemembered = false;
+    }
+    vm.rememberedCount = 0;
+}
+
+// Sweep the young region of the object registry; a major collection scans
+// from the start. Survivors are promoted and compacted in place either way.
 static void sweep(void)
 {
-    Obj* previous = NULL;
-    Obj* object   = vm.objects;
-    while (object != NULL) {
+    int start = vm.gcMinor ? vm.oldCount : 0;
+    int out   = start;
+    for (int i = start; i < vm.objectCount; i++) {
+        Obj* object = vm.objects[i];
         if (object->isMarked) {
-            object->isMarked = false;
-            previous         = object;
-            object           = object->next;
+            object->isMarked  = false;
+            object->isOld     = true;
+            vm.objects[out++] = object;
         } else {
-            Obj* unreached = object;
-            object         = object->next;
-            if (previous != NULL) {
-                previous->next = object;
-            } else {
-                vm.objects = object;
-            }
-
-            freeObject(unreached);
+            freeObject(object);
         }
     }
+
+    vm.objectCount = out;
 }
 
-void collectGarbage(void)
+// Open an incremental major cycle: gray the roots now, let allocation
+// events drain the gray stack in bounded slices.
+static void beginMark(void)
 {
+    uint64_t start = nowNs();
+
+    clearRemembered();
+    vm.gcMarking = true;
+    markRoots();
+
+    stats.markNs += nowNs() - start;
+    recordPause(nowNs() - start);
+
 #ifdef DEBUG_LOG_GC
-    printf("-- gc begin\n");
-    size_t before = vm.bytesAllocated;
+    printf("-- gc incremental mark begin\n");
 #endif
+}
 
+// Close the cycle: the mutator may have moved references around since the
+// roots were grayed, so re-scan them, drain what remains and sweep.
+static void finishMark(void)
+{
+    uint64_t start = nowNs();
     markRoots();
+    uint64_t marked = nowNs();
     traceReferences();
+    uint64_t traced = nowNs();
     tableRemoveWhite(&vm.strings);
+    resetRemembered();
+    vm.gcMarking = false;
     sweep();
+    uint64_t swept = nowNs();
+
+    stats.markNs += marked - start;
+    stats.traceNs += traced - marked;
+    stats.sweepNs += swept - traced;
+    stats.majorCollections++;
+    recordPause(swept - start);
+
+    vm.nextGC     = vm.bytesAllocated * GC_HEAP_GROW_FACTOR;
+    vm.oldCount = vm.objectCount;
+    vm.oldBytes   = vm.bytesAllocated;
+
+#ifdef DEBUG_LOG_GC
+    printf("-- gc incremental mark end (%zu bytes, next at %zu)\n",
+        vm.bytesAllocated, vm.nextGC);
+#endif
+}
+
+// One marking slice. Blackens gray objects until the pause budget runs out,
+// checking the clock every few objects; an empty work list ends the cycle.
+static void incrementalMark(void)
+{
+    uint64_t start = nowNs();
 
-    vm.nextGC = vm.bytesAllocated * GC_HEAP_GROW_FACTOR;
+    int processed = 0;
+    while (vm.grayCount > 0) {
+        Obj* object = vm.grayStack[--vm.grayCount];
+        blackenObject(object);
+
+        if ((++processed & 63) == 0) {
+            uint64_t elapsed = nowNs() - start;
+            if (elapsed > GC_PAUSE_BUDGET_NS) {
+                stats.traceNs += elapsed;
+                recordPause(elapsed);
+                return;
+            }
+        }
+    }
+
+    uint64_t elapsed = nowNs() - start;
+    stats.traceNs += elapsed;
+    recordPause(elapsed);
+
+    finishMark();
+}
+
+void collectGarbage(void)
+{
+    // A stop-the-world request while a cycle is open just runs it to the end.
+    if (vm.gcMarking) {
+        finishMark();
+        return;
+    }
+
+    vm.gcMinor = vm.bytesAllocated <= vm.nextGC;
+
+#ifdef DEBUG_LOG_GC
+    printf("-- gc begin (%s)\n", vm.gcMinor ? "minor" : "major");
+    size_t before = vm.bytesAllocated;
+#endif
+
+    uint64_t start = nowNs();
+    if (vm.gcMinor) {
+        markRoots();
+        markRemembered();
+        uint64_t marked = nowNs();
+        traceReferences();
+        uint64_t traced = nowNs();
+        tableRemoveWhite(&vm.strings);
+        sweep();
+        clearRemembered();
+        stats.markNs += marked - start;
+        stats.traceNs += traced - marked;
+        stats.sweepNs += nowNs() - traced;
+        stats.minorCollections++;
+    } else {
+        clearRemembered();
+        markRoots();
+        uint64_t marked = nowNs();
+        traceReferences();
+        uint64_t traced = nowNs();
+        tableRemoveWhite(&vm.strings);
+        sweep();
+        stats.markNs += marked - start;
+        stats.traceNs += traced - marked;
+        stats.sweepNs += nowNs() - traced;
+        stats.majorCollections++;
+        vm.nextGC = vm.bytesAllocated * GC_HEAP_GROW_FACTOR;
+    }
+    recordPause(nowNs() - start);
+
+    // Everything that survived is old now.
+    vm.oldCount = vm.objectCount;
+    vm.oldBytes   = vm.bytesAllocated;
+    vm.gcMinor    = false;
 
 #ifdef DEBUG_LOG_GC
     printf("-- gc end\n");
@@ -291,3 +705,135 @@ void collectGarbage(void)
         vm.nextGC);
 #endif
 }
+
+// Shallow footprint of one object: the header struct plus the arrays it
+// owns directly, mirroring freeObject's accounting. Shared string buffers
+// and file mappings are charged to nobody, matching the GC's own books.
+static size_t objectSize(Obj* object)
+{
+    switch (object->type) {
+    case OBJ_BOUND_METHOD:
+        return sizeof(ObjBoundMethod);
+    case OBJ_CLASS: {
+        ObjClass* klass = (ObjClass*)object;
+        return sizeof(ObjClass)
+            + klass->methods.capacity * sizeof(Entry)
+            + klass->fields.capacity * sizeof(Entry);
+    }
+    case OBJ_CLOSURE: {
+        ObjClosure* closure = (ObjClosure*)object;
+        return sizeof(ObjClosure) + closure->upvalueCount * sizeof(ObjUpvalue*);
+    }
+    case OBJ_FUNCTION: {
+        ObjFunction* function = (ObjFunction*)object;
+        return sizeof(ObjFunction)
+            + function->chunk.capacity
+            + function->chunk.constants.capacity * sizeof(Value);
+    }
+    case OBJ_INSTANCE: {
+        ObjInstance* instance = (ObjInstance*)object;
+        return sizeof(ObjInstance) + instance->slotCapacity * sizeof(Value);
+    }
+    case OBJ_NATIVE:
+        return sizeof(ObjNative);
+    case OBJ_STRING: {
+        ObjString* string = (ObjString*)object;
+        if (string->mapped || string->buffer != NULL)
+            return sizeof(ObjString);
+        return sizeof(ObjString) + string->length + 1;
+    }
+    case OBJ_UPVALUE:
+        return sizeof(ObjUpvalue);
+    case OBJ_TABLE: {
+        ObjTable* table = (ObjTable*)object;
+        return sizeof(ObjTable) + table->table.capacity * sizeof(Entry);
+    }
+    case OBJ_ARRAY: {
+        ObjArray* array = (ObjArray*)object;
+        return sizeof(ObjArray) + array->array.capacity * sizeof(Value);
+    }
+    case OBJ_SHAPE: {
+        ObjShape* shape = (ObjShape*)object;
+        return sizeof(ObjShape)
+            + shape->edges.capacity * sizeof(Entry)
+            + shape->slots.capacity * sizeof(Entry);
+    }
+    }
+    return 0;
+}
+
+void heapSnapshot(FILE* out)
+{
+    // Indexed by ObjType.
+    static const char* typeNames[] = {
+        "bound_method", "class", "closure", "function", "instance",
+        "native", "string", "upvalue", "table", "array", "shape"
+    };
+#define TYPE_COUNT ((int)(sizeof(typeNames) / sizeof(typeNames[0])))
+
+    size_t counts[TYPE_COUNT] = { 0 };
+    size_t bytes[TYPE_COUNT]  = { 0 };
+
+    // Per-class instance census; the class list grows with the system
+    // allocator so the walk never disturbs the GC's accounting.
+    ObjClass** classes       = NULL;
+    size_t*    classCounts   = NULL;
+    size_t*    classBytes    = NULL;
+    int        classCount    = 0;
+    int        classCapacity = 0;
+
+    for (int i = 0; i < vm.objectCount; i++) {
+        Obj*   object = vm.objects[i];
+        size_t size   = objectSize(object);
+        counts[object->type]++;
+        bytes[object->type] += size;
+
+        if (object->type != OBJ_INSTANCE)
+            continue;
+
+        ObjClass* klass = ((ObjInstance*)object)->klass;
+        int       slot  = 0;
+        while (slot < classCount && classes[slot] != klass)
+            slot++;
+        if (slot == classCount) {
+            if (classCount == classCapacity) {
+                classCapacity = classCapacity < 8 ? 8 : classCapacity * 2;
+                classes       = realloc(classes, sizeof(ObjClass*) * classCapacity);
+                classCounts   = realloc(classCounts, sizeof(size_t) * classCapacity);
+                classBytes    = realloc(classBytes, sizeof(size_t) * classCapacity);
+                if (classes == NULL || classCounts == NULL || classBytes == NULL)
+                    exit(1);
+            }
+            classes[slot]     = klass;
+            classCounts[slot] = 0;
+            classBytes[slot]  = 0;
+            classCount++;
+        }
+        classCounts[slot]++;
+        classBytes[slot] += size;
+    }
+
+    fprintf(out, "bytesAllocated %zu\nnextGC %zu\nobjects %d\n\n",
+        vm.bytesAllocated, vm.nextGC, vm.objectCount);
+
+    fprintf(out, "type count bytes\n");
+    for (int i = 0; i < TYPE_COUNT; i++) {
+        if (counts[i] == 0)
+            continue;
+        fprintf(out, "%s %zu %zu\n", typeNames[i], counts[i], bytes[i]);
+    }
+
+    if (classCount > 0) {
+        fprintf(out, "\nclass count bytes\n");
+        for (int i = 0; i < classCount; i++) {
+            fprintf(out, "%s %zu %zu\n", classes[i]->name->chars,
+                classCounts[i], classBytes[i]);
+        }
+    }
+
+#undef TYPE_COUNT
+
+    free(classes);
+    free(classCounts);
+    free(classBytes);
+}
@@ -1,4 +1,5 @@
 #include "native/array.h"
+#include "memory.h"
 
 bool array_length(int argCount, Value* args)
 {
@@ -17,6 +18,7 @@ bool array_push(int argCount, Value* args)
 
     ObjArray* array = phelt_toArray(0);
     writeValueArray(&array->array, phelt_value(1));
+    writeBarrier((Obj*)array, phelt_value(1));
     return true;
 }
 
@@ -50,6 +52,7 @@ bool array_insert(int argCount, Value* args)
     }
 
     writeValueArrayAt(&array->array, phelt_value(2), index);
+    writeBarrier((Obj*)array, phelt_value(2));
     return true;
 }
 
@@ -71,35 +74,189 @@ bool array_remove(int argCount, Value* args)
     return true;
 }
 
+typedef struct {
+    ObjClosure* cmp;     // comparator closure, or NULL for a native order
+    bool        numeric; // without a comparator: number order or string order
+} SortOrder;
+
+// Does a sort strictly before b? The script comparator keeps its historical
+// meaning of "should a come after b" (matching the old swap loop), so it is
+// asked with the operands flipped. The native orders compare doubles
+// directly, or interned string pointers then bytes.
+static bool sortBefore(Value a, Value b, SortOrder* order)
+{
+    if (order->cmp == NULL) {
+        if (order->numeric)
+            return AS_NUMBER(a) < AS_NUMBER(b);
+
+        ObjString* first  = AS_STRING(a);
+        ObjString* second = AS_STRING(b);
+        if (first == second)
+            return false;
+
+        int shorter = first->length < second->length ? first->length : second->length;
+        int diff    = memcmp(first->chars, second->chars, shorter);
+        if (diff != 0)
+            return diff < 0;
+        return first->length < second->length;
+    }
+
+    push(b);
+    push(a);
+    phelt_callClosure(order->cmp, 2);
+    pop();                 // pop values
+    pop();                 // pop values
+    return AS_BOOL(pop()); // pop result
+}
+
+// The element buffer is re-read through the array on every access: a script
+// comparator can push onto the array under our feet and move it.
+#define SORT_AT(array, i) ((array)->array.values[(i)])
+
+static void sortSwap(ObjArray* array, int i, int j)
+{
+    Value temp        = SORT_AT(array, i);
+    SORT_AT(array, i) = SORT_AT(array, j);
+    SORT_AT(array, j) = temp;
+}
+
+static void insertionSort(ObjArray* array, int lo, int hi, SortOrder* order)
+{
+    for (int i = lo + 1; i <= hi; i++) {
+        int j = i;
+        while (j > lo && sortBefore(SORT_AT(array, j), SORT_AT(array, j - 1), order)) {
+            sortSwap(array, j, j - 1);
+            j--;
+        }
+    }
+}
+
+static void siftDown(ObjArray* array, int lo, int root, int count, SortOrder* order)
+{
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= count)
+            return;
+        if (child + 1 < count
+            && sortBefore(SORT_AT(array, lo + child), SORT_AT(array, lo + child + 1), order))
+            child++;
+        if (!sortBefore(SORT_AT(array, lo + root), SORT_AT(array, lo + child), order))
+            return;
+        sortSwap(array, lo + root, lo + child);
+        root = child;
+    }
+}
+
+static void heapSort(ObjArray* array, int lo, int hi, SortOrder* order)
+{
+    int count = hi - lo + 1;
+    for (int i = count / 2 - 1; i >= 0; i--)
+        siftDown(array, lo, i, count, order);
+    for (int i = count - 1; i > 0; i--) {
+        sortSwap(array, lo, lo + i);
+        siftDown(array, lo, 0, i, order);
+    }
+}
+
+static int partition(ObjArray* array, int lo, int hi, SortOrder* order)
+{
+    // Median-of-three pivot, parked at hi - 1. The scan bounds also keep an
+    // inconsistent script comparator from walking off the range.
+    int mid = lo + (hi - lo) / 2;
+    if (sortBefore(SORT_AT(array, mid), SORT_AT(array, lo), order))
+        sortSwap(array, lo, mid);
+    if (sortBefore(SORT_AT(array, hi), SORT_AT(array, lo), order))
+        sortSwap(array, lo, hi);
+    if (sortBefore(SORT_AT(array, hi), SORT_AT(array, mid), order))
+        sortSwap(array, mid, hi);
+    sortSwap(array, mid, hi - 1);
+
+    int i = lo;
+    int j = hi - 1;
+    for (;;) {
+        do {
+            i++;
+        } while (i < hi - 1 && sortBefore(SORT_AT(array, i), SORT_AT(array, hi - 1), order));
+        do {
+            j--;
+        } while (j > lo && sortBefore(SORT_AT(array, hi - 1), SORT_AT(array, j), order));
+        if (i >= j)
+            break;
+        sortSwap(array, i, j);
+    }
+
+    sortSwap(array, i, hi - 1);
+    return i;
+}
+
+// Introsort: quicksort that falls back to heapsort past the depth limit and
+// to insertion sort on short spans, so every comparator stays O(n log n).
+static void introSort(ObjArray* array, int lo, int hi, int depth, SortOrder* order)
+{
+    while (hi - lo > 16) {
+        if (depth == 0) {
+            heapSort(array, lo, hi, order);
+            return;
+        }
+        depth--;
+
+        int p = partition(array, lo, hi, order);
+        if (p - lo < hi - p) {
+            introSort(array, lo, p - 1, depth, order);
+            lo = p + 1;
+        } else {
+            introSort(array, p + 1, hi, depth, order);
+            hi = p - 1;
+        }
+    }
+    insertionSort(array, lo, hi, order);
+}
+
 bool array_sort(int argCount, Value* args)
 {
-    phelt_checkArgs(2);
+    phelt_checkMinArgs(1);
     phelt_checkArray(0);
-    phelt_checkClosure(1);
 
-    ObjArray*   array = phelt_toArray(0);
-    ObjClosure* func  = phelt_toClosure(1);
+    ObjArray* array = phelt_toArray(0);
 
-    if (array->array.count == 0) {
-        return true;
-    }
+    SortOrder order;
+    order.cmp     = NULL;
+    order.numeric = true;
+
+    if (argCount >= 2) {
+        phelt_checkClosure(1);
+        order.cmp = phelt_toClosure(1);
+    } else if (!array->array.allNumbers) {
+        // The flag is conservative, so scan: all numbers and all strings
+        // both have a native order, anything mixed needs a comparator.
+        bool numbers = true;
+        bool strings = true;
+        for (unsigned int i = 0; i < array->array.count; i++) {
+            if (!IS_NUMBER(array->array.values[i]))
+                numbers = false;
+            if (!IS_STRING(array->array.values[i]))
+                strings = false;
+        }
 
-    for (unsigned int i = 0; i < array->array.count - 1; i++) {
-        for (unsigned int j = i + 1; j < array->array.count; j++) {
-            push(array->array.values[i]);
-            push(array->array.values[j]);
-            phelt_callClosure(func, 2);
-            pop();                        // pop values
-            pop();                        // pop values
-            bool result = AS_BOOL(pop()); // pop result
-            if (result) {
-                Value temp             = array->array.values[i];
-                array->array.values[i] = array->array.values[j];
-                array->array.values[j] = temp;
-            }
+        if (numbers) {
+            order.numeric = true;
+        } else if (strings) {
+            order.numeric = false;
+        } else {
+            phelt_error("Sorting a mixed array requires a comparator.");
+            return false;
         }
     }
 
+    if (array->array.count < 2) {
+        return true;
+    }
+
+    int depth = 0;
+    for (unsigned int n = array->array.count; n > 1; n >>= 1)
+        depth++;
+
+    introSort(array, 0, (int)array->array.count - 1, 2 * depth, &order);
     return true;
 }
 
@@ -178,9 +335,13 @@ bool array_map(int argCount, Value* args)
     ObjArray*   array = phelt_toArray(0);
     ObjClosure* func  = phelt_toClosure(1);
 
-    ObjArray* mapped       = newArray();
+    // The result array stays rooted on the stack while the closure runs, and
+    // its count only covers slots that already hold a result so a collection
+    // mid-loop never scans uninitialized values.
+    ObjArray* mapped = newArray();
+    push(OBJ_VAL(mapped));
     mapped->array.capacity = array->array.capacity;
-    mapped->array.count    = array->array.count;
+    mapped->array.count    = 0;
     mapped->array.values   = ALLOCATE(Value, array->array.capacity);
 
     for (unsigned int i = 0; i < array->array.count; i++) {
@@ -188,8 +349,13 @@ bool array_map(int argCount, Value* args)
         phelt_callClosure(func, 1);
         pop();                           // pop value
         mapped->array.values[i] = pop(); // pop result
+        mapped->array.count++;
+        if (!IS_NUMBER(mapped->array.values[i]))
+            mapped->array.allNumbers = false;
+        writeBarrier((Obj*)mapped, mapped->array.values[i]);
     }
 
+    pop();
     phelt_pushObject(-1, mapped);
     return true;
 }
@@ -203,7 +369,8 @@ bool array_filter(int argCount, Value* args)
     ObjArray*   array = phelt_toArray(0);
     ObjClosure* func  = phelt_toClosure(1);
 
-    ObjArray* filtered       = newArray();
+    ObjArray* filtered = newArray();
+    push(OBJ_VAL(filtered));
     filtered->array.capacity = array->array.capacity;
     filtered->array.count    = 0;
     filtered->array.values   = ALLOCATE(Value, array->array.capacity);
@@ -215,9 +382,11 @@ bool array_filter(int argCount, Value* args)
         bool result = AS_BOOL(pop()); // pop result
         if (result) {
             writeValueArray(&filtered->array, array->array.values[i]);
+            writeBarrier((Obj*)filtered, array->array.values[i]);
         }
     }
 
+    pop();
     phelt_pushObject(-1, filtered);
     return true;
 }
@@ -264,8 +433,13 @@ bool array_flatten(int argCount, Value* args)
     bool      hadSubArrays = false;
     int       currentDepth = 0;
 
+    // Each pass keeps its result rooted; the previous pass (the source of
+    // the copies) is only dropped once the new one is fully built.
+    push(phelt_value(0));
+
     do {
-        ObjArray* current       = newArray();
+        ObjArray* current = newArray();
+        push(OBJ_VAL(current));
         current->array.capacity = array->array.capacity;
         current->array.count    = 0;
         current->array.values   = ALLOCATE(Value, array->array.capacity);
@@ -276,18 +450,394 @@ bool array_flatten(int argCount, Value* args)
                 ObjArray* subArray = AS_ARRAY(array->array.values[i]);
                 for (unsigned int j = 0; j < subArray->array.count; j++) {
                     writeValueArray(&current->array, subArray->array.values[j]);
+                    writeBarrier((Obj*)current, subArray->array.values[j]);
                 }
                 hadSubArrays = true;
             } else {
                 writeValueArray(&current->array, array->array.values[i]);
+                writeBarrier((Obj*)current, array->array.values[i]);
             }
         }
 
+        vm.stackTop[-2] = vm.stackTop[-1];
+        vm.stackTop--;
+
         array     = current;
         flattened = array;
         currentDepth++;
     } while ((currentDepth < depth || depth == -1) && hadSubArrays);
 
+    pop();
     phelt_pushObject(-1, flattened);
     return true;
 }
+
+// ---------------------------------------------------------------------------
+// Parallel map/filter/reduce.
+//
+// A persistent thread pool (sized to the online core count, built on first
+// use) partitions the source ValueArray into contiguous chunks. The fast
+// path is deliberately narrow: an all-number array and a side-effect-free
+// native kernel, called with plain stack cells so no pool thread ever
+// touches a VM heap. Kernels must take numbers and return numbers (a bool
+// for pfilter); anything else fails the run cleanly. Each kernel is probed
+// once on the calling thread before any fan-out, so an unsuitable kernel
+// (file.open, say) raises its error where allocation is safe — on a pool
+// thread phelt_error would allocate against that thread's zeroed VM.
+// Closures may close over shared state, so they take the documented
+// fallback: the sequential map/filter/reduce above, re-entering the VM on
+// the calling thread.
+// ---------------------------------------------------------------------------
+
+#include <pthread.h>
+#include <unistd.h>
+
+enum { POOL_MAP,
+    POOL_FILTER,
+    POOL_REDUCE };
+
+typedef struct {
+    int      mode;
+    NativeFn kernel;
+    Value*   source;
+    Value*   results;
+    uint8_t* keep;
+    unsigned from;
+    unsigned to;
+    Value    accumulator;
+    bool     failed;
+} PoolTask;
+
+#define POOL_MAX 32
+
+static pthread_t       poolThreads[POOL_MAX];
+static int             poolSize       = 0;
+static pthread_mutex_t poolLock       = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  poolWork       = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  poolDone       = PTHREAD_COND_INITIALIZER;
+static PoolTask*       poolTasks      = NULL;
+static int             poolTaskCount  = 0;
+static int             poolNextTask   = 0;
+static int             poolPending    = 0;
+static unsigned long   poolGeneration = 0;
+
+// Runs one chunk with kernel calls on bare cells: cell[1..2] are the
+// arguments, cell[0] receives the result, exactly the layout a native sees
+// on the VM stack.
+static void runPoolTask(PoolTask* task)
+{
+    Value cell[3];
+
+    switch (task->mode) {
+    case POOL_MAP:
+        for (unsigned i = task->from; i < task->to; i++) {
+            cell[1] = task->source[i];
+            if (!task->kernel(1, &cell[1]) || !IS_NUMBER(cell[0])) {
+                task->failed = true;
+                return;
+            }
+            task->results[i] = cell[0];
+        }
+        break;
+    case POOL_FILTER:
+        for (unsigned i = task->from; i < task->to; i++) {
+            cell[1] = task->source[i];
+            if (!task->kernel(1, &cell[1]) || !IS_BOOL(cell[0])) {
+                task->failed = true;
+                return;
+            }
+            task->keep[i] = AS_BOOL(cell[0]);
+        }
+        break;
+    case POOL_REDUCE: {
+        Value acc = task->accumulator;
+        for (unsigned i = task->from + 1; i < task->to; i++) {
+            cell[1] = acc;
+            cell[2] = task->source[i];
+            if (!task->kernel(2, &cell[1]) || !IS_NUMBER(cell[0])) {
+                task->failed = true;
+                return;
+            }
+            acc = cell[0];
+        }
+        task->accumulator = acc;
+        break;
+    }
+    }
+}
+
+static void* poolMain(void* arg)
+{
+    (void)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&poolLock);
+    for (;;) {
+        while (poolGeneration == seen)
+            pthread_cond_wait(&poolWork, &poolLock);
+        seen = poolGeneration;
+
+        while (poolNextTask < poolTaskCount) {
+            PoolTask* task = &poolTasks[poolNextTask++];
+            pthread_mutex_unlock(&poolLock);
+            runPoolTask(task);
+            pthread_mutex_lock(&poolLock);
+            if (--poolPending == 0)
+                pthread_cond_signal(&poolDone);
+        }
+    }
+    return NULL;
+}
+
+static void ensurePool(void)
+{
+    if (poolSize > 0)
+        return;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    poolSize   = cores < 1 ? 1 : cores > POOL_MAX ? POOL_MAX
+                                                  : (int)cores;
+    for (int i = 0; i < poolSize; i++)
+        pthread_create(&poolThreads[i], NULL, poolMain, NULL);
+}
+
+// Dispatches tasks to the pool and blocks until all are done. The calling
+// thread allocates nothing while it waits, so no collection can move in
+// under the pool's feet.
+static bool runPool(PoolTask* tasks, int count)
+{
+    ensurePool();
+
+    pthread_mutex_lock(&poolLock);
+    poolTasks     = tasks;
+    poolTaskCount = count;
+    poolNextTask  = 0;
+    poolPending   = count;
+    poolGeneration++;
+    pthread_cond_broadcast(&poolWork);
+    while (poolPending > 0)
+        pthread_cond_wait(&poolDone, &poolLock);
+    pthread_mutex_unlock(&poolLock);
+
+    bool ok = true;
+    for (int i = 0; i < count; i++)
+        ok &= !tasks[i].failed;
+    return ok;
+}
+
+// Calls the kernel once on the calling thread, where phelt_error may
+// allocate freely. A kernel that rejects its arguments fails here with
+// its own error forwarded to args[-1]; a well-behaved kernel's result
+// lands in *result for the caller to type-check.
+static bool probeKernel(NativeFn kernel, int arity, Value a, Value b, Value* args, Value* result)
+{
+    Value cell[3] = { NIL_VAL, a, b };
+    if (!kernel(arity, &cell[1])) {
+        args[-1] = cell[0];
+        return false;
+    }
+    *result = cell[0];
+    return true;
+}
+
+// Partitions [0, count) into one task per pool thread. Returns the number
+// of non-empty tasks.
+static int planTasks(PoolTask* tasks, int mode, NativeFn kernel, Value* source, unsigned count)
+{
+    ensurePool();
+
+    unsigned chunk = (count + poolSize - 1) / poolSize;
+    int      built = 0;
+    for (unsigned from = 0; from < count; from += chunk) {
+        PoolTask* task    = &tasks[built++];
+        task->mode        = mode;
+        task->kernel      = kernel;
+        task->source      = source;
+        task->results     = NULL;
+        task->keep        = NULL;
+        task->from        = from;
+        task->to          = from + chunk < count ? from + chunk : count;
+        task->accumulator = NIL_VAL;
+        task->failed      = false;
+    }
+    return built;
+}
+
+bool array_pmap(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkArray(0);
+
+    // Closures can reach shared state; fall back to the sequential map.
+    if (phelt_isClosure(1))
+        return array_map(argCount, args);
+    if (!IS_NATIVE(phelt_value(1))) {
+        phelt_error("Argument 2 must be a function.");
+        return false;
+    }
+
+    ObjArray* array  = phelt_toArray(0);
+    NativeFn  kernel = AS_NATIVE(phelt_value(1));
+    unsigned  count  = array->array.count;
+
+    if (!array->array.allNumbers) {
+        phelt_error("pmap needs an all-number array.");
+        return false;
+    }
+
+    if (count > 0) {
+        Value probed;
+        if (!probeKernel(kernel, 1, array->array.values[0], NIL_VAL, args, &probed))
+            return false;
+        if (!IS_NUMBER(probed)) {
+            phelt_error("pmap kernel must take a number and return one.");
+            return false;
+        }
+    }
+
+    ObjArray* mapped = newArray();
+    push(OBJ_VAL(mapped));
+    if (count > 0) {
+        mapped->array.capacity = count;
+        mapped->array.values   = ALLOCATE(Value, count);
+
+        PoolTask tasks[POOL_MAX];
+        int      built = planTasks(tasks, POOL_MAP, kernel, array->array.values, count);
+        for (int t = 0; t < built; t++)
+            tasks[t].results = mapped->array.values;
+
+        if (!runPool(tasks, built)) {
+            pop();
+            phelt_error("pmap kernel must take a number and return one.");
+            return false;
+        }
+        mapped->array.count = count;
+    }
+
+    pop();
+    phelt_pushObject(-1, mapped);
+    return true;
+}
+
+bool array_pfilter(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkArray(0);
+
+    if (phelt_isClosure(1))
+        return array_filter(argCount, args);
+    if (!IS_NATIVE(phelt_value(1))) {
+        phelt_error("Argument 2 must be a function.");
+        return false;
+    }
+
+    ObjArray* array  = phelt_toArray(0);
+    NativeFn  kernel = AS_NATIVE(phelt_value(1));
+    unsigned  count  = array->array.count;
+
+    if (!array->array.allNumbers) {
+        phelt_error("pfilter needs an all-number array.");
+        return false;
+    }
+
+    if (count > 0) {
+        Value probed;
+        if (!probeKernel(kernel, 1, array->array.values[0], NIL_VAL, args, &probed))
+            return false;
+        if (!IS_BOOL(probed)) {
+            phelt_error("pfilter kernel must take a number and return a boolean.");
+            return false;
+        }
+    }
+
+    uint8_t* keep = count > 0 ? malloc(count) : NULL;
+
+    if (count > 0) {
+        PoolTask tasks[POOL_MAX];
+        int      built = planTasks(tasks, POOL_FILTER, kernel, array->array.values, count);
+        for (int t = 0; t < built; t++)
+            tasks[t].keep = keep;
+
+        if (!runPool(tasks, built)) {
+            free(keep);
+            phelt_error("pfilter kernel must take a number and return a boolean.");
+            return false;
+        }
+    }
+
+    ObjArray* filtered = newArray();
+    push(OBJ_VAL(filtered));
+    for (unsigned i = 0; i < count; i++) {
+        if (keep[i])
+            writeValueArray(&filtered->array, array->array.values[i]);
+    }
+    free(keep);
+
+    pop();
+    phelt_pushObject(-1, filtered);
+    return true;
+}
+
+bool array_preduce(int argCount, Value* args)
+{
+    phelt_checkArgs(3);
+    phelt_checkArray(0);
+
+    if (phelt_isClosure(1))
+        return array_reduce(argCount, args);
+    if (!IS_NATIVE(phelt_value(1))) {
+        phelt_error("Argument 2 must be a function.");
+        return false;
+    }
+    phelt_checkNumber(2);
+
+    ObjArray* array  = phelt_toArray(0);
+    NativeFn  kernel = AS_NATIVE(phelt_value(1));
+    unsigned  count  = array->array.count;
+
+    if (!array->array.allNumbers) {
+        phelt_error("preduce needs an all-number array.");
+        return false;
+    }
+
+    if (count == 0) {
+        phelt_pushValue(-1, phelt_value(2));
+        return true;
+    }
+
+    Value probed;
+    if (!probeKernel(kernel, 2, phelt_value(2), array->array.values[0], args, &probed))
+        return false;
+    if (!IS_NUMBER(probed)) {
+        phelt_error("preduce kernel must take two numbers and return one.");
+        return false;
+    }
+
+    // Each chunk folds from its own first element, then the chunk results
+    // fold left-to-right into the initial value — so the kernel must be
+    // associative and the initial value its identity.
+    PoolTask tasks[POOL_MAX];
+    int      built = planTasks(tasks, POOL_REDUCE, kernel, array->array.values, count);
+    for (int t = 0; t < built; t++)
+        tasks[t].accumulator = array->array.values[tasks[t].from];
+
+    if (!runPool(tasks, built)) {
+        phelt_error("preduce kernel must take two numbers and return one.");
+        return false;
+    }
+
+    Value cell[3];
+    Value acc = phelt_value(2);
+    for (int t = 0; t < built; t++) {
+        cell[1] = acc;
+        cell[2] = tasks[t].accumulator;
+        if (!kernel(2, &cell[1]) || !IS_NUMBER(cell[0])) {
+            phelt_error("preduce kernel must take two numbers and return one.");
+            return false;
+        }
+        acc = cell[0];
+    }
+
+    phelt_pushValue(-1, acc);
+    return true;
+}
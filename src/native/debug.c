@@ -1,4 +1,5 @@
 #include "native/debug.h"
+#include "memory.h"
 
 bool debug_frame(int argCount, Value* args)
 {
@@ -23,40 +24,137 @@ bool debug_frame(int argCount, Value* args)
 
     ObjTable* table = newTable();
 
-    tableSet(
-        &table->table,
-        OBJ_VAL(copyString("source", 6)),
-        OBJ_VAL(copyString(function->source, (int)strlen(function->source))));
+    // Both tables and each pending key/value pair stay rooted on the stack
+    // while they are filled in; every insertion can trigger a collection.
+    push(OBJ_VAL(table));
+
+#define FRAME_SET(dest, key, keyLength, value)                        \
+    push(value);                                                      \
+    push(OBJ_VAL(copyString(key, keyLength)));                        \
+    tableSet(&(dest)->table, vm.stackTop[-1], vm.stackTop[-2]);       \
+    writeBarrier((Obj*)(dest), vm.stackTop[-1]);                      \
+    writeBarrier((Obj*)(dest), vm.stackTop[-2]);                      \
+    pop();                                                            \
+    pop();
 
-    tableSet(
-        &table->table,
-        OBJ_VAL(copyString("line", 4)),
-        function->chunk.lines.values[frame->ip - function->chunk.code - 1]);
+    FRAME_SET(table, "source", 6,
+        OBJ_VAL(copyString(function->source, (int)strlen(function->source))));
+    FRAME_SET(table, "line", 4,
+        NUMBER_VAL(getLine(&function->chunk, (int)(frame->ip - function->chunk.code - 1))));
 
     ObjTable* funTable = newTable();
+    push(OBJ_VAL(funTable));
 
     Value name = function->name ? OBJ_VAL(function->name) : NIL_VAL;
 
-    tableSet(
-        &funTable->table,
-        OBJ_VAL(copyString("line", 4)),
-        NUMBER_VAL(function->line));
+    FRAME_SET(funTable, "line", 4, NUMBER_VAL(function->line));
+    FRAME_SET(funTable, "name", 4, name);
+    FRAME_SET(funTable, "arity", 5, NUMBER_VAL(function->arity));
+
+    FRAME_SET(table, "function", 8, OBJ_VAL(funTable));
+
+#undef FRAME_SET
+
+    pop();
+    pop();
+    phelt_pushObject(-1, table);
+    return true;
+}
+
+bool debug_profileStart(int argCount, Value* args)
+{
+    int hz = 0;
+    if (argCount == 1) {
+        phelt_checkNumber(0);
+        hz = (int)phelt_toNumber(0);
+    }
+
+    if (!profileStart(hz)) {
+        phelt_error("Profiler is already running.");
+        return false;
+    }
+
+    phelt_pushBool(-1, true);
+    return true;
+}
+
+bool debug_gcStats(int argCount, Value* args)
+{
+    phelt_checkArgs(0);
+
+    const GcStats* stats = gcStats();
+
+    ObjTable* table = newTable();
+    push(OBJ_VAL(table));
 
-    tableSet(
-        &funTable->table,
-        OBJ_VAL(copyString("name", 4)),
-        name);
+#define STAT_SET(key, keyLength, value)                         \
+    push(NUMBER_VAL((double)(value)));                          \
+    push(OBJ_VAL(copyString(key, keyLength)));                  \
+    tableSet(&table->table, vm.stackTop[-1], vm.stackTop[-2]);  \
+    writeBarrier((Obj*)table, vm.stackTop[-1]);                 \
+    pop();                                                      \
+    pop();
 
-    tableSet(
-        &funTable->table,
-        OBJ_VAL(copyString("arity", 5)),
-        NUMBER_VAL(function->arity));
+    STAT_SET("bytesAllocated", 14, vm.bytesAllocated);
+    STAT_SET("nextGC", 6, vm.nextGC);
+    STAT_SET("objects", 7, vm.objectCount);
+    STAT_SET("minorCollections", 16, stats->minorCollections);
+    STAT_SET("majorCollections", 16, stats->majorCollections);
+    STAT_SET("markNs", 6, stats->markNs);
+    STAT_SET("traceNs", 7, stats->traceNs);
+    STAT_SET("sweepNs", 7, stats->sweepNs);
+    STAT_SET("totalPauseNs", 12, stats->totalPauseNs);
+    STAT_SET("maxPauseNs", 10, stats->maxPauseNs);
 
-    tableSet(
-        &table->table,
-        OBJ_VAL(copyString("function", 8)),
-        OBJ_VAL(funTable));
+#undef STAT_SET
 
+    pop();
     phelt_pushObject(-1, table);
     return true;
 }
+
+bool debug_heapSnapshot(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkString(0);
+
+    FILE* out = fopen(phelt_toCString(0), "w");
+    if (out == NULL) {
+        phelt_error("Could not open '%s'.", phelt_toCString(0));
+        return false;
+    }
+
+    heapSnapshot(out);
+    fclose(out);
+
+    phelt_pushBool(-1, true);
+    return true;
+}
+
+bool debug_dispatchStats(int argCount, Value* args)
+{
+    phelt_checkArgs(0);
+
+#ifdef DEBUG_DISPATCH_STATS
+    dispatchStatsDump(stderr);
+    phelt_pushNil(-1);
+    return true;
+#else
+    phelt_error("Dispatch statistics need a DEBUG_DISPATCH_STATS build.");
+    return false;
+#endif
+}
+
+bool debug_profileStop(int argCount, Value* args)
+{
+    phelt_checkArgs(0);
+
+    ObjString* report = profileStop();
+    if (report == NULL) {
+        phelt_error("Profiler is not running.");
+        return false;
+    }
+
+    phelt_pushString(-1, report);
+    return true;
+}
@@ -1,6 +1,12 @@
 #include "native/file.h"
+#include "memory.h"
 #include "vm.h"
+#include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // FILE * fopen(const char * restrict path, const char * restrict mode);
 // let fp = file.open("file.txt", "w+");
@@ -284,6 +290,117 @@ bool file_puts(int argCount, Value* args)
     return true;
 }
 
+// Read a whole file as a string without copying it: the contents come
+// back as a read-only mapping adopted by mappedString, so the bytes live
+// in the page cache and file.read's double copy (fread into a scratch
+// buffer, then copyString onto the heap) disappears. The mapping carries
+// its own NUL terminator — one byte past the end is always mapped, from
+// the zero-filled tail of the last page or, when the size is an exact
+// multiple of the page size, from an anonymous page reserved behind it.
+// let log = file.mmap("access.log")
+bool file_mmap(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkString(0);
+
+    const char* path = phelt_toCString(0);
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        phelt_error("Failed to open file '%s'.", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size > INT_MAX) {
+        close(fd);
+        phelt_error("Failed to map file '%s'.", path);
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    char*  data;
+    if (size % page == 0) {
+        data = mmap(NULL, size + page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data != MAP_FAILED && size > 0
+            && mmap(data, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(data, size + page);
+            data = MAP_FAILED;
+        }
+    } else {
+        data = mmap(NULL, size + 1, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        phelt_error("Failed to map file '%s'.", path);
+        return false;
+    }
+
+    phelt_pushString(-1, mappedString(data, (int)size));
+    return true;
+}
+
+// Buffered line iterator state. One getline buffer is reused for every
+// line, so iterating a million-line file costs a single allocation (grown
+// to the longest line seen) plus the line strings themselves — and short
+// lines embed in their own headers.
+typedef struct {
+    FILE*  stream;
+    char*  buffer;
+    size_t capacity;
+    bool   done;
+} LineReader;
+
+// let it = file.lines(fp)
+bool file_lines(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkPointer(0);
+
+    LineReader* reader = calloc(1, sizeof(LineReader));
+    if (reader == NULL) {
+        phelt_error("Failed to allocate line reader.");
+        return false;
+    }
+    reader->stream = (FILE*)phelt_toPointer(0);
+
+    phelt_pushPointer(-1, (uintptr_t)reader);
+    return true;
+}
+
+// let line = file.nextLine(it)
+// Yields the next line with its newline stripped, or nil at end of file.
+// The read buffer is released at EOF; the reader header itself is kept so
+// a stray nextLine after the final nil stays safe and keeps returning nil.
+bool file_nextLine(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkPointer(0);
+
+    LineReader* reader = (LineReader*)phelt_toPointer(0);
+    if (reader->done) {
+        phelt_pushNil(-1);
+        return true;
+    }
+
+    ssize_t got = getline(&reader->buffer, &reader->capacity, reader->stream);
+    if (got == -1) {
+        free(reader->buffer);
+        reader->buffer = NULL;
+        reader->done   = true;
+        phelt_pushNil(-1);
+        return true;
+    }
+
+    if (got > 0 && reader->buffer[got - 1] == '\n')
+        got--;
+
+    phelt_pushString(-1, copyString(reader->buffer, (int)got));
+    return true;
+}
+
 // int remove(const char * filename);
 // file.remove("test.txt")
 bool file_remove(int argCount, Value* args)
@@ -322,17 +439,23 @@ bool file_rename(int argCount, Value* args)
     return true;
 }
 
-void fileCallback(Table* table)
+void fileCallback(ObjTable* table)
 {
-#define SET_CONST(name, value)                     \
-    push(NUMBER_VAL(value));                       \
-    push(OBJ_VAL(copyString(name, strlen(name)))); \
-    tableSet(table, pop(), pop());
-
-#define SET_CONST_PTR(name, value)                 \
-    push(POINTER_VAL(value));                      \
-    push(OBJ_VAL(copyString(name, strlen(name)))); \
-    tableSet(table, pop(), pop());
+#define SET_CONST(name, value)                                \
+    push(NUMBER_VAL(value));                                  \
+    push(OBJ_VAL(copyString(name, strlen(name))));            \
+    tableSet(&table->table, vm.stackTop[-1], vm.stackTop[-2]); \
+    writeBarrier((Obj*)table, vm.stackTop[-1]);               \
+    pop();                                                    \
+    pop();
+
+#define SET_CONST_PTR(name, value)                            \
+    push(POINTER_VAL(value));                                 \
+    push(OBJ_VAL(copyString(name, strlen(name))));            \
+    tableSet(&table->table, vm.stackTop[-1], vm.stackTop[-2]); \
+    writeBarrier((Obj*)table, vm.stackTop[-1]);               \
+    pop();                                                    \
+    pop();
 
     SET_CONST_PTR("stdin", (uintptr_t)stdin);
     SET_CONST_PTR("stdout", (uintptr_t)stdout);
@@ -1,68 +1,175 @@
 #include "native/http.h"
+#include "memory.h"
 #include <curl/curl.h>
 
 const char* useragent = "phelt/0.1";
 
-struct string {
+// ---------------------------------------------------------------------------
+// Handle pool. Creating an easy handle per request throws away libcurl's
+// connection cache, so every call paid a fresh TCP (and for HTTPS, TLS)
+// handshake. Instead a small per-thread pool keeps warm handles keyed by
+// host: a reused handle is curl_easy_reset() — which clears options but
+// keeps its live connections and TLS sessions — so repeat requests to the
+// same API ride the open connection. Per-thread because the VM itself is
+// per-thread; worker isolates each get their own pool.
+// ---------------------------------------------------------------------------
+
+#define HTTP_POOL_MAX 8
+
+typedef struct {
+    char* host;
+    CURL* handle;
+} PoolEntry;
+
+static __thread PoolEntry handlePool[HTTP_POOL_MAX];
+static __thread int       handleCount = 0;
+static __thread int       handleNext  = 0;
+
+// The pool key: the host between the scheme and the first path, port or
+// query delimiter. Ports are left to libcurl, which keys its connection
+// cache on host+port itself.
+static void hostOf(const char* url, char* host, size_t size)
+{
+    const char* start = strstr(url, "://");
+    start             = start != NULL ? start + 3 : url;
+
+    size_t length = strcspn(start, "/:?#");
+    if (length >= size)
+        length = size - 1;
+    memcpy(host, start, length);
+    host[length] = '\0';
+}
+
+static CURL* acquireHandle(const char* url)
+{
+    char host[256];
+    hostOf(url, host, sizeof host);
+
+    for (int i = 0; i < handleCount; i++) {
+        if (strcmp(handlePool[i].host, host) == 0) {
+            curl_easy_reset(handlePool[i].handle);
+            return handlePool[i].handle;
+        }
+    }
+
+    // A full pool evicts round-robin; the victim's connections close, but
+    // seven other hosts stay warm.
+    PoolEntry* entry;
+    if (handleCount < HTTP_POOL_MAX) {
+        entry = &handlePool[handleCount++];
+    } else {
+        entry      = &handlePool[handleNext];
+        handleNext = (handleNext + 1) % HTTP_POOL_MAX;
+        curl_easy_cleanup(entry->handle);
+        free(entry->host);
+    }
+
+    entry->handle = curl_easy_init();
+    entry->host   = strdup(host);
+    return entry->handle;
+}
+
+// ---------------------------------------------------------------------------
+// Response accumulator: a capacity-doubling buffer allocated through the
+// GC's accounting so the finished bytes can be handed to takeString whole
+// — the response body becomes the script string without a final copy.
+// ---------------------------------------------------------------------------
+
+typedef struct {
     char*  ptr;
     size_t len;
-};
+    size_t cap;
+} Buffer;
 
-void init_string(struct string* s)
+static void initBuffer(Buffer* buffer)
 {
-    s->len = 0;
-    s->ptr = malloc(s->len + 1);
-    if (s->ptr == NULL) {
-        fprintf(stderr, "malloc() failed\n");
-        exit(EXIT_FAILURE);
-    }
-    s->ptr[0] = '\0';
+    buffer->cap    = 256;
+    buffer->ptr    = ALLOCATE(char, buffer->cap);
+    buffer->len    = 0;
+    buffer->ptr[0] = '\0';
 }
 
-size_t writefunc(void* ptr, size_t size, size_t nmemb, struct string* s)
+static size_t writefunc(void* ptr, size_t size, size_t nmemb, void* userdata)
 {
-    size_t new_len = s->len + size * nmemb;
-    s->ptr         = realloc(s->ptr, new_len + 1);
-    if (s->ptr == NULL) {
-        fprintf(stderr, "realloc() failed\n");
-        exit(EXIT_FAILURE);
+    Buffer* buffer = userdata;
+    size_t  bytes  = size * nmemb;
+
+    if (buffer->len + bytes + 1 > buffer->cap) {
+        size_t cap = buffer->cap;
+        while (buffer->len + bytes + 1 > cap)
+            cap *= 2;
+        buffer->ptr = GROW_ARRAY(char, buffer->ptr, buffer->cap, cap);
+        buffer->cap = cap;
     }
-    memcpy(s->ptr + s->len, ptr, size * nmemb);
-    s->ptr[new_len] = '\0';
-    s->len          = new_len;
-    return size * nmemb;
+
+    memcpy(buffer->ptr + buffer->len, ptr, bytes);
+    buffer->len += bytes;
+    buffer->ptr[buffer->len] = '\0';
+    return bytes;
 }
 
-bool http_get(int argCount, Value* args)
+// Shrinks to fit and interns, transferring ownership of the bytes.
+static ObjString* finishBuffer(Buffer* buffer)
 {
-    phelt_checkArgs(1);
-    phelt_checkString(0);
+    char* chars = GROW_ARRAY(char, buffer->ptr, buffer->cap, buffer->len + 1);
+    return takeString(chars, (int)buffer->len);
+}
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        struct string s;
-        init_string(&s);
+static void discardBuffer(Buffer* buffer)
+{
+    FREE_ARRAY(char, buffer->ptr, buffer->cap);
+}
 
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
-        curl_easy_setopt(curl, CURLOPT_URL, phelt_toCString(0));
+// One request on a pooled handle. method NULL means GET (or POST when a
+// body is set); captureHeaders routes the header stream into the result
+// instead of the body; nobody suppresses the body transfer for HEAD.
+static bool performRequest(Value* args, const char* method, const char* body,
+    bool captureHeaders, bool nobody)
+{
+    const char* url  = phelt_toCString(0);
+    CURL*       curl = acquireHandle(url);
+    if (curl == NULL) {
+        phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
+        return false;
+    }
+
+    Buffer response;
+    initBuffer(&response);
+
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    if (method != NULL)
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+    if (body != NULL)
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body);
+    if (nobody)
+        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    if (captureHeaders) {
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, writefunc);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+    } else {
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writefunc);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &s);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    }
 
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
-            return false;
-        }
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK) {
+        discardBuffer(&response);
+        phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
+        return false;
+    }
 
-        curl_easy_cleanup(curl);
+    phelt_pushString(-1, finishBuffer(&response));
+    return true;
+}
 
-        phelt_pushString(-1, copyString(s.ptr, s.len));
-        free(s.ptr);
-        return true;
-    }
+bool http_get(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkString(0);
 
-    phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
-    return false;
+    return performRequest(args, NULL, NULL, false, false);
 }
 
 bool http_post(int argCount, Value* args)
@@ -71,32 +178,7 @@ bool http_post(int argCount, Value* args)
     phelt_checkString(0);
     phelt_checkString(1);
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        struct string s;
-        init_string(&s);
-
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
-        curl_easy_setopt(curl, CURLOPT_URL, phelt_toCString(0));
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, phelt_toCString(1));
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writefunc);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &s);
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
-            return false;
-        }
-
-        curl_easy_cleanup(curl);
-
-        phelt_pushString(-1, copyString(s.ptr, s.len));
-        free(s.ptr);
-        return true;
-    }
-
-    phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
-    return false;
+    return performRequest(args, NULL, phelt_toCString(1), false, false);
 }
 
 bool http_put(int argCount, Value* args)
@@ -105,33 +187,7 @@ bool http_put(int argCount, Value* args)
     phelt_checkString(0);
     phelt_checkString(1);
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        struct string s;
-        init_string(&s);
-
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
-        curl_easy_setopt(curl, CURLOPT_URL, phelt_toCString(0));
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, phelt_toCString(1));
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writefunc);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &s);
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
-            return false;
-        }
-
-        curl_easy_cleanup(curl);
-
-        phelt_pushString(-1, copyString(s.ptr, s.len));
-        free(s.ptr);
-        return true;
-    }
-
-    phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
-    return false;
+    return performRequest(args, "PUT", phelt_toCString(1), false, false);
 }
 
 bool http_delete(int argCount, Value* args)
@@ -140,33 +196,7 @@ bool http_delete(int argCount, Value* args)
     phelt_checkString(0);
     phelt_checkString(1);
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        struct string s;
-        init_string(&s);
-
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
-        curl_easy_setopt(curl, CURLOPT_URL, phelt_toCString(0));
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, phelt_toCString(1));
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writefunc);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &s);
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
-            return false;
-        }
-
-        curl_easy_cleanup(curl);
-
-        phelt_pushString(-1, copyString(s.ptr, s.len));
-        free(s.ptr);
-        return true;
-    }
-
-    phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
-    return false;
+    return performRequest(args, "DELETE", phelt_toCString(1), false, false);
 }
 
 bool http_head(int argCount, Value* args)
@@ -174,98 +204,182 @@ bool http_head(int argCount, Value* args)
     phelt_checkArgs(1);
     phelt_checkString(0);
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        struct string s;
-        init_string(&s);
+    return performRequest(args, NULL, NULL, true, true);
+}
 
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
-        curl_easy_setopt(curl, CURLOPT_URL, phelt_toCString(0));
-        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
-        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, writefunc);
-        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &s);
+bool http_options(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkString(0);
 
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
-            return false;
-        }
+    return performRequest(args, "OPTIONS", NULL, true, false);
+}
 
-        curl_easy_cleanup(curl);
+bool http_patch(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkString(0);
+    phelt_checkString(1);
 
-        phelt_pushString(-1, copyString(s.ptr, s.len));
-        free(s.ptr);
-        return true;
-    }
+    return performRequest(args, "PATCH", phelt_toCString(1), false, false);
+}
 
-    phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
-    return false;
+// ---------------------------------------------------------------------------
+// Batched parallel requests. http.batch takes an array of request tables
+// ({ url, method?, body? }), drives them concurrently through curl_multi
+// under a parallelism cap, and returns one response table per request
+// ({ status, body, error }) in the same order. N independent fetches cost
+// roughly the slowest one instead of the sum, with no VM-level
+// concurrency involved.
+// ---------------------------------------------------------------------------
+
+#define BATCH_DEFAULT_PARALLEL 16
+
+typedef struct {
+    CURL*    handle;
+    Buffer   response;
+    CURLcode result;
+    long     status;
+} BatchRequest;
+
+static void tableInsert(ObjTable* table, const char* key, Value value)
+{
+    push(value);
+    push(OBJ_VAL(copyString(key, (int)strlen(key))));
+    tableSet(&table->table, vm.stackTop[-1], vm.stackTop[-2]);
+    writeBarrier((Obj*)table, vm.stackTop[-1]);
+    writeBarrier((Obj*)table, vm.stackTop[-2]);
+    pop();
+    pop();
 }
 
-bool http_options(int argCount, Value* args)
+// Pulls a string field out of a request table; NULL when absent.
+static const char* requestField(ObjTable* table, const char* key)
 {
-    phelt_checkArgs(1);
-    phelt_checkString(0);
+    Value value;
+    push(OBJ_VAL(copyString(key, (int)strlen(key))));
+    bool found = tableGet(&table->table, vm.stackTop[-1], &value);
+    pop();
+    return found && IS_STRING(value) ? AS_CSTRING(value) : NULL;
+}
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        struct string s;
-        init_string(&s);
+bool http_batch(int argCount, Value* args)
+{
+    phelt_checkMinArgs(1);
+    phelt_checkArray(0);
+
+    int cap = BATCH_DEFAULT_PARALLEL;
+    if (argCount == 2) {
+        phelt_checkNumber(1);
+        cap = (int)phelt_toNumber(1);
+        if (cap < 1)
+            cap = 1;
+    }
 
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
-        curl_easy_setopt(curl, CURLOPT_URL, phelt_toCString(0));
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "OPTIONS");
-        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, writefunc);
-        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &s);
+    ObjArray* requests = phelt_toArray(0);
+    int       count    = (int)requests->array.count;
+
+    BatchRequest* batch = calloc(count > 0 ? count : 1, sizeof(BatchRequest));
+    if (batch == NULL) {
+        phelt_error("Could not allocate batch.");
+        return false;
+    }
 
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
+    // Configure every handle up front; the url/method/body strings stay
+    // rooted through the requests array for the whole transfer.
+    for (int i = 0; i < count; i++) {
+        if (!IS_TABLE(requests->array.values[i])) {
+            free(batch);
+            phelt_error("Request %d must be a table.", i + 1);
+            return false;
+        }
+        ObjTable*   table = AS_TABLE(requests->array.values[i]);
+        const char* url   = requestField(table, "url");
+        if (url == NULL) {
+            free(batch);
+            phelt_error("Request %d has no url.", i + 1);
             return false;
         }
 
-        curl_easy_cleanup(curl);
-
-        phelt_pushString(-1, copyString(s.ptr, s.len));
-        free(s.ptr);
-        return true;
+        BatchRequest* request = &batch[i];
+        request->handle       = curl_easy_init();
+        initBuffer(&request->response);
+
+        curl_easy_setopt(request->handle, CURLOPT_USERAGENT, useragent);
+        curl_easy_setopt(request->handle, CURLOPT_URL, url);
+        curl_easy_setopt(request->handle, CURLOPT_WRITEFUNCTION, writefunc);
+        curl_easy_setopt(request->handle, CURLOPT_WRITEDATA, &request->response);
+        curl_easy_setopt(request->handle, CURLOPT_PRIVATE, request);
+
+        const char* method = requestField(table, "method");
+        if (method != NULL)
+            curl_easy_setopt(request->handle, CURLOPT_CUSTOMREQUEST, method);
+        const char* body = requestField(table, "body");
+        if (body != NULL)
+            curl_easy_setopt(request->handle, CURLOPT_POSTFIELDS, body);
     }
 
-    phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
-    return false;
-}
+    CURLM* multi = curl_multi_init();
 
-bool http_patch(int argCount, Value* args)
-{
-    phelt_checkArgs(2);
-    phelt_checkString(0);
-    phelt_checkString(1);
+    int next      = 0;
+    int active    = 0;
+    int completed = 0;
+    while (completed < count) {
+        while (next < count && active < cap) {
+            curl_multi_add_handle(multi, batch[next++].handle);
+            active++;
+        }
 
-    CURL* curl = curl_easy_init();
-    if (curl) {
-        struct string s;
-        init_string(&s);
+        int running;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* message;
+        int      queued;
+        while ((message = curl_multi_info_read(multi, &queued)) != NULL) {
+            if (message->msg != CURLMSG_DONE)
+                continue;
+            BatchRequest* request;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &request);
+            request->result = message->data.result;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &request->status);
+            curl_multi_remove_handle(multi, message->easy_handle);
+            completed++;
+            active--;
+        }
 
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, useragent);
-        curl_easy_setopt(curl, CURLOPT_URL, phelt_toCString(0));
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PATCH");
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, phelt_toCString(1));
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writefunc);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &s);
+        if (completed < count && active > 0)
+            curl_multi_wait(multi, NULL, 0, 100, NULL);
+    }
 
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            phelt_pushObject(-1, formatString("curl_easy_perform() failed: %s\n", curl_easy_strerror(res)));
-            return false;
+    curl_multi_cleanup(multi);
+
+    ObjArray* results = newArray();
+    push(OBJ_VAL(results));
+    for (int i = 0; i < count; i++) {
+        BatchRequest* request = &batch[i];
+
+        ObjTable* result = newTable();
+        push(OBJ_VAL(result));
+        tableInsert(result, "status", NUMBER_VAL(request->status));
+        if (request->result == CURLE_OK) {
+            tableInsert(result, "body", OBJ_VAL(finishBuffer(&request->response)));
+            tableInsert(result, "error", NIL_VAL);
+        } else {
+            discardBuffer(&request->response);
+            tableInsert(result, "body", OBJ_VAL(copyString("", 0)));
+            tableInsert(result, "error",
+                OBJ_VAL(copyString(curl_easy_strerror(request->result),
+                    (int)strlen(curl_easy_strerror(request->result)))));
         }
+        writeValueArray(&results->array, OBJ_VAL(result));
+        writeBarrier((Obj*)results, OBJ_VAL(result));
+        pop();
 
-        curl_easy_cleanup(curl);
-
-        phelt_pushString(-1, copyString(s.ptr, s.len));
-        free(s.ptr);
-        return true;
+        curl_easy_cleanup(request->handle);
     }
+    free(batch);
 
-    phelt_pushObject(-1, formatString("curl_easy_init() failed\n"));
-    return false;
+    pop();
+    phelt_pushObject(-1, results);
+    return true;
 }
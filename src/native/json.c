@@ -1,330 +1,662 @@
 #include "native/json.h"
 
-ObjTable* json_object_to_table(json_object_t* object);
-ObjArray* json_array_to_array(json_array_t* array);
+#include "memory.h"
+
+#include <ctype.h>
+
+// ---------------------------------------------------------------------------
+// Decoder. One recursive-descent pass over the source builds ObjTable,
+// ObjArray and Value results directly while scanning — no intermediate
+// DOM, so a decoded dump never exists in three representations at once.
+// String values are sliced straight out of the source (unescaped into a
+// scratch buffer only when a backslash actually appears) and skip
+// vm.strings via uninternedString; keys still intern, since keys repeat
+// across records and make good table keys. Scanning uses SWAR — eight
+// bytes per step through space runs and string bodies — which vectorizes
+// without tying the build to any instruction set.
+//
+// Accepted on top of strict JSON: // and /* */ comments, trailing commas,
+// single-quoted strings and unquoted keys. Passing true as the second
+// argument enables simplified JSON as well: an implicit root object,
+// '=' for ':' and newlines as separators.
+// ---------------------------------------------------------------------------
+
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGH 0x8080808080808080ULL
+
+static inline uint64_t swarLoad(const char* at)
+{
+    uint64_t word;
+    memcpy(&word, at, sizeof(word));
+    return word;
+}
 
-ObjArray* json_array_to_array(json_array_t* array)
+// A high bit per byte equal to c.
+static inline uint64_t swarEq(uint64_t word, char c)
 {
-    ObjArray* objArray = newArray();
+    uint64_t match = word ^ (SWAR_ONES * (uint8_t)c);
+    return (match - SWAR_ONES) & ~match & SWAR_HIGH;
+}
 
-    struct json_array_element_s* entry = array->start;
+typedef struct {
+    const char* at;
+    const char* end;
+    // Simplified JSON: implicit root object, '=' for ':', newlines count
+    // as separators.
+    bool simplified;
+    // Set by skipSpace when it crossed a line break; separator logic in
+    // simplified mode reads and resets it.
+    bool sawNewline;
+} Decoder;
 
-    while (entry != NULL) {
-        switch (entry->value->type) {
-        case json_type_string: {
-            const char* value = json_value_as_string(entry->value)->string;
+static bool decodeValue(Decoder* decoder, Value* out);
 
-            writeValueArray(&objArray->array, OBJ_VAL(copyString(value, strlen(value))));
+static void skipSpace(Decoder* decoder)
+{
+    const char* at = decoder->at;
+    for (;;) {
+        // Indentation is runs of spaces; take them eight at a time.
+        while (at + 8 <= decoder->end && swarLoad(at) == SWAR_ONES * ' ')
+            at += 8;
+        if (at >= decoder->end)
             break;
-        }
-        case json_type_number: {
-            double value = atoll(json_value_as_number(entry->value)->number);
-            writeValueArray(&objArray->array, NUMBER_VAL(value));
+        char c = *at;
+        if (c == ' ' || c == '\t' || c == '\r') {
+            at++;
+        } else if (c == '\n') {
+            decoder->sawNewline = true;
+            at++;
+        } else if (c == '/' && at + 1 < decoder->end && at[1] == '/') {
+            at += 2;
+            while (at < decoder->end && *at != '\n')
+                at++;
+        } else if (c == '/' && at + 1 < decoder->end && at[1] == '*') {
+            at += 2;
+            while (at + 1 < decoder->end && !(at[0] == '*' && at[1] == '/'))
+                at++;
+            at = at + 2 <= decoder->end ? at + 2 : decoder->end;
+        } else {
             break;
         }
-        case json_type_object: {
-            json_object_t* value = entry->value->payload;
+    }
+    decoder->at = at;
+}
 
-            writeValueArray(&objArray->array, OBJ_VAL(json_object_to_table(value)));
-            break;
+// Writes a code point as UTF-8; returns the byte count.
+static int encodeUtf8(char* out, uint32_t codepoint)
+{
+    if (codepoint < 0x80) {
+        out[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (codepoint >> 18));
+    out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Reads \uXXXX after the backslash-u, pairing surrogates.
+static bool decodeUnicodeEscape(const char** cursor, const char* end, uint32_t* out)
+{
+    const char* at = *cursor;
+    if (at + 4 > end)
+        return false;
+
+    uint32_t codepoint = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hexDigit(at[i]);
+        if (digit < 0)
+            return false;
+        codepoint = codepoint << 4 | digit;
+    }
+    at += 4;
+
+    if (codepoint >= 0xD800 && codepoint <= 0xDBFF
+        && at + 6 <= end && at[0] == '\\' && at[1] == 'u') {
+        uint32_t low = 0;
+        for (int i = 0; i < 4; i++) {
+            int digit = hexDigit(at[2 + i]);
+            if (digit < 0)
+                return false;
+            low = low << 4 | digit;
         }
-        case json_type_array: {
-            json_array_t* value = entry->value->payload;
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            at += 6;
+        }
+    }
 
-            writeValueArray(&objArray->array, OBJ_VAL(json_array_to_array(value)));
+    *cursor = at;
+    *out    = codepoint;
+    return true;
+}
+
+// Parses a string whose opening quote is under the cursor. The common
+// case — no backslash before the closing quote — turns into a single
+// copy out of the source; only strings that actually contain escapes
+// take the scratch-buffer path. Keys intern, values do not.
+static bool decodeString(Decoder* decoder, bool intern, Value* out)
+{
+    char        quote = *decoder->at++;
+    const char* start = decoder->at;
+    const char* at    = start;
+
+    while (at + 8 <= decoder->end) {
+        uint64_t word = swarLoad(at);
+        if (swarEq(word, quote) | swarEq(word, '\\'))
             break;
+        at += 8;
+    }
+    while (at < decoder->end && *at != quote && *at != '\\')
+        at++;
+    if (at >= decoder->end)
+        return false;
+
+    if (*at == quote) {
+        int length  = (int)(at - start);
+        *out        = OBJ_VAL(intern ? copyString(start, length)
+                                     : uninternedString(start, length));
+        decoder->at = at + 1;
+        return true;
+    }
+
+    // Escapes present: find the real closing quote, then unescape into a
+    // scratch buffer. The output never outgrows the raw span.
+    const char* close = at;
+    while (close < decoder->end && *close != quote) {
+        if (*close == '\\') {
+            if (close + 2 > decoder->end)
+                return false;
+            close += 2;
+        } else {
+            close++;
         }
-        case json_type_true: {
-            writeValueArray(&objArray->array, BOOL_VAL(true));
-            break;
+    }
+    if (close >= decoder->end)
+        return false;
+
+    size_t rawLength = close - start;
+    char*  buffer    = malloc(rawLength + 1);
+    if (buffer == NULL)
+        return false;
+
+    size_t length = at - start;
+    memcpy(buffer, start, length);
+
+    const char* cursor = at;
+    while (cursor < close) {
+        if (*cursor != '\\') {
+            buffer[length++] = *cursor++;
+            continue;
         }
-        case json_type_false: {
-            writeValueArray(&objArray->array, BOOL_VAL(false));
+        cursor++;
+        char escape = *cursor++;
+        switch (escape) {
+        case 'b': buffer[length++] = '\b'; break;
+        case 'f': buffer[length++] = '\f'; break;
+        case 'n': buffer[length++] = '\n'; break;
+        case 'r': buffer[length++] = '\r'; break;
+        case 't': buffer[length++] = '\t'; break;
+        case 'u': {
+            uint32_t codepoint;
+            if (!decodeUnicodeEscape(&cursor, close, &codepoint)) {
+                free(buffer);
+                return false;
+            }
+            length += encodeUtf8(buffer + length, codepoint);
             break;
         }
-        case json_type_null: {
-            writeValueArray(&objArray->array, NIL_VAL);
+        default:
+            // Covers \" \' \\ \/ and keeps unknown escapes as themselves.
+            buffer[length++] = escape;
             break;
         }
-        }
-
-        entry = entry->next;
     }
 
-    return objArray;
+    *out = OBJ_VAL(intern ? copyString(buffer, (int)length)
+                          : uninternedString(buffer, (int)length));
+    free(buffer);
+    decoder->at = close + 1;
+    return true;
 }
 
-ObjTable* json_object_to_table(json_object_t* object)
+// A key is a quoted string or a bare identifier (JSON5 / simplified).
+static bool decodeKey(Decoder* decoder, ObjString** out)
 {
-    ObjTable* table = newTable();
+    if (*decoder->at == '"' || *decoder->at == '\'') {
+        Value key;
+        if (!decodeString(decoder, true, &key))
+            return false;
+        *out = AS_STRING(key);
+        return true;
+    }
+
+    const char* start = decoder->at;
+    while (decoder->at < decoder->end
+        && (isalnum((uint8_t)*decoder->at) || *decoder->at == '_' || *decoder->at == '$'))
+        decoder->at++;
+    if (decoder->at == start)
+        return false;
 
-    struct json_object_element_s* entry = object->start;
+    *out = copyString(start, (int)(decoder->at - start));
+    return true;
+}
 
-    while (entry != NULL) {
-        const char* key = entry->name->string;
+// After an element, the next token must close the container or follow a
+// separator: a comma, or in simplified mode a line break.
+static bool decodeSeparator(Decoder* decoder, char closer)
+{
+    decoder->sawNewline = false;
+    skipSpace(decoder);
+    if (decoder->at >= decoder->end || *decoder->at == closer)
+        return true;
+    if (*decoder->at == ',') {
+        decoder->at++;
+        skipSpace(decoder);
+        return true;
+    }
+    return decoder->simplified && decoder->sawNewline;
+}
 
-        switch (entry->value->type) {
-        case json_type_string: {
-            const char* value = json_value_as_string(entry->value)->string;
+// Append an element while the container sits rooted on the stack; the
+// element stays pushed across the write since the append itself can
+// allocate and trigger a collection.
+static void jsonAppend(ObjArray* objArray, Value value)
+{
+    push(value);
+    writeValueArray(&objArray->array, vm.stackTop[-1]);
+    writeBarrier((Obj*)objArray, vm.stackTop[-1]);
+    pop();
+}
 
-            tableSet(&table->table, OBJ_VAL(copyString(key, strlen(key))), OBJ_VAL(copyString(value, strlen(value))));
-            break;
-        }
-        case json_type_number: {
-            double value = atof(json_value_as_number(entry->value)->number);
-            tableSet(&table->table, OBJ_VAL(copyString(key, strlen(key))), NUMBER_VAL(value));
-            break;
+static bool decodeArray(Decoder* decoder, Value* out)
+{
+    decoder->at++; // '['
+    ObjArray* array = newArray();
+    push(OBJ_VAL(array));
+
+    skipSpace(decoder);
+    while (decoder->at < decoder->end && *decoder->at != ']') {
+        Value element;
+        if (!decodeValue(decoder, &element)) {
+            pop();
+            return false;
         }
-        case json_type_object: {
-            json_object_t* value = entry->value->payload;
+        jsonAppend(array, element);
 
-            tableSet(&table->table, OBJ_VAL(copyString(key, strlen(key))), OBJ_VAL(json_object_to_table(value)));
-            break;
+        if (!decodeSeparator(decoder, ']')) {
+            pop();
+            return false;
         }
-        case json_type_array: {
-            json_array_t* value = entry->value->payload;
+    }
+    if (decoder->at >= decoder->end) {
+        pop();
+        return false;
+    }
+    decoder->at++; // ']'
 
-            tableSet(&table->table, OBJ_VAL(copyString(key, strlen(key))), OBJ_VAL(json_array_to_array(value)));
-            break;
+    pop();
+    *out = OBJ_VAL(array);
+    return true;
+}
+
+// Parses key/value pairs up to the closer — '}' normally, end of input
+// for a simplified implicit root. The key stays pushed while the value
+// parses, since value parsing allocates.
+static bool decodeObjectBody(Decoder* decoder, bool implicit, Value* out)
+{
+    ObjTable* table = newTable();
+    push(OBJ_VAL(table));
+
+    skipSpace(decoder);
+    while (implicit ? decoder->at < decoder->end
+                    : decoder->at < decoder->end && *decoder->at != '}') {
+        ObjString* key;
+        if (!decodeKey(decoder, &key)) {
+            pop();
+            return false;
         }
-        case json_type_true: {
-            tableSet(&table->table, OBJ_VAL(copyString(key, strlen(key))), BOOL_VAL(true));
-            break;
+        push(OBJ_VAL(key));
+
+        skipSpace(decoder);
+        bool separated = decoder->at < decoder->end
+            && (*decoder->at == ':' || (decoder->simplified && *decoder->at == '='));
+        if (!separated) {
+            pop();
+            pop();
+            return false;
         }
-        case json_type_false: {
-            tableSet(&table->table, OBJ_VAL(copyString(key, strlen(key))), BOOL_VAL(false));
-            break;
+        decoder->at++;
+
+        Value value;
+        if (!decodeValue(decoder, &value)) {
+            pop();
+            pop();
+            return false;
         }
-        case json_type_null: {
-            tableSet(&table->table, OBJ_VAL(copyString(key, strlen(key))), NIL_VAL);
-            break;
+        push(value);
+        tableSet(&table->table, vm.stackTop[-2], vm.stackTop[-1]);
+        writeBarrier((Obj*)table, vm.stackTop[-2]);
+        writeBarrier((Obj*)table, vm.stackTop[-1]);
+        pop();
+        pop();
+
+        if (!decodeSeparator(decoder, implicit ? '\0' : '}')) {
+            pop();
+            return false;
         }
+    }
+    if (!implicit) {
+        if (decoder->at >= decoder->end) {
+            pop();
+            return false;
         }
-
-        entry = entry->next;
+        decoder->at++; // '}'
     }
 
-    return table;
+    pop();
+    *out = OBJ_VAL(table);
+    return true;
 }
 
-bool json_decode(int argCount, Value* args)
+static bool decodeValue(Decoder* decoder, Value* out)
 {
-    enum json_parse_flags_e flags = json_parse_flags_allow_json5;
+    skipSpace(decoder);
+    if (decoder->at >= decoder->end)
+        return false;
+
+    switch (*decoder->at) {
+    case '{': {
+        decoder->at++;
+        return decodeObjectBody(decoder, false, out);
+    }
+    case '[':
+        return decodeArray(decoder, out);
+    case '"':
+    case '\'':
+        return decodeString(decoder, false, out);
+    case 't':
+        if (decoder->end - decoder->at < 4 || memcmp(decoder->at, "true", 4) != 0)
+            return false;
+        decoder->at += 4;
+        *out = BOOL_VAL(true);
+        return true;
+    case 'f':
+        if (decoder->end - decoder->at < 5 || memcmp(decoder->at, "false", 5) != 0)
+            return false;
+        decoder->at += 5;
+        *out = BOOL_VAL(false);
+        return true;
+    case 'n':
+        if (decoder->end - decoder->at < 4 || memcmp(decoder->at, "null", 4) != 0)
+            return false;
+        decoder->at += 4;
+        *out = NIL_VAL;
+        return true;
+    default: {
+        // strtod stops at the NUL terminator every source string carries.
+        char*  numberEnd;
+        double number = strtod(decoder->at, &numberEnd);
+        if (numberEnd == decoder->at)
+            return false;
+        decoder->at = numberEnd;
+        *out        = NUMBER_VAL(number);
+        return true;
+    }
+    }
+}
 
+bool json_decode(int argCount, Value* args)
+{
     phelt_checkMinArgs(1);
     phelt_checkString(0);
 
+    bool simplified = false;
     if (argCount == 2) {
         phelt_checkBool(1);
-        if (phelt_toBool(1)) {
-            flags = json_parse_flags_allow_simplified_json | json_parse_flags_allow_c_style_comments;
-        }
+        simplified = phelt_toBool(1);
     }
 
-    char* json = phelt_toCString(0);
+    ObjString* source = phelt_toString(0);
+    const char* json  = stringChars(source);
 
-    struct json_value_s* root = json_parse_ex(json, strlen(json), flags, NULL, NULL, NULL);
+    Decoder decoder = { json, json + source->length, simplified, false };
 
-    if (root == NULL) {
-        phelt_error("Invalid JSON.");
-        return false;
+    Value result;
+    bool  ok;
+    skipSpace(&decoder);
+    if (decoder.at >= decoder.end) {
+        ok = false;
+    } else if (simplified && *decoder.at != '{' && *decoder.at != '[') {
+        ok = decodeObjectBody(&decoder, true, &result);
+    } else {
+        ok = decodeValue(&decoder, &result);
+        if (ok) {
+            skipSpace(&decoder);
+            ok = decoder.at >= decoder.end;
+        }
     }
 
-    if (root->type == json_type_object) {
-        struct json_object_s* object = (struct json_object_s*)root->payload;
-        phelt_pushObject(-1, json_object_to_table(object));
-    } else if (root->type == json_type_array) {
-        struct json_array_s* array = (struct json_array_s*)root->payload;
-        phelt_pushObject(-1, json_array_to_array(array));
-    } else if (root->type == json_type_string) {
-        char* value = root->payload;
-        phelt_pushString(-1, copyString(value, strlen(value)));
-    } else if (root->type == json_type_number) {
-        double value = atoll(json_value_as_number(root)->number);
-        phelt_pushNumber(-1, value);
-    } else if (root->type == json_type_true) {
-        phelt_pushBool(-1, true);
-    } else if (root->type == json_type_false) {
-        phelt_pushBool(-1, false);
-    } else if (root->type == json_type_null) {
-        phelt_pushNil(-1);
-    } else {
+    if (!ok) {
         phelt_error("Invalid JSON.");
         return false;
     }
 
-    free(root);
+    phelt_push(-1, result);
     return true;
 }
+// ---------------------------------------------------------------------------
+// Encoder. A single growable output buffer is threaded through the whole
+// walk: every piece appends in place, so encoding is linear in the output
+// size where the old table_to_string/array_to_string pair assembled and
+// re-copied an intermediate C string per subtree. Strings escape while
+// copying — a SWAR scan skips eight clean bytes at a time and only the
+// characters that need escaping break the run — and numbers format
+// through a hand-rolled integer path that covers the canonical integral
+// doubles the VM produces, falling back to snprintf for the rest.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    char*  ptr;
+    size_t len;
+    size_t cap;
+} Writer;
+
+// The buffer is GC-accounted so json_encode can hand the finished text to
+// takeString without a final copy, the same way the http module's
+// response buffers work.
+static void writerInit(Writer* writer)
+{
+    writer->cap = 256;
+    writer->len = 0;
+    writer->ptr = ALLOCATE(char, writer->cap);
+}
+
+static void writerEnsure(Writer* writer, size_t extra)
+{
+    if (writer->len + extra <= writer->cap)
+        return;
+    size_t cap = writer->cap;
+    while (writer->len + extra > cap)
+        cap *= 2;
+    writer->ptr = GROW_ARRAY(char, writer->ptr, writer->cap, cap);
+    writer->cap = cap;
+}
 
-char* array_to_string(ObjArray* array);
-char* table_to_string(ObjTable* table);
+static void writerBytes(Writer* writer, const char* bytes, size_t count)
+{
+    writerEnsure(writer, count);
+    memcpy(writer->ptr + writer->len, bytes, count);
+    writer->len += count;
+}
 
-char* escape_json_string(char* string)
+static void writerChar(Writer* writer, char c)
 {
-    char* buffer = malloc(1);
-    buffer[0]    = '\0';
+    writerEnsure(writer, 1);
+    writer->ptr[writer->len++] = c;
+}
 
-    for (unsigned int i = 0; i < strlen(string); i++) {
-        char* temp;
+// True for bytes that cannot pass through verbatim inside a quoted
+// string: the quote, the backslash and control characters.
+static inline uint64_t swarNeedsEscape(uint64_t word)
+{
+    return swarEq(word, '"') | swarEq(word, '\\')
+        | ((word - SWAR_ONES * 0x20) & ~word & SWAR_HIGH);
+}
 
-        switch (string[i]) {
-        case '"':
-            temp = malloc(strlen(buffer) + 3);
-            sprintf(temp, "%s\\\"", buffer);
-            break;
-        case '\\':
-            temp = malloc(strlen(buffer) + 3);
-            sprintf(temp, "%s\\\\", buffer);
-            break;
-        case '\b':
-            temp = malloc(strlen(buffer) + 3);
-            sprintf(temp, "%s\\b", buffer);
-            break;
-        case '\f':
-            temp = malloc(strlen(buffer) + 3);
-            sprintf(temp, "%s\\f", buffer);
-            break;
-        case '\n':
-            temp = malloc(strlen(buffer) + 3);
-            sprintf(temp, "%s\\n", buffer);
-            break;
-        case '\r':
-            temp = malloc(strlen(buffer) + 3);
-            sprintf(temp, "%s\\r", buffer);
-            break;
-        case '\t':
-            temp = malloc(strlen(buffer) + 3);
-            sprintf(temp, "%s\\t", buffer);
+static void writerEscaped(Writer* writer, const char* chars, size_t length)
+{
+    const char* at  = chars;
+    const char* end = chars + length;
+
+    writerChar(writer, '"');
+    while (at < end) {
+        const char* run = at;
+        while (run + 8 <= end && !swarNeedsEscape(swarLoad(run)))
+            run += 8;
+        while (run < end && *run != '"' && *run != '\\' && (uint8_t)*run >= 0x20)
+            run++;
+        writerBytes(writer, at, run - at);
+        at = run;
+        if (at >= end)
             break;
+
+        char c = *at++;
+        switch (c) {
+        case '"': writerBytes(writer, "\\\"", 2); break;
+        case '\\': writerBytes(writer, "\\\\", 2); break;
+        case '\b': writerBytes(writer, "\\b", 2); break;
+        case '\f': writerBytes(writer, "\\f", 2); break;
+        case '\n': writerBytes(writer, "\\n", 2); break;
+        case '\r': writerBytes(writer, "\\r", 2); break;
+        case '\t': writerBytes(writer, "\\t", 2); break;
         default:
-            temp = malloc(strlen(buffer) + 2);
-            sprintf(temp, "%s%c", buffer, string[i]);
+            // Other control characters passed through before; keep that.
+            writerChar(writer, c);
             break;
         }
-
-        free(buffer);
-        buffer = temp;
     }
-
-    return buffer;
+    writerChar(writer, '"');
 }
 
-char* array_to_string(ObjArray* object)
+static void writerNumber(Writer* writer, double number)
 {
-    ValueArray array = object->array;
-
-    char* buffer = malloc(1);
-    buffer[0]    = '\0';
-
-    for (unsigned int i = 0; i < array.count; i++) {
-        Value value = array.values[i];
-        char* temp;
-
-        if (IS_STRING(value)) {
-            char* string = escape_json_string(AS_CSTRING(value));
-            temp         = malloc(strlen(buffer) + strlen(string) + 5);
-            sprintf(temp, "%s\"%s\",", buffer, string);
-        } else if (IS_NUMBER(value)) {
-            double number = AS_NUMBER(value);
-            temp          = malloc(strlen(buffer) + 32);
-            sprintf(temp, "%s%g,", buffer, number);
-        } else if (IS_BOOL(value)) {
-            bool boolean = AS_BOOL(value);
-            temp         = malloc(strlen(buffer) + 32);
-            sprintf(temp, "%s%s,", buffer, boolean ? "true" : "false");
-        } else if (IS_NIL(value)) {
-            temp = malloc(strlen(buffer) + 32);
-            sprintf(temp, "%s%s,", buffer, "null");
-        } else if (IS_OBJ(value)) {
-            if (IS_ARRAY(value)) {
-                temp = array_to_string(AS_ARRAY(value));
-            } else if (IS_TABLE(value)) {
-                temp = table_to_string(AS_TABLE(value));
-            } else {
-                temp = malloc(strlen(buffer) + 32);
-                sprintf(temp, "%s%s,", buffer, "null");
-            }
-        } else {
-            temp = malloc(strlen(buffer) + 32);
-            sprintf(temp, "%s%s,", buffer, "null");
+    writerEnsure(writer, 32);
+
+    // NaN boxing canonicalizes integral doubles, so most numbers take
+    // this path: digits peeled off backwards, no sprintf. The window
+    // stays inside %g's six significant digits so the fallback and the
+    // fast path never disagree on the same value.
+    if (number == (double)(long long)number && number > -1e6 && number < 1e6) {
+        long long value = (long long)number;
+        if (value < 0) {
+            writer->ptr[writer->len++] = '-';
+            value = -value;
         }
-
-        free(buffer);
-        buffer = temp;
+        char digits[8];
+        int  count = 0;
+        do {
+            digits[count++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (count > 0)
+            writer->ptr[writer->len++] = digits[--count];
+        return;
     }
 
-    // Remove the trailing comma.
-    buffer[strlen(buffer) - 1] = '\0';
-
-    // wrap in brackets
-    char* temp = malloc(strlen(buffer) + 3);
-    sprintf(temp, "[%s]", buffer);
-    free(buffer);
-    buffer = temp;
-
-    return buffer;
+    writer->len += snprintf(writer->ptr + writer->len, 32, "%g", number);
 }
 
-char* table_to_string(ObjTable* object)
+static void encodeValue(Writer* writer, Value value)
 {
-    Table table = object->table;
-
-    char* buffer = malloc(1);
-    buffer[0]    = '\0';
-
-    for (unsigned int i = 0; i < table.capacity; i++) {
-        Entry* entry = &table.entries[i];
-        if (!IS_EMPTY(entry->key)) {
-            char* key = AS_CSTRING(entry->key);
-            char* value;
-
-            if (IS_STRING(entry->value)) {
-                value      = escape_json_string(AS_CSTRING(entry->value));
-                char* temp = malloc(strlen(value) + 3);
-                sprintf(temp, "\"%s\"", value);
-                free(value);
-                value = temp;
-            } else if (IS_NUMBER(entry->value)) {
-                value = malloc(1);
-                sprintf(value, "%g", AS_NUMBER(entry->value));
-            } else if (IS_BOOL(entry->value)) {
-                value = malloc(1);
-                sprintf(value, "%s", AS_BOOL(entry->value) ? "true" : "false");
-            } else if (IS_NIL(entry->value)) {
-                value = malloc(1);
-                sprintf(value, "%s", "null");
-            } else if (IS_OBJ(entry->value)) {
-                if (IS_ARRAY(entry->value)) {
-                    value = array_to_string(AS_ARRAY(entry->value));
-                } else if (IS_TABLE(entry->value)) {
-                    value = table_to_string(AS_TABLE(entry->value));
-                } else {
-                    value = malloc(1);
-                    sprintf(value, "%s", "null");
-                }
-            } else {
-                value = malloc(1);
-                sprintf(value, "%s", "null");
-            }
-
-            char* temp = malloc(strlen(buffer) + strlen(key) + strlen(value) + 5);
-            sprintf(temp, "%s\"%s\":%s,", buffer, key, value);
-            free(buffer);
-            buffer = temp;
+    if (IS_STRING(value)) {
+        ObjString* string = AS_STRING(value);
+        writerEscaped(writer, stringChars(string), string->length);
+    } else if (IS_NUMBER(value)) {
+        writerNumber(writer, AS_NUMBER(value));
+    } else if (IS_BOOL(value)) {
+        writerBytes(writer, AS_BOOL(value) ? "true" : "false", AS_BOOL(value) ? 4 : 5);
+    } else if (IS_ARRAY(value)) {
+        ObjArray* array = AS_ARRAY(value);
+        writerChar(writer, '[');
+        for (unsigned int i = 0; i < array->array.count; i++) {
+            if (i > 0)
+                writerChar(writer, ',');
+            encodeValue(writer, array->array.values[i]);
+        }
+        writerChar(writer, ']');
+    } else if (IS_TABLE(value)) {
+        Table* table = &AS_TABLE(value)->table;
+        writerChar(writer, '{');
+        bool first = true;
+        for (unsigned int i = 0; i < table->capacity; i++) {
+            Entry* entry = &table->entries[i];
+            if (IS_EMPTY(entry->key) || !IS_STRING(entry->key))
+                continue;
+            if (!first)
+                writerChar(writer, ',');
+            first             = false;
+            ObjString* key    = AS_STRING(entry->key);
+            writerEscaped(writer, stringChars(key), key->length);
+            writerChar(writer, ':');
+            encodeValue(writer, entry->value);
         }
+        writerChar(writer, '}');
+    } else {
+        // Functions, classes, instances and nil have no JSON shape.
+        writerBytes(writer, "null", 4);
     }
+}
 
-    // Remove the trailing comma.
-    buffer[strlen(buffer) - 1] = '\0';
+// Kept for the worker module, which ships containers across isolates as
+// malloc'd text freed with plain free() — possibly on another thread, so
+// the GC-accounted writer buffer cannot be handed over directly.
+static char* writerToCString(Value value)
+{
+    Writer writer;
+    writerInit(&writer);
+    encodeValue(&writer, value);
+
+    char* copy = malloc(writer.len + 1);
+    if (copy != NULL) {
+        memcpy(copy, writer.ptr, writer.len);
+        copy[writer.len] = '\0';
+    }
+    FREE_ARRAY(char, writer.ptr, writer.cap);
+    return copy;
+}
 
-    // wrap in braces
-    char* temp = malloc(strlen(buffer) + 3);
-    sprintf(temp, "{%s}", buffer);
-    free(buffer);
-    buffer = temp;
+char* array_to_string(ObjArray* array)
+{
+    return writerToCString(OBJ_VAL(array));
+}
 
-    return buffer;
+char* table_to_string(ObjTable* table)
+{
+    return writerToCString(OBJ_VAL(table));
 }
 
 bool json_encode(int argCount, Value* args)
@@ -333,21 +665,19 @@ bool json_encode(int argCount, Value* args)
     phelt_checkObject(0);
 
     Obj* object = AS_OBJ(phelt_value(0));
-
-    if (object->type == OBJ_ARRAY) {
-        ObjArray* array = (ObjArray*)object;
-        char*     value = array_to_string(array);
-        phelt_pushCString(-1, value);
-        free(value);
-    } else if (object->type == OBJ_TABLE) {
-        ObjTable* table = (ObjTable*)object;
-        char*     value = table_to_string(table);
-        phelt_pushCString(-1, value);
-        free(value);
-    } else {
+    if (object->type != OBJ_ARRAY && object->type != OBJ_TABLE) {
         phelt_error("Invalid object type.");
         return false;
     }
 
+    Writer writer;
+    writerInit(&writer);
+    encodeValue(&writer, phelt_value(0));
+
+    // Shrink to the accounting takeString expects and adopt the buffer
+    // without copying it.
+    writer.ptr             = GROW_ARRAY(char, writer.ptr, writer.cap, writer.len + 1);
+    writer.ptr[writer.len] = '\0';
+    phelt_pushString(-1, takeString(writer.ptr, (int)writer.len));
     return true;
 }
@@ -0,0 +1,353 @@
+#include "native/loop.h"
+#include "memory.h"
+#include "vm.h"
+
+#include <curl/curl.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// Event loop. Scripts queue operations — timers, file reads, HTTP fetches
+// — each with a callback closure, then loop.run() drives them all to
+// completion on one thread: the curl_multi stack keeps every fetch in
+// flight at once and the loop re-enters the VM (the same REENTER path the
+// sequential natives use) as completions arrive. Dozens of in-flight
+// requests then cost roughly the slowest one, while the thread that would
+// have been blocked runs callbacks instead.
+//
+// State is per-thread like the VM itself, so worker isolates can each run
+// their own loop.
+// ---------------------------------------------------------------------------
+
+typedef struct Timer {
+    double        due;
+    ObjClosure*   callback;
+    struct Timer* next;
+} Timer;
+
+typedef struct FileOp {
+    char*          path;
+    ObjClosure*    callback;
+    struct FileOp* next;
+} FileOp;
+
+typedef struct Fetch {
+    CURL*         handle;
+    char*         body;
+    size_t        bodyLen;
+    size_t        bodyCap;
+    ObjClosure*   callback;
+    struct Fetch* next;
+} Fetch;
+
+// Shared with the blocking http natives.
+extern const char* useragent;
+
+static __thread Timer*  timers    = NULL;
+static __thread FileOp* fileOps   = NULL;
+static __thread Fetch*  fetches   = NULL;
+static __thread CURLM*  multi     = NULL;
+static __thread int     pendingOps = 0;
+
+void markLoopRoots(void)
+{
+    for (Timer* timer = timers; timer != NULL; timer = timer->next)
+        markObject((Obj*)timer->callback);
+    for (FileOp* op = fileOps; op != NULL; op = op->next)
+        markObject((Obj*)op->callback);
+    for (Fetch* fetch = fetches; fetch != NULL; fetch = fetch->next)
+        markObject((Obj*)fetch->callback);
+}
+
+static double monotonicNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Runs a callback through the VM's re-entry path — the phelt_callClosure
+// sequence, expanded so a failed call() (wrong arity, frame overflow)
+// or a runtime error inside the callback stops the loop instead of
+// running on a reset stack. The closure sits in the callee slot,
+// mirroring a scripted call.
+static bool invokeCallback(ObjClosure* callback, int argCount, Value argument)
+{
+    push(OBJ_VAL(callback));
+    if (argCount > 0)
+        push(argument);
+
+    Chunk* chunk                = &callback->function->chunk;
+    chunk->code[chunk->count - 1] = OP_REENTER;
+    if (!call(callback, argCount))
+        return false;
+    run();
+    if (vm.errorState)
+        return false;
+
+    for (int i = 0; i < argCount + 2; i++)
+        pop();
+    return true;
+}
+
+static size_t fetchWrite(void* ptr, size_t size, size_t nmemb, void* userdata)
+{
+    Fetch* fetch = userdata;
+    size_t bytes = size * nmemb;
+
+    if (fetch->bodyLen + bytes + 1 > fetch->bodyCap) {
+        size_t cap = fetch->bodyCap;
+        while (fetch->bodyLen + bytes + 1 > cap)
+            cap *= 2;
+        fetch->body    = realloc(fetch->body, cap);
+        fetch->bodyCap = cap;
+    }
+
+    memcpy(fetch->body + fetch->bodyLen, ptr, bytes);
+    fetch->bodyLen += bytes;
+    fetch->body[fetch->bodyLen] = '\0';
+    return bytes;
+}
+
+bool loop_timer(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkNumber(0);
+    phelt_checkClosure(1);
+
+    Timer* timer    = malloc(sizeof(Timer));
+    timer->due      = monotonicNow() + phelt_toNumber(0) / 1000.0;
+    timer->callback = phelt_toClosure(1);
+    timer->next     = timers;
+    timers          = timer;
+    pendingOps++;
+
+    phelt_pushNil(-1);
+    return true;
+}
+
+bool loop_readFile(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkString(0);
+    phelt_checkClosure(1);
+
+    FileOp* op   = malloc(sizeof(FileOp));
+    op->path     = strdup(phelt_toCString(0));
+    op->callback = phelt_toClosure(1);
+    op->next     = fileOps;
+    fileOps      = op;
+    pendingOps++;
+
+    phelt_pushNil(-1);
+    return true;
+}
+
+bool loop_fetch(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkString(0);
+    phelt_checkClosure(1);
+
+    if (multi == NULL)
+        multi = curl_multi_init();
+
+    Fetch* fetch   = calloc(1, sizeof(Fetch));
+    fetch->handle  = curl_easy_init();
+    fetch->bodyCap = 256;
+    fetch->body    = malloc(fetch->bodyCap);
+    fetch->body[0] = '\0';
+    fetch->callback = phelt_toClosure(1);
+    fetch->next     = fetches;
+    fetches         = fetch;
+    pendingOps++;
+
+    curl_easy_setopt(fetch->handle, CURLOPT_USERAGENT, useragent);
+    curl_easy_setopt(fetch->handle, CURLOPT_URL, phelt_toCString(0));
+    curl_easy_setopt(fetch->handle, CURLOPT_WRITEFUNCTION, fetchWrite);
+    curl_easy_setopt(fetch->handle, CURLOPT_WRITEDATA, fetch);
+    curl_easy_setopt(fetch->handle, CURLOPT_PRIVATE, fetch);
+    curl_multi_add_handle(multi, fetch->handle);
+
+    phelt_pushNil(-1);
+    return true;
+}
+
+bool loop_pending(int argCount, Value* args)
+{
+    phelt_checkArgs(0);
+    (void)args;
+
+    phelt_pushNumber(-1, pendingOps);
+    return true;
+}
+
+// Fires every timer whose deadline has passed. Leaves the delay until the
+// next one in *next (-1 with none pending); false means a callback failed.
+static bool runDueTimers(double* next)
+{
+    double now = monotonicNow();
+    *next      = -1;
+
+    Timer** link = &timers;
+    while (*link != NULL) {
+        Timer* timer = *link;
+        if (timer->due <= now) {
+            *link = timer->next;
+            pendingOps--;
+            bool ok = invokeCallback(timer->callback, 0, NIL_VAL);
+            free(timer);
+            if (!ok)
+                return false;
+            // Callbacks can queue timers; restart from the head.
+            link  = &timers;
+            now   = monotonicNow();
+            *next = -1;
+            continue;
+        }
+        double wait = timer->due - now;
+        if (*next < 0 || wait < *next)
+            *next = wait;
+        link = &timer->next;
+    }
+    return true;
+}
+
+// File reads complete in one tick: regular files are always readable, so
+// the win is ordering — queued reads interleave with fetches and timers
+// instead of blocking them.
+static bool runFileOps(void)
+{
+    while (fileOps != NULL) {
+        FileOp* op = fileOps;
+        fileOps    = op->next;
+        pendingOps--;
+
+        Value contents = NIL_VAL;
+        int   fd       = open(op->path, O_RDONLY);
+        if (fd != -1) {
+            struct stat info;
+            if (fstat(fd, &info) == 0) {
+                char*   chars = ALLOCATE(char, info.st_size + 1);
+                ssize_t got   = read(fd, chars, info.st_size);
+                if (got >= 0) {
+                    chars[got] = '\0';
+                    contents   = OBJ_VAL(takeString(chars, (int)got));
+                } else {
+                    FREE_ARRAY(char, chars, info.st_size + 1);
+                }
+            }
+            close(fd);
+        }
+
+        push(contents);
+        bool ok = invokeCallback(op->callback, 1, contents);
+        if (ok)
+            pop();
+        free(op->path);
+        free(op);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+static bool finishFetches(void)
+{
+    CURLMsg* message;
+    int      queued;
+    while ((message = curl_multi_info_read(multi, &queued)) != NULL) {
+        if (message->msg != CURLMSG_DONE)
+            continue;
+
+        Fetch* fetch;
+        curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &fetch);
+
+        Fetch** link = &fetches;
+        while (*link != fetch)
+            link = &(*link)->next;
+        *link = fetch->next;
+        pendingOps--;
+
+        long status = 0;
+        curl_easy_getinfo(fetch->handle, CURLINFO_RESPONSE_CODE, &status);
+        curl_multi_remove_handle(multi, fetch->handle);
+
+        ObjTable* response = newTable();
+        push(OBJ_VAL(response));
+        push(NUMBER_VAL(status));
+        push(OBJ_VAL(copyString("status", 6)));
+        tableSet(&response->table, vm.stackTop[-1], vm.stackTop[-2]);
+        writeBarrier((Obj*)response, vm.stackTop[-1]);
+        pop();
+        pop();
+        push(OBJ_VAL(copyString(fetch->body, (int)fetch->bodyLen)));
+        push(OBJ_VAL(copyString("body", 4)));
+        tableSet(&response->table, vm.stackTop[-1], vm.stackTop[-2]);
+        writeBarrier((Obj*)response, vm.stackTop[-1]);
+        writeBarrier((Obj*)response, vm.stackTop[-2]);
+        pop();
+        pop();
+        const char* error = message->data.result == CURLE_OK
+            ? NULL
+            : curl_easy_strerror(message->data.result);
+        push(error != NULL ? OBJ_VAL(copyString(error, (int)strlen(error))) : NIL_VAL);
+        push(OBJ_VAL(copyString("error", 5)));
+        tableSet(&response->table, vm.stackTop[-1], vm.stackTop[-2]);
+        writeBarrier((Obj*)response, vm.stackTop[-1]);
+        writeBarrier((Obj*)response, vm.stackTop[-2]);
+        pop();
+        pop();
+
+        bool ok = invokeCallback(fetch->callback, 1, OBJ_VAL(response));
+        if (ok)
+            pop();
+
+        curl_easy_cleanup(fetch->handle);
+        free(fetch->body);
+        free(fetch);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool loop_run(int argCount, Value* args)
+{
+    phelt_checkArgs(0);
+    (void)args;
+
+    while (pendingOps > 0) {
+        if (!runFileOps()) {
+            phelt_error("Event loop callback raised an error.");
+            return false;
+        }
+        double nextTimer;
+        if (!runDueTimers(&nextTimer)) {
+            phelt_error("Event loop callback raised an error.");
+            return false;
+        }
+
+        if (fetches != NULL) {
+            int running;
+            curl_multi_perform(multi, &running);
+            if (!finishFetches()) {
+                phelt_error("Event loop callback raised an error.");
+                return false;
+            }
+            if (pendingOps > 0 && fileOps == NULL) {
+                int waitMs = nextTimer < 0 ? 50 : (int)(nextTimer * 1000);
+                if (waitMs > 50)
+                    waitMs = 50;
+                curl_multi_wait(multi, NULL, 0, waitMs, NULL);
+            }
+        } else if (timers != NULL && fileOps == NULL && nextTimer > 0) {
+            usleep((useconds_t)(nextTimer * 1e6));
+        }
+    }
+
+    phelt_pushNil(-1);
+    return true;
+}
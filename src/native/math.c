@@ -1,4 +1,5 @@
 #include "native/math.h"
+#include "memory.h"
 #include "vm.h"
 #include <math.h>
 
@@ -193,12 +194,181 @@ bool math_rand(int argCount, Value* args)
     return true;
 }
 
-void mathCallback(Table* table)
+// ---------------------------------------------------------------------------
+// Bulk kernels. Statistics scripts were looping in bytecode and paying a
+// native call per element; these run one tight C loop per array instead.
+// They require all-number arrays (the same precondition the parallel
+// array kernels use) and read elements through AS_NUMBER, which is a
+// bit copy for doubles and a tag check for the small-int representation
+// — close enough to the unboxed layout for the compiler to vectorize
+// the arithmetic around it.
+// ---------------------------------------------------------------------------
+
+static bool checkNumberArray(int pos, Value* args, ObjArray** out)
+{
+    if (!IS_ARRAY(args[pos])) {
+        phelt_error("Argument must be an array.");
+        return false;
+    }
+    ObjArray* array = AS_ARRAY(args[pos]);
+    if (!array->array.allNumbers) {
+        phelt_error("Array must contain only numbers.");
+        return false;
+    }
+    *out = array;
+    return true;
+}
+
+// let total = math.sum(values)
+bool math_sum(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+
+    ObjArray* array;
+    if (!checkNumberArray(0, args, &array))
+        return false;
+
+    double sum = 0;
+    for (unsigned int i = 0; i < array->array.count; i++)
+        sum += AS_NUMBER(array->array.values[i]);
+
+    phelt_pushNumber(-1, sum);
+    return true;
+}
+
+// let product = math.dot(a, b)
+bool math_dot(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+
+    ObjArray* a;
+    ObjArray* b;
+    if (!checkNumberArray(0, args, &a) || !checkNumberArray(1, args, &b))
+        return false;
+    if (a->array.count != b->array.count) {
+        phelt_error("Arrays must have the same length.");
+        return false;
+    }
+
+    double dot = 0;
+    for (unsigned int i = 0; i < a->array.count; i++)
+        dot += AS_NUMBER(a->array.values[i]) * AS_NUMBER(b->array.values[i]);
+
+    phelt_pushNumber(-1, dot);
+    return true;
+}
+
+// Scales every element in place and returns the array, so calls chain.
+// math.scale(values, 1 / n)
+bool math_scale(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkNumber(1);
+
+    ObjArray* array;
+    if (!checkNumberArray(0, args, &array))
+        return false;
+
+    double factor = phelt_toNumber(1);
+    for (unsigned int i = 0; i < array->array.count; i++)
+        array->array.values[i] = NUMBER_VAL(AS_NUMBER(array->array.values[i]) * factor);
+
+    phelt_pushObject(-1, array);
+    return true;
+}
+
+// let bounds = math.minmax(values)  // [min, max] in one pass
+bool math_minmax(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+
+    ObjArray* array;
+    if (!checkNumberArray(0, args, &array))
+        return false;
+    if (array->array.count == 0) {
+        phelt_error("Array must not be empty.");
+        return false;
+    }
+
+    double min = AS_NUMBER(array->array.values[0]);
+    double max = min;
+    for (unsigned int i = 1; i < array->array.count; i++) {
+        double value = AS_NUMBER(array->array.values[i]);
+        if (value < min)
+            min = value;
+        if (value > max)
+            max = value;
+    }
+
+    ObjArray* bounds = newArray();
+    push(OBJ_VAL(bounds));
+    writeValueArray(&bounds->array, NUMBER_VAL(min));
+    writeValueArray(&bounds->array, NUMBER_VAL(max));
+    pop();
+
+    phelt_pushObject(-1, bounds);
+    return true;
+}
+
+// Elementwise transforms, in place, one loop per operation so each body
+// stays a straight-line candidate for auto-vectorization.
+// math.apply(values, "sqrt")
+bool math_apply(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkString(1);
+
+    ObjArray* array;
+    if (!checkNumberArray(0, args, &array))
+        return false;
+
+    Value*       values = array->array.values;
+    unsigned int count  = array->array.count;
+    const char*  op     = phelt_toCString(1);
+
+#define APPLY(fn)                                        \
+    do {                                                 \
+        for (unsigned int i = 0; i < count; i++)         \
+            values[i] = NUMBER_VAL(fn(AS_NUMBER(values[i]))); \
+    } while (0)
+
+    if (strcmp(op, "sqrt") == 0)
+        APPLY(sqrt);
+    else if (strcmp(op, "abs") == 0)
+        APPLY(fabs);
+    else if (strcmp(op, "exp") == 0)
+        APPLY(exp);
+    else if (strcmp(op, "log") == 0)
+        APPLY(log);
+    else if (strcmp(op, "sin") == 0)
+        APPLY(sin);
+    else if (strcmp(op, "cos") == 0)
+        APPLY(cos);
+    else if (strcmp(op, "floor") == 0)
+        APPLY(floor);
+    else if (strcmp(op, "ceil") == 0)
+        APPLY(ceil);
+    else if (strcmp(op, "round") == 0)
+        APPLY(round);
+    else {
+        phelt_error("Unknown operation '%s'.", op);
+        return false;
+    }
+#undef APPLY
+
+    phelt_pushObject(-1, array);
+    return true;
+}
+
+void mathCallback(ObjTable* table)
 {
-#define SET_CONST(name, value)                     \
-    push(NUMBER_VAL(value));                       \
-    push(OBJ_VAL(copyString(name, strlen(name)))); \
-    tableSet(table, pop(), pop());
+#define SET_CONST(name, value)                                \
+    push(NUMBER_VAL(value));                                  \
+    push(OBJ_VAL(copyString(name, strlen(name))));            \
+    tableSet(&table->table, vm.stackTop[-1], vm.stackTop[-2]); \
+    writeBarrier((Obj*)table, vm.stackTop[-1]);               \
+    pop();                                                    \
+    pop();
 
     SET_CONST("E", M_E);
     SET_CONST("LOG2E", M_LOG2E);
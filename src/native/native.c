@@ -1,5 +1,7 @@
 #include "native/native.h"
 
+#include "memory.h"
+
 NativeModuleEntry* findNativeModule(NativeModuleEntry* modules, const char* name)
 {
     NativeModuleEntry* module = modules;
@@ -28,14 +30,25 @@ ObjTable* defineNativeModule(NativeModuleEntry* module)
 {
     ObjTable* table = newTable();
 
+    // Keep the table and each name/function pair rooted on the stack while
+    // they are wired up; any allocation in the loop can trigger a collection.
+    push(OBJ_VAL(table));
+
     for (NativeFnEntry* entry = module->fns; entry->name != NULL; entry++) {
-        tableSet(&table->table, OBJ_VAL(copyString(entry->name, (int)strlen(entry->name))), OBJ_VAL(newNative(entry->function)));
+        push(OBJ_VAL(copyString(entry->name, (int)strlen(entry->name))));
+        push(OBJ_VAL(newNative(entry->function)));
+        tableSet(&table->table, vm.stackTop[-2], vm.stackTop[-1]);
+        writeBarrier((Obj*)table, vm.stackTop[-2]);
+        writeBarrier((Obj*)table, vm.stackTop[-1]);
+        pop();
+        pop();
     }
 
     NativeModuleCallback* callback = findNativeModuleCallback(nativeModuleCallbacks, module->name);
     if (callback != NULL)
-        callback->callback(&table->table);
+        callback->callback(table);
 
+    pop();
     return table;
 }
 
@@ -80,6 +93,11 @@ NativeFnEntry mathFns[] = {
     { "seed", math_seed },
     { "rand", math_rand },
     { "round", math_round },
+    { "sum", math_sum },
+    { "dot", math_dot },
+    { "scale", math_scale },
+    { "minmax", math_minmax },
+    { "apply", math_apply },
     { NULL, NULL },
 };
 
@@ -90,6 +108,9 @@ NativeFnEntry fileFns[] = {
     { "close", file_close },
     { "write", file_write },
     { "read", file_read },
+    { "mmap", file_mmap },
+    { "lines", file_lines },
+    { "nextLine", file_nextLine },
     { "seek", file_seek },
     { "tell", file_tell },
     { "flush", file_flush },
@@ -110,6 +131,7 @@ NativeFnEntry httpFns[] = {
     { "delete", http_delete },
     { "head", http_head },
     { "options", http_options },
+    { "batch", http_batch },
     { NULL, NULL },
 };
 
@@ -127,6 +149,9 @@ NativeFnEntry arrayFns[] = {
     { "filter", array_filter },
     { "reduce", array_reduce },
     { "flatten", array_flatten },
+    { "pmap", array_pmap },
+    { "pfilter", array_pfilter },
+    { "preduce", array_preduce },
     { NULL, NULL },
 };
 
@@ -160,8 +185,32 @@ NativeFnEntry jsonFns[] = {
     { NULL, NULL },
 };
 
+NativeFnEntry loopFns[] = {
+    { "timer", loop_timer },
+    { "readFile", loop_readFile },
+    { "fetch", loop_fetch },
+    { "pending", loop_pending },
+    { "run", loop_run },
+    { NULL, NULL },
+};
+
+NativeFnEntry workerFns[] = {
+    { "spawn", worker_spawn },
+    { "send", worker_send },
+    { "receive", worker_receive },
+    { "reply", worker_reply },
+    { "take", worker_take },
+    { "join", worker_join },
+    { NULL, NULL },
+};
+
 NativeFnEntry debugFns[] = {
     { "frame", debug_frame },
+    { "profileStart", debug_profileStart },
+    { "profileStop", debug_profileStop },
+    { "dispatchStats", debug_dispatchStats },
+    { "gcStats", debug_gcStats },
+    { "heapSnapshot", debug_heapSnapshot },
     { NULL, NULL },
 };
 
@@ -176,6 +225,8 @@ NativeModuleEntry nativeModules[] = {
     { "string", stringFns },
     { "debug", debugFns },
     { "json", jsonFns },
+    { "worker", workerFns },
+    { "loop", loopFns },
     { NULL, NULL },
 };
 
@@ -1,4 +1,5 @@
 #include "native/string.h"
+#include "memory.h"
 
 bool string_length(int argCount, Value* args)
 {
@@ -6,7 +7,11 @@ bool string_length(int argCount, Value* args)
     phelt_checkString(0);
 
     ObjString* string = phelt_toString(0);
-    phelt_pushNumber(-1, utf8len(string->chars));
+    if (string->ascii) {
+        phelt_pushNumber(-1, string->length);
+        return true;
+    }
+    phelt_pushNumber(-1, utf8len(stringChars(string)));
     return true;
 }
 
@@ -91,11 +96,18 @@ bool string_split(int argCount, Value* args)
 
     ObjArray* array = newArray();
 
+    // The array and each fresh token stay rooted across the append; the
+    // append itself can allocate and trigger a collection.
+    push(OBJ_VAL(array));
+
     for (size_t i = 0; i < token_count; i++) {
-        ObjString* token = takeString(tokens[i], strlen(tokens[i]));
-        writeValueArray(&array->array, OBJ_VAL(token));
+        push(OBJ_VAL(takeString(tokens[i], strlen(tokens[i]))));
+        writeValueArray(&array->array, vm.stackTop[-1]);
+        writeBarrier((Obj*)array, vm.stackTop[-1]);
+        pop();
     }
 
+    pop();
     free(tokens);
     phelt_pushObject(-1, array);
     return true;
@@ -111,7 +123,10 @@ bool string_trim(int argCount, Value* args)
     char* trim   = phelt_toCString(1);
     char* copy   = copyStringRaw(string, strlen(string));
     trim_utf8(copy, trim);
-    phelt_pushString(-1, takeString(copy, strlen(copy)));
+    // Trimming shrinks the buffer in place, so it can't be handed to
+    // takeString: the allocator would release it at the wrong size later.
+    phelt_pushString(-1, copyString(copy, strlen(copy)));
+    FREE_ARRAY(char, copy, strlen(string) + 1);
     return true;
 }
 
@@ -12,7 +12,7 @@ bool system_env(int argCount, Value* args)
 {
     phelt_checkArgs(1);
     phelt_checkString(0);
-    char* env = getenv(phelt_toString(0)->chars);
+    char* env = getenv(phelt_toCString(0));
     phelt_pushValue(-1, OBJ_VAL(copyString(env, strlen(env))));
     return true;
 }
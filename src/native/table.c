@@ -1,4 +1,5 @@
 #include "native/table.h"
+#include "memory.h"
 
 bool table_length(int argCount, Value* args)
 {
@@ -17,12 +18,15 @@ bool table_keys(int argCount, Value* args)
 
     ObjTable* table = phelt_toTable(0);
     ObjArray* array = newArray();
+    push(OBJ_VAL(array));
     for (unsigned int i = 0; i < table->table.capacity; i++) {
         Entry* entry = &table->table.entries[i];
         if (!IS_EMPTY(entry->key)) {
             writeValueArray(&array->array, entry->key);
+            writeBarrier((Obj*)array, entry->key);
         }
     }
+    pop();
     phelt_pushObject(-1, (Obj*)array);
     return true;
 }
@@ -34,12 +38,15 @@ bool table_values(int argCount, Value* args)
 
     ObjTable* table = phelt_toTable(0);
     ObjArray* array = newArray();
+    push(OBJ_VAL(array));
     for (unsigned int i = 0; i < table->table.capacity; i++) {
         Entry* entry = &table->table.entries[i];
         if (!IS_EMPTY(entry->key)) {
             writeValueArray(&array->array, entry->value);
+            writeBarrier((Obj*)array, entry->value);
         }
     }
+    pop();
     phelt_pushObject(-1, (Obj*)array);
     return true;
 }
@@ -71,5 +78,7 @@ bool table_insert(int argCount, Value* args)
 
     ObjTable* table = phelt_toTable(0);
     tableSet(&table->table, phelt_value(1), phelt_value(2));
+    writeBarrier((Obj*)table, phelt_value(1));
+    writeBarrier((Obj*)table, phelt_value(2));
     return true;
 }
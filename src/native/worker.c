@@ -0,0 +1,323 @@
+#include "native/worker.h"
+#include "vm.h"
+
+#include <pthread.h>
+
+// Worker isolates. Each spawn starts an OS thread running a private
+// interpreter — the VM, compiler and scanner state are all thread-local —
+// so workers share no heap, no GC and no interned strings with the
+// spawning script, and the hot paths stay lock-free. Cross-thread state
+// is limited to the per-worker message queues below, which hand values
+// across the isolate boundary by copy — scalars travel as themselves,
+// arrays and tables as JSON rebuilt on the receiving heap — and the
+// lock-guarded import-path cache in common.c.
+
+// From src/native/json.c; used to flatten containers into transferable text.
+char* array_to_string(ObjArray* array);
+char* table_to_string(ObjTable* table);
+
+typedef enum {
+    MSG_NIL,
+    MSG_BOOL,
+    MSG_NUMBER,
+    MSG_STRING,
+    MSG_JSON
+} MessageKind;
+
+typedef struct Message {
+    MessageKind     kind;
+    bool            boolean;
+    double          number;
+    char*           text;
+    struct Message* next;
+} Message;
+
+typedef struct {
+    Message* head;
+    Message* tail;
+} Queue;
+
+typedef struct {
+    pthread_t       thread;
+    char*           source;
+    pthread_mutex_t lock;
+    pthread_cond_t  inboxReady;
+    pthread_cond_t  outboxReady;
+    Queue           inbox;
+    Queue           outbox;
+    bool            done;
+    bool            joined;
+} Worker;
+
+#define WORKER_MAX 64
+
+static Worker*         workers[WORKER_MAX];
+static int             workerCount  = 0;
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Set inside a worker thread so receive() and reply() know their queues.
+static __thread Worker* currentWorker = NULL;
+
+static void enqueue(Queue* queue, Message* message)
+{
+    message->next = NULL;
+    if (queue->tail == NULL) {
+        queue->head = message;
+    } else {
+        queue->tail->next = message;
+    }
+    queue->tail = message;
+}
+
+static Message* dequeue(Queue* queue)
+{
+    Message* message = queue->head;
+    queue->head      = message->next;
+    if (queue->head == NULL)
+        queue->tail = NULL;
+    return message;
+}
+
+// Copies a value out of the sending isolate into a heap-only Message.
+// Returns NULL for values that cannot cross the boundary (functions,
+// classes, instances, pointers).
+static Message* encodeMessage(Value value)
+{
+    Message* message = calloc(1, sizeof(Message));
+    if (message == NULL)
+        return NULL;
+
+    if (IS_NIL(value)) {
+        message->kind = MSG_NIL;
+    } else if (IS_BOOL(value)) {
+        message->kind    = MSG_BOOL;
+        message->boolean = AS_BOOL(value);
+    } else if (IS_NUMBER(value)) {
+        message->kind   = MSG_NUMBER;
+        message->number = AS_NUMBER(value);
+    } else if (IS_STRING(value)) {
+        message->kind = MSG_STRING;
+        message->text = strdup(AS_CSTRING(value));
+    } else if (IS_ARRAY(value)) {
+        message->kind = MSG_JSON;
+        message->text = array_to_string(AS_ARRAY(value));
+    } else if (IS_TABLE(value)) {
+        message->kind = MSG_JSON;
+        message->text = table_to_string(AS_TABLE(value));
+    } else {
+        free(message);
+        return NULL;
+    }
+    return message;
+}
+
+// Rebuilds a Message as a value on the receiving isolate's heap and frees
+// it. Containers round-trip through the json module's decoder.
+static Value decodeMessage(Message* message)
+{
+    Value value = NIL_VAL;
+    switch (message->kind) {
+    case MSG_NIL:
+        break;
+    case MSG_BOOL:
+        value = BOOL_VAL(message->boolean);
+        break;
+    case MSG_NUMBER:
+        value = NUMBER_VAL(message->number);
+        break;
+    case MSG_STRING:
+        value = OBJ_VAL(copyString(message->text, (int)strlen(message->text)));
+        break;
+    case MSG_JSON: {
+        // Call the decoder the way the VM would: a result slot below one
+        // argument slot on this thread's stack.
+        push(NIL_VAL);
+        push(OBJ_VAL(copyString(message->text, (int)strlen(message->text))));
+        if (json_decode(1, vm.stackTop - 1)) {
+            pop();
+            value = pop();
+        } else {
+            pop();
+            pop();
+        }
+        break;
+    }
+    }
+
+    free(message->text);
+    free(message);
+    return value;
+}
+
+static void* workerMain(void* arg)
+{
+    Worker* worker = arg;
+    currentWorker  = worker;
+
+    initVM(0, 0);
+    interpret("<worker>", worker->source);
+    freeVM();
+
+    pthread_mutex_lock(&worker->lock);
+    worker->done = true;
+    pthread_cond_broadcast(&worker->outboxReady);
+    pthread_mutex_unlock(&worker->lock);
+    return NULL;
+}
+
+static Worker* workerById(int id)
+{
+    pthread_mutex_lock(&registryLock);
+    Worker* worker = (id >= 0 && id < workerCount) ? workers[id] : NULL;
+    pthread_mutex_unlock(&registryLock);
+    return worker;
+}
+
+bool worker_spawn(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkString(0);
+
+    Worker* worker = calloc(1, sizeof(Worker));
+    if (worker == NULL) {
+        phelt_error("Could not allocate worker.");
+        return false;
+    }
+    worker->source = strdup(phelt_toCString(0));
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->inboxReady, NULL);
+    pthread_cond_init(&worker->outboxReady, NULL);
+
+    pthread_mutex_lock(&registryLock);
+    if (workerCount == WORKER_MAX) {
+        pthread_mutex_unlock(&registryLock);
+        free(worker->source);
+        free(worker);
+        phelt_error("Too many workers.");
+        return false;
+    }
+    int id       = workerCount++;
+    workers[id]  = worker;
+    pthread_mutex_unlock(&registryLock);
+
+    if (pthread_create(&worker->thread, NULL, workerMain, worker) != 0) {
+        phelt_error("Could not start worker thread.");
+        return false;
+    }
+
+    phelt_pushNumber(-1, id);
+    return true;
+}
+
+bool worker_send(int argCount, Value* args)
+{
+    phelt_checkArgs(2);
+    phelt_checkNumber(0);
+
+    Worker* worker = workerById((int)phelt_toNumber(0));
+    if (worker == NULL) {
+        phelt_error("Unknown worker.");
+        return false;
+    }
+
+    Message* message = encodeMessage(phelt_value(1));
+    if (message == NULL) {
+        phelt_error("Value cannot be sent to a worker.");
+        return false;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    enqueue(&worker->inbox, message);
+    pthread_cond_signal(&worker->inboxReady);
+    pthread_mutex_unlock(&worker->lock);
+
+    phelt_pushNil(-1);
+    return true;
+}
+
+bool worker_receive(int argCount, Value* args)
+{
+    phelt_checkArgs(0);
+
+    Worker* worker = currentWorker;
+    if (worker == NULL) {
+        phelt_error("receive() may only be called inside a worker.");
+        return false;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    while (worker->inbox.head == NULL)
+        pthread_cond_wait(&worker->inboxReady, &worker->lock);
+    Message* message = dequeue(&worker->inbox);
+    pthread_mutex_unlock(&worker->lock);
+
+    phelt_push(-1, decodeMessage(message));
+    return true;
+}
+
+bool worker_reply(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+
+    Worker* worker = currentWorker;
+    if (worker == NULL) {
+        phelt_error("reply() may only be called inside a worker.");
+        return false;
+    }
+
+    Message* message = encodeMessage(phelt_value(0));
+    if (message == NULL) {
+        phelt_error("Value cannot be sent from a worker.");
+        return false;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    enqueue(&worker->outbox, message);
+    pthread_cond_signal(&worker->outboxReady);
+    pthread_mutex_unlock(&worker->lock);
+
+    phelt_pushNil(-1);
+    return true;
+}
+
+bool worker_take(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkNumber(0);
+
+    Worker* worker = workerById((int)phelt_toNumber(0));
+    if (worker == NULL) {
+        phelt_error("Unknown worker.");
+        return false;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    while (worker->outbox.head == NULL && !worker->done)
+        pthread_cond_wait(&worker->outboxReady, &worker->lock);
+    Message* message = worker->outbox.head != NULL ? dequeue(&worker->outbox) : NULL;
+    pthread_mutex_unlock(&worker->lock);
+
+    // A nil from take() means the worker exited with nothing queued.
+    phelt_push(-1, message != NULL ? decodeMessage(message) : NIL_VAL);
+    return true;
+}
+
+bool worker_join(int argCount, Value* args)
+{
+    phelt_checkArgs(1);
+    phelt_checkNumber(0);
+
+    Worker* worker = workerById((int)phelt_toNumber(0));
+    if (worker == NULL) {
+        phelt_error("Unknown worker.");
+        return false;
+    }
+
+    if (!worker->joined) {
+        pthread_join(worker->thread, NULL);
+        worker->joined = true;
+    }
+
+    phelt_pushNil(-1);
+    return true;
+}
@@ -1,6 +1,7 @@
 #include "object.h"
 #include "common.h"
 #include "memory.h"
+#include "stringbuilder.h"
 #include "table.h"
 #include "value.h"
 #include "vm.h"
@@ -11,11 +12,21 @@
 
 static Obj* allocateObject(size_t size, ObjType type)
 {
-    Obj* object      = (Obj*)reallocate(NULL, 0, size);
-    object->isMarked = false;
-    object->type     = type;
-    object->next     = vm.objects;
-    vm.objects       = object;
+    Obj* object          = (Obj*)reallocate(NULL, 0, size);
+    object->isMarked     = false;
+    object->isOld        = false;
+    object->isRemembered = false;
+    object->type         = type;
+
+    // The registry grows with the system allocator so appending can never
+    // re-enter the collector.
+    if (vm.objectCapacity < vm.objectCount + 1) {
+        vm.objectCapacity = GROW_CAPACITY(vm.objectCapacity);
+        vm.objects        = (Obj**)realloc(vm.objects, sizeof(Obj*) * vm.objectCapacity);
+        if (vm.objects == NULL)
+            exit(1);
+    }
+    vm.objects[vm.objectCount++] = object;
 
 #ifdef DEBUG_LOG_GC
     printf("%p allocate %zu for %d\n", (void*)object, size, type);
@@ -35,23 +46,190 @@ ObjBoundMethod* newBoundMethod(Value receiver, ObjClosure* method)
 ObjClass* newClass(ObjString* name)
 {
     ObjClass* klass = ALLOCATE_OBJ(ObjClass, OBJ_CLASS);
-    klass->name     = name;
+    klass->name       = name;
+    klass->shape      = NULL;
+    klass->superclass = NULL;
     initTable(&klass->methods);
     initTable(&klass->fields);
+    for (int i = 0; i < OPERATOR_COUNT; i++) {
+        klass->operators[i] = NULL;
+    }
     return klass;
 }
 
+// Resolve a method by walking the superclass chain. Each class's methods
+// table holds only its own definitions, so a miss falls through to the
+// parent; call sites cache the resolved closure, keeping the walk off the
+// hot path.
+bool classMethod(ObjClass* klass, Value name, Value* method)
+{
+    for (; klass != NULL; klass = klass->superclass) {
+        if (tableGet(&klass->methods, name, method))
+            return true;
+    }
+    return false;
+}
+
+ObjShape* newShape(ObjShape* parent, Value name)
+{
+    ObjShape* shape  = ALLOCATE_OBJ(ObjShape, OBJ_SHAPE);
+    shape->parent    = parent;
+    shape->name      = name;
+    shape->slot      = parent == NULL ? -1 : parent->slotCount;
+    shape->slotCount = parent == NULL ? 0 : parent->slotCount + 1;
+    initTable(&shape->edges);
+    initTable(&shape->slots);
+
+    if (parent != NULL) {
+        push(OBJ_VAL(shape));
+        tableAddAll(&parent->slots, &shape->slots);
+        tableSet(&shape->slots, name, NUMBER_VAL(shape->slot));
+        pop();
+    }
+
+    return shape;
+}
+
+ObjShape* shapeAdvance(ObjShape* shape, Value name)
+{
+    Value next;
+    if (tableGet(&shape->edges, name, &next))
+        return (ObjShape*)AS_OBJ(next);
+
+    ObjShape* child = newShape(shape, name);
+    push(OBJ_VAL(child));
+    tableSet(&shape->edges, name, OBJ_VAL(child));
+    writeBarrier((Obj*)shape, name);
+    writeBarrier((Obj*)shape, OBJ_VAL(child));
+    pop();
+    return child;
+}
+
+// Advance shape over a class's declared fields, ancestors first so inherited
+// fields claim the lower slots. A field redeclared down the chain reuses the
+// ancestor's slot instead of minting a second one.
+static ObjShape* classFieldsShape(ObjClass* klass, ObjShape* shape)
+{
+    if (klass->superclass != NULL)
+        shape = classFieldsShape(klass->superclass, shape);
+
+    for (unsigned int i = 0; i < klass->fields.capacity; i++) {
+        Entry* entry = &klass->fields.entries[i];
+        if (IS_EMPTY(entry->key))
+            continue;
+        Value slot;
+        if (!tableGet(&shape->slots, entry->key, &slot))
+            shape = shapeAdvance(shape, entry->key);
+    }
+
+    return shape;
+}
+
+// The shape shared by freshly constructed instances of a class, covering the
+// class's declared field defaults. Built once, on first instantiation.
+static ObjShape* classShape(ObjClass* klass)
+{
+    if (klass->shape != NULL)
+        return klass->shape;
+
+    ObjShape* shape = classFieldsShape(klass, vm.rootShape);
+
+    klass->shape = shape;
+    writeBarrier((Obj*)klass, OBJ_VAL(shape));
+    return shape;
+}
+
+// Copy a class's field defaults into a fresh instance, ancestors first so a
+// redeclared field takes the subclass's value. Fields added to the class
+// after its shape was memoized fall back to a shape transition.
+static void copyFieldDefaults(ObjInstance* instance, ObjShape* shape, ObjClass* klass)
+{
+    if (klass->superclass != NULL)
+        copyFieldDefaults(instance, shape, klass->superclass);
+
+    for (unsigned int i = 0; i < klass->fields.capacity; i++) {
+        Entry* entry = &klass->fields.entries[i];
+        if (!IS_EMPTY(entry->key)) {
+            Value slot;
+            if (tableGet(&shape->slots, entry->key, &slot)) {
+                instance->slots[(int)AS_NUMBER(slot)] = entry->value;
+            } else {
+                instanceSetField(instance, entry->key, entry->value);
+            }
+        }
+    }
+}
+
 ObjInstance* newInstance(ObjClass* klass)
 {
-    ObjInstance* instance = ALLOCATE_OBJ(ObjInstance, OBJ_INSTANCE);
-    instance->klass       = klass;
-    initTable(&instance->fields);
-    tableAddAll(&instance->klass->fields, &instance->fields);
+    ObjInstance* instance  = ALLOCATE_OBJ(ObjInstance, OBJ_INSTANCE);
+    instance->klass        = klass;
+    instance->shape        = NULL;
+    instance->slotCapacity = 0;
+    instance->slots        = NULL;
+
+    push(OBJ_VAL(instance));
+    ObjShape* shape = classShape(klass);
+    if (shape->slotCount > 0) {
+        instance->slots = ALLOCATE(Value, shape->slotCount);
+        for (int i = 0; i < shape->slotCount; i++) {
+            instance->slots[i] = NIL_VAL;
+        }
+        instance->slotCapacity = shape->slotCount;
+    }
+    instance->shape = shape;
+
+    copyFieldDefaults(instance, shape, klass);
+    pop();
+
     return instance;
 }
 
+bool instanceGetField(ObjInstance* instance, Value name, Value* value)
+{
+    Value slot;
+    if (instance->shape == NULL || !tableGet(&instance->shape->slots, name, &slot))
+        return false;
+
+    *value = instance->slots[(int)AS_NUMBER(slot)];
+    return true;
+}
+
+void instanceSetField(ObjInstance* instance, Value name, Value value)
+{
+    Value slot;
+    if (tableGet(&instance->shape->slots, name, &slot)) {
+        instance->slots[(int)AS_NUMBER(slot)] = value;
+        writeBarrier((Obj*)instance, value);
+        return;
+    }
+
+    ObjShape* child = shapeAdvance(instance->shape, name);
+    if (child->slotCount > instance->slotCapacity) {
+        int oldCapacity        = instance->slotCapacity;
+        int newCapacity        = GROW_CAPACITY(oldCapacity);
+        instance->slots        = GROW_ARRAY(Value, instance->slots, oldCapacity, newCapacity);
+        instance->slotCapacity = newCapacity;
+        for (int i = oldCapacity; i < newCapacity; i++) {
+            instance->slots[i] = NIL_VAL;
+        }
+    }
+
+    instance->slots[child->slot] = value;
+    instance->shape              = child;
+    writeBarrier((Obj*)instance, value);
+    writeBarrier((Obj*)instance, OBJ_VAL(child));
+}
+
 ObjClosure* newClosure(ObjFunction* function)
 {
+    // A zero-upvalue closure is stateless, so the function literal's every
+    // evaluation can hand out the same object — the common case for
+    // callbacks re-created inside a loop.
+    if (function->upvalueCount == 0 && function->sharedClosure != NULL) {
+        return function->sharedClosure;
+    }
+
     ObjClosure* closure = ALLOCATE_OBJ(ObjClosure, OBJ_CLOSURE);
 
     ObjUpvalue** upvalues = ALLOCATE(ObjUpvalue*,
@@ -63,15 +241,23 @@ ObjClosure* newClosure(ObjFunction* function)
     closure->function     = function;
     closure->upvalues     = upvalues;
     closure->upvalueCount = function->upvalueCount;
+
+    if (function->upvalueCount == 0) {
+        function->sharedClosure = closure;
+        writeBarrier((Obj*)function, OBJ_VAL(closure));
+    }
     return closure;
 }
 
 ObjFunction* newFunction(void)
 {
     ObjFunction* function  = ALLOCATE_OBJ(ObjFunction, OBJ_FUNCTION);
-    function->arity        = 0;
-    function->upvalueCount = 0;
-    function->name         = NULL;
+    function->arity         = 0;
+    function->upvalueCount  = 0;
+    function->name          = NULL;
+    function->sharedClosure = NULL;
+    function->hotness       = 0;
+    function->jit           = NULL;
     initChunk(&function->chunk);
     return function;
 }
@@ -83,30 +269,109 @@ ObjNative* newNative(NativeFn function)
     return native;
 }
 
+// Strings below this length store their characters inline in the object
+// allocation itself, so the common short string costs one allocation and
+// one cache line instead of two.
+#define STRING_EMBED_MAX 24
+
+// Strings at or above this length skip vm.strings entirely: identifiers
+// and table keys never get this long, and hashing plus probing a
+// multi-megabyte file read for a dedup that never hits is pure waste.
+// Their hash stays deferred until first use as a key, like concatenation
+// results.
+#define STRING_INTERN_MAX 256
+
+static bool scanAscii(const char* chars, int length)
+{
+    for (int i = 0; i < length; i++) {
+        if ((uint8_t)chars[i] & 0x80)
+            return false;
+    }
+    return true;
+}
+
 static ObjString* allocateString(char* chars, int length, uint32_t hash)
 {
     ObjString* string = ALLOCATE_OBJ(ObjString, OBJ_STRING);
     string->length    = length;
     string->chars     = chars;
     string->hash      = hash;
+    string->buffer    = NULL;
+    string->interned  = true;
+    string->hashed    = true;
+    string->ascii     = scanAscii(chars, length);
+    string->mapped    = false;
+    push(OBJ_VAL(string));
+    tableSet(&vm.strings, OBJ_VAL(string), NIL_VAL);
+    pop();
+    return string;
+}
+
+// Build a short string with inline storage. The source must stay valid
+// across the object allocation — the same contract copyString already
+// imposes on its callers.
+static ObjString* embedString(const char* chars, int length, uint32_t hash)
+{
+    ObjString* string = (ObjString*)allocateObject(sizeof(ObjString) + length + 1, OBJ_STRING);
+    string->length    = length;
+    string->chars     = string->embedded;
+    memcpy(string->embedded, chars, length);
+    string->embedded[length] = '\0';
+    string->hash             = hash;
+    string->buffer           = NULL;
+    string->interned         = true;
+    string->hashed           = true;
+    string->ascii            = scanAscii(chars, length);
+    string->mapped           = false;
     push(OBJ_VAL(string));
     tableSet(&vm.strings, OBJ_VAL(string), NIL_VAL);
     pop();
     return string;
 }
 
+// Word-at-a-time multiply-mix hash (wyhash-style), folded to the 32 bits
+// the tables store. Replaces byte-at-a-time FNV-1a; eight bytes per
+// round keeps hashing off the profile even for longer keys.
 static uint32_t hashString(const char* key, int length)
 {
-    uint32_t hash = 2166136261u;
-    for (int i = 0; i < length; i++) {
-        hash ^= (uint8_t)key[i];
-        hash *= 16777619;
+    const uint64_t prime = 0x9E3779B97F4A7C15ULL;
+    uint64_t       hash  = prime ^ (uint32_t)length;
+
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, key, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+        key += 8;
+        length -= 8;
     }
-    return hash;
+    uint64_t tail = 0;
+    memcpy(&tail, key, length);
+    hash = (hash ^ tail) * prime;
+    hash ^= hash >> 32;
+    return (uint32_t)hash;
+}
+
+// Adopt a heap buffer as a string without interning or hashing it.
+static ObjString* adoptString(char* chars, int length)
+{
+    ObjString* string = ALLOCATE_OBJ(ObjString, OBJ_STRING);
+    string->length    = length;
+    string->chars     = chars;
+    string->hash      = 0;
+    string->buffer    = NULL;
+    string->interned  = false;
+    string->hashed    = false;
+    string->ascii     = scanAscii(chars, length);
+    string->mapped    = false;
+    return string;
 }
 
 ObjString* takeString(char* chars, int length)
 {
+    if (length >= STRING_INTERN_MAX)
+        return adoptString(chars, length);
+
     uint32_t   hash     = hashString(chars, length);
     ObjString* interned = tableFindString(&vm.strings, chars, length, hash);
     if (interned != NULL) {
@@ -114,22 +379,159 @@ ObjString* takeString(char* chars, int length)
         return interned;
     }
 
+    if (length < STRING_EMBED_MAX) {
+        ObjString* string = embedString(chars, length, hash);
+        FREE_ARRAY(char, chars, length + 1);
+        return string;
+    }
+
     return allocateString(chars, length, hash);
 }
 
 ObjString* copyString(const char* chars, int length)
 {
+    if (length >= STRING_INTERN_MAX)
+        return uninternedString(chars, length);
+
     uint32_t   hash     = hashString(chars, length);
     ObjString* interned = tableFindString(&vm.strings, chars, length, hash);
     if (interned != NULL)
         return interned;
 
+    if (length < STRING_EMBED_MAX)
+        return embedString(chars, length, hash);
+
     char* heapChars = ALLOCATE(char, length + 1);
     memcpy(heapChars, chars, length);
     heapChars[length] = '\0';
     return allocateString(heapChars, length, hash);
 }
 
+// Adopt a read-only file mapping as a string without copying it. The
+// bytes stay in the page cache, so they skip interning (hashing a mapped
+// log file would read the whole thing) and the GC's byte accounting (a
+// gigabyte of mapping should not trigger collections). ascii stays
+// conservatively false for the same reason: computing it would fault in
+// every page up front. Freed with munmap in freeObject.
+ObjString* mappedString(char* chars, int length)
+{
+    ObjString* string = ALLOCATE_OBJ(ObjString, OBJ_STRING);
+    string->length    = length;
+    string->chars     = chars;
+    string->hash      = 0;
+    string->buffer    = NULL;
+    string->interned  = false;
+    string->hashed    = false;
+    string->ascii     = false;
+    string->mapped    = true;
+    return string;
+}
+
+// Copy bytes into a fresh string without consulting or populating
+// vm.strings. json_decode uses this for decoded string values: a large
+// dump carries millions of mostly-distinct payload strings, and interning
+// each one hashes every byte and grows the intern table for a dedup that
+// never pays off. Hashing is deferred until the string is used as a key;
+// storage is inline at any length, so each value costs one allocation.
+ObjString* uninternedString(const char* chars, int length)
+{
+    ObjString* string = (ObjString*)allocateObject(sizeof(ObjString) + length + 1, OBJ_STRING);
+    string->length    = length;
+    string->chars     = string->embedded;
+    memcpy(string->embedded, chars, length);
+    string->embedded[length] = '\0';
+    string->hash             = 0;
+    string->buffer           = NULL;
+    string->interned         = false;
+    string->hashed           = false;
+    string->ascii            = scanAscii(chars, length);
+    string->mapped           = false;
+    return string;
+}
+
+// Concatenate without interning. The result points into a shared append
+// buffer and extends it in place when the left operand is the buffer's
+// tip, so a `out = out + piece` loop costs amortized O(1) per step instead
+// of copying the whole accumulator every time. Both operands must be
+// rooted by the caller; interning and hashing are deferred until someone
+// needs them.
+ObjString* concatStrings(ObjString* a, ObjString* b)
+{
+    int length = a->length + b->length;
+
+    // Short results stay on the interned, inline-storage fast path.
+    if (length < STRING_EMBED_MAX) {
+        char scratch[STRING_EMBED_MAX];
+        memcpy(scratch, a->chars, a->length);
+        memcpy(scratch + a->length, b->chars, b->length);
+        return copyString(scratch, length);
+    }
+
+    StringBuffer* buffer = a->buffer;
+    if (buffer != NULL && a->length == buffer->used
+        && buffer->used + b->length <= buffer->capacity) {
+        memcpy(buffer->data + buffer->used, b->chars, b->length);
+        buffer->used += b->length;
+        buffer->data[buffer->used] = '\0';
+    } else {
+        int           capacity = length * 2;
+        StringBuffer* grown    = (StringBuffer*)reallocate(NULL, 0, sizeof(StringBuffer) + capacity + 1);
+        grown->capacity        = capacity;
+        grown->used            = length;
+        grown->refs            = 0;
+        memcpy(grown->data, a->chars, a->length);
+        memcpy(grown->data + a->length, b->chars, b->length);
+        grown->data[length] = '\0';
+        buffer              = grown;
+    }
+
+    ObjString* string = (ObjString*)allocateObject(sizeof(ObjString), OBJ_STRING);
+    string->length    = length;
+    string->chars     = buffer->data;
+    string->hash      = 0;
+    string->buffer    = buffer;
+    string->interned  = false;
+    string->hashed    = false;
+    string->ascii     = a->ascii && b->ascii;
+    string->mapped    = false;
+    buffer->refs++;
+    return string;
+}
+
+void releaseStringBuffer(StringBuffer* buffer)
+{
+    if (--buffer->refs == 0) {
+        reallocate(buffer, sizeof(StringBuffer) + buffer->capacity + 1, 0);
+    }
+}
+
+// Hand back a NUL-terminated view of the string. A string that is no
+// longer the tip of its shared buffer has had the byte at its own length
+// overwritten by a later append, so it detaches into a private copy first.
+char* stringChars(ObjString* string)
+{
+    StringBuffer* buffer = string->buffer;
+    if (buffer == NULL || string->length == buffer->used)
+        return string->chars;
+
+    char* chars = ALLOCATE(char, string->length + 1);
+    memcpy(chars, buffer->data, string->length);
+    chars[string->length] = '\0';
+    string->chars         = chars;
+    string->buffer        = NULL;
+    releaseStringBuffer(buffer);
+    return chars;
+}
+
+uint32_t stringHash(ObjString* string)
+{
+    if (!string->hashed) {
+        string->hash   = hashString(string->chars, string->length);
+        string->hashed = true;
+    }
+    return string->hash;
+}
+
 char* copyStringRaw(const char* chars, int length)
 {
     char* heapChars = ALLOCATE(char, length + 1);
@@ -140,34 +542,15 @@ char* copyStringRaw(const char* chars, int length)
 
 ObjString* formatString(const char* format, ...)
 {
-    char*   buffer = NULL;
-    va_list args;
-    va_start(args, format);
-
-    int len = vsnprintf(NULL, 0, format, args);
-    if (len < 0) {
-        return NULL;
-    }
-
-    buffer = malloc(len + 1);
-    if (!buffer) {
-        return NULL;
-    }
+    StringBuilder sb;
+    sbInit(&sb);
 
-    va_end(args);
+    va_list args;
     va_start(args, format);
-    vsnprintf(buffer, len, format, args);
+    sbAppendVFormat(&sb, format, args);
     va_end(args);
 
-    uint32_t   hash     = hashString(buffer, len);
-    ObjString* interned = tableFindString(&vm.strings, buffer, len, hash);
-    if (interned != NULL)
-        return interned;
-
-    char* heapChars = ALLOCATE(char, len + 1);
-    memcpy(heapChars, buffer, len);
-    heapChars[len] = '\0';
-    return allocateString(heapChars, len, hash);
+    return sbFinish(&sb);
 }
 
 ObjUpvalue* newUpvalue(Value* slot)
@@ -236,6 +619,8 @@ const char* objectType(Value value)
         return "array";
     case OBJ_UPVALUE:
         return "upvalue";
+    case OBJ_SHAPE:
+        return "shape";
     }
     return "unknown";
 }
@@ -273,6 +658,9 @@ void printObject(Value value)
     case OBJ_UPVALUE:
         printf("upvalue");
         break;
+    case OBJ_SHAPE:
+        printf("shape");
+        break;
     }
 }
 
@@ -309,6 +697,9 @@ void dumpObject(Value value)
     case OBJ_UPVALUE:
         printf("upvalue");
         break;
+    case OBJ_SHAPE:
+        printf("shape");
+        break;
     }
 }
 
@@ -325,7 +716,7 @@ char* objectString(Value value)
         Value        method   = OBJ_VAL(vm.strString);
 
         Value value;
-        if (!tableGet(&instance->klass->methods, method, &value)) {
+        if (!classMethod(instance->klass, method, &value)) {
             printf("Could not find method %s on class %s\n", AS_CSTRING(method), AS_CSTRING(OBJ_VAL(instance->klass->name)));
             return instance->klass->name->chars;
         }
@@ -352,6 +743,8 @@ char* objectString(Value value)
         return "array";
     case OBJ_UPVALUE:
         return "upvalue";
+    case OBJ_SHAPE:
+        return "shape";
     }
 }
 
@@ -365,8 +758,11 @@ int objectLength(Value object)
     case OBJ_FUNCTION:
     case OBJ_NATIVE:
     case OBJ_UPVALUE:
+    case OBJ_SHAPE:
         return -1;
     case OBJ_STRING:
+        if (AS_STRING(object)->ascii)
+            return AS_STRING(object)->length;
         return utf8len(AS_CSTRING(object));
     case OBJ_TABLE:
         return AS_TABLE(object)->table.count;
@@ -0,0 +1,120 @@
+#include "phelt.h"
+#include "object.h"
+#include "vm.h"
+
+// Embedding contexts. The interpreter core keeps its state in the single
+// global `vm`, and every hot path (the dispatch loop, push/pop, the GC)
+// leans on that for zero-indirection access. Rather than threading a VM*
+// through all of them, a context owns a complete VM image and the API
+// swaps it into the global before touching the interpreter. The swap is a
+// struct copy — everything the VM points at (heap, stack, tables) moves
+// with it — so switching contexts costs a few hundred bytes of memcpy,
+// not a reinitialization.
+struct PheltContext {
+    VM state;
+};
+
+static PheltContext* activeContext = NULL;
+
+static void makeCurrent(PheltContext* context)
+{
+    if (activeContext == context)
+        return;
+
+    if (activeContext != NULL)
+        activeContext->state = vm;
+    vm            = context->state;
+    activeContext = context;
+}
+
+PheltContext* pheltNewContext(int frameLimit, size_t stackSlots)
+{
+    PheltContext* context = malloc(sizeof(PheltContext));
+    if (context == NULL)
+        return NULL;
+
+    if (activeContext != NULL)
+        activeContext->state = vm;
+    initVM(frameLimit, stackSlots);
+    activeContext = context;
+    return context;
+}
+
+void pheltFreeContext(PheltContext* context)
+{
+    makeCurrent(context);
+    freeVM();
+    activeContext = NULL;
+    free(context);
+}
+
+PheltStatus pheltRun(PheltContext* context, const char* sourcePath, const char* source)
+{
+    makeCurrent(context);
+
+    // A placeholder path never stat()s to an existing file, so the
+    // compiled-chunk cache quietly sits this run out.
+    if (sourcePath == NULL)
+        sourcePath = "<embedded>";
+
+    switch (interpret(sourcePath, (utf8_int8_t*)source)) {
+    case INTERPRET_OK:
+        return PHELT_OK;
+    case INTERPRET_COMPILE_ERROR:
+        return PHELT_COMPILE_ERROR;
+    default:
+        return PHELT_RUNTIME_ERROR;
+    }
+}
+
+// Interns the name and resolves its global slot in the active context.
+static uint16_t globalSlotFor(const char* name)
+{
+    Value key = OBJ_VAL(copyString(name, (int)strlen(name)));
+    push(key);
+    uint16_t slot = globalSlot(key);
+    pop();
+    return slot;
+}
+
+bool pheltGetNumber(PheltContext* context, const char* name, double* value)
+{
+    makeCurrent(context);
+
+    Value found = vm.globalSlots.values[globalSlotFor(name)];
+    if (!IS_NUMBER(found))
+        return false;
+    *value = AS_NUMBER(found);
+    return true;
+}
+
+const char* pheltGetString(PheltContext* context, const char* name)
+{
+    makeCurrent(context);
+
+    Value found = vm.globalSlots.values[globalSlotFor(name)];
+    if (!IS_STRING(found))
+        return NULL;
+    return AS_CSTRING(found);
+}
+
+static void setGlobal(const char* name, Value value)
+{
+    push(value);
+    uint16_t slot                = globalSlotFor(name);
+    vm.globalSlots.values[slot]  = value;
+    tableSet(&vm.globals, vm.globalNames.values[slot], value);
+    pop();
+}
+
+void pheltSetNumber(PheltContext* context, const char* name, double value)
+{
+    makeCurrent(context);
+    setGlobal(name, NUMBER_VAL(value));
+}
+
+void pheltSetString(PheltContext* context, const char* name, const char* value)
+{
+    makeCurrent(context);
+    setGlobal(name, OBJ_VAL(copyString(value, (int)strlen(value))));
+}
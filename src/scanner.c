@@ -12,7 +12,7 @@ typedef struct
     int          line;
 } Scanner;
 
-Scanner scanner;
+__thread Scanner scanner;
 
 void initScanner(utf8_int8_t* source)
 {
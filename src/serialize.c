@@ -0,0 +1,393 @@
+#include "serialize.h"
+#include "chunk.h"
+#include "memory.h"
+#include "vm.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Compiled-chunk cache (.phc). writeChunkCache serializes the function tree a
+// compile produced next to its source file; readChunkCache maps that file back
+// into ObjFunctions so repeat invocations skip the scanner and compiler
+// entirely. A cache is only trusted if its header matches the current format,
+// opcode set and source mtime/size, otherwise the caller falls back to
+// compiling from source.
+#define PHC_MAGIC 0x30434850 // "PHC0"
+#define PHC_VERSION 1
+
+// Cheap fingerprint for the opcode set; caches written before an opcode was
+// added or removed must not be interpreted against the new dispatch table.
+enum {
+#define OPCODE(op) PHC_OPCODE_##op,
+#include "opcodes.h"
+#undef OPCODE
+    PHC_OPCODE_COUNT
+};
+
+typedef enum {
+    PHC_CONST_NIL,
+    PHC_CONST_FALSE,
+    PHC_CONST_TRUE,
+    PHC_CONST_NUMBER,
+    PHC_CONST_STRING,
+    PHC_CONST_FUNCTION,
+} ConstTag;
+
+typedef struct {
+    FILE* file;
+    bool  ok;
+} CacheWriter;
+
+static void putBytes(CacheWriter* writer, const void* bytes, size_t count)
+{
+    if (writer->ok && fwrite(bytes, 1, count, writer->file) != count)
+        writer->ok = false;
+}
+
+static void putU8(CacheWriter* writer, uint8_t value)
+{
+    putBytes(writer, &value, sizeof(value));
+}
+
+static void putU32(CacheWriter* writer, uint32_t value)
+{
+    putBytes(writer, &value, sizeof(value));
+}
+
+static void putI64(CacheWriter* writer, int64_t value)
+{
+    putBytes(writer, &value, sizeof(value));
+}
+
+static void putF64(CacheWriter* writer, double value)
+{
+    putBytes(writer, &value, sizeof(value));
+}
+
+static void putString(CacheWriter* writer, ObjString* string)
+{
+    putU32(writer, (uint32_t)string->length);
+    putBytes(writer, string->chars, string->length);
+}
+
+static void putFunction(CacheWriter* writer, ObjFunction* function)
+{
+    putU32(writer, (uint32_t)function->arity);
+    putU32(writer, (uint32_t)function->upvalueCount);
+    putU32(writer, (uint32_t)function->line);
+    putU8(writer, function->name != NULL);
+    if (function->name != NULL)
+        putString(writer, function->name);
+
+    Chunk* chunk = &function->chunk;
+    putU32(writer, (uint32_t)chunk->count);
+    putBytes(writer, chunk->code, chunk->count);
+    int run = 0;
+    for (int i = 0; i < chunk->count; i++) {
+        while (run + 1 < chunk->lineRunCount && chunk->lineRuns[run + 1].start <= i)
+            run++;
+        putU32(writer, (uint32_t)chunk->lineRuns[run].line);
+    }
+    putU32(writer, (uint32_t)chunk->cacheCount);
+
+    // Switch jump tables: the code offsets they hold are positions in the
+    // exact byte stream written above, so they serialize verbatim.
+    putU32(writer, (uint32_t)chunk->switchTableCount);
+    for (int i = 0; writer->ok && i < chunk->switchTableCount; i++) {
+        SwitchTable* table = &chunk->switchTables[i];
+        putU8(writer, table->enabled ? 1 : 0);
+        putU32(writer, (uint32_t)table->defaultOffset);
+        putU32(writer, table->offsets.count);
+        for (unsigned int j = 0; writer->ok && j < table->offsets.capacity; j++) {
+            Entry* entry = &table->offsets.entries[j];
+            if (IS_EMPTY(entry->key))
+                continue;
+            if (IS_NUMBER(entry->key)) {
+                putU8(writer, PHC_CONST_NUMBER);
+                putF64(writer, AS_NUMBER(entry->key));
+            } else if (IS_STRING(entry->key)) {
+                putU8(writer, PHC_CONST_STRING);
+                putString(writer, AS_STRING(entry->key));
+            } else {
+                // No serialized form for this key; give up on the cache.
+                writer->ok = false;
+                break;
+            }
+            putU32(writer, (uint32_t)AS_NUMBER(entry->value));
+        }
+    }
+
+    putU32(writer, chunk->constants.count);
+    for (unsigned int i = 0; writer->ok && i < chunk->constants.count; i++) {
+        Value constant = chunk->constants.values[i];
+        if (IS_NIL(constant)) {
+            putU8(writer, PHC_CONST_NIL);
+        } else if (IS_BOOL(constant)) {
+            putU8(writer, AS_BOOL(constant) ? PHC_CONST_TRUE : PHC_CONST_FALSE);
+        } else if (IS_NUMBER(constant)) {
+            putU8(writer, PHC_CONST_NUMBER);
+            putF64(writer, AS_NUMBER(constant));
+        } else if (IS_STRING(constant)) {
+            putU8(writer, PHC_CONST_STRING);
+            putString(writer, AS_STRING(constant));
+        } else if (IS_FUNCTION(constant)) {
+            putU8(writer, PHC_CONST_FUNCTION);
+            putFunction(writer, AS_FUNCTION(constant));
+        } else {
+            // A constant with no serialized form; give up on the cache.
+            writer->ok = false;
+        }
+    }
+}
+
+void writeChunkCache(const char* sourcePath, ObjFunction* function)
+{
+    struct stat source;
+    if (stat(sourcePath, &source) != 0)
+        return;
+
+    const char* cachePath = ensureExtension(sourcePath, ".phc");
+    FILE*       file      = fopen(cachePath, "wb");
+    if (file == NULL) {
+        free((void*)cachePath);
+        return;
+    }
+
+    CacheWriter writer = { file, true };
+    putU32(&writer, PHC_MAGIC);
+    putU32(&writer, PHC_VERSION);
+    putU32(&writer, PHC_OPCODE_COUNT);
+    putI64(&writer, (int64_t)source.st_mtime);
+    putI64(&writer, (int64_t)source.st_size);
+
+    // Global operands are slot indexes, so record every name in slot order;
+    // the loader replays the list to reproduce the same assignment.
+    putU32(&writer, vm.globalNames.count);
+    for (unsigned int i = 0; i < vm.globalNames.count; i++)
+        putString(&writer, AS_STRING(vm.globalNames.values[i]));
+
+    putFunction(&writer, function);
+
+    fclose(file);
+    if (!writer.ok)
+        remove(cachePath);
+    free((void*)cachePath);
+}
+
+typedef struct {
+    const uint8_t* at;
+    const uint8_t* end;
+    bool           ok;
+} CacheReader;
+
+static bool getBytes(CacheReader* reader, void* into, size_t count)
+{
+    if (!reader->ok || (size_t)(reader->end - reader->at) < count) {
+        reader->ok = false;
+        return false;
+    }
+    memcpy(into, reader->at, count);
+    reader->at += count;
+    return true;
+}
+
+static uint8_t getU8(CacheReader* reader)
+{
+    uint8_t value = 0;
+    getBytes(reader, &value, sizeof(value));
+    return value;
+}
+
+static uint32_t getU32(CacheReader* reader)
+{
+    uint32_t value = 0;
+    getBytes(reader, &value, sizeof(value));
+    return value;
+}
+
+static int64_t getI64(CacheReader* reader)
+{
+    int64_t value = 0;
+    getBytes(reader, &value, sizeof(value));
+    return value;
+}
+
+static double getF64(CacheReader* reader)
+{
+    double value = 0;
+    getBytes(reader, &value, sizeof(value));
+    return value;
+}
+
+static ObjString* getString(CacheReader* reader)
+{
+    uint32_t length = getU32(reader);
+    if (!reader->ok || (size_t)(reader->end - reader->at) < length) {
+        reader->ok = false;
+        return NULL;
+    }
+    ObjString* string = copyString((const char*)reader->at, (int)length);
+    reader->at += length;
+    return string;
+}
+
+static ObjFunction* getFunction(CacheReader* reader, const char* sourcePath)
+{
+    ObjFunction* function = newFunction();
+    push(OBJ_VAL(function));
+
+    function->arity        = (int)getU32(reader);
+    function->upvalueCount = (int)getU32(reader);
+    function->line         = (int)getU32(reader);
+    function->source       = sourcePath;
+    if (getU8(reader)) {
+        function->name = getString(reader);
+        writeBarrier((Obj*)function, OBJ_VAL(function->name));
+    }
+
+    uint32_t codeCount = getU32(reader);
+    if (!reader->ok || (size_t)(reader->end - reader->at) < codeCount) {
+        pop();
+        return NULL;
+    }
+    const uint8_t* code = reader->at;
+    reader->at += codeCount;
+    for (uint32_t i = 0; i < codeCount; i++) {
+        int line = (int)getU32(reader);
+        writeChunk(&function->chunk, code[i], line);
+    }
+
+    uint32_t cacheCount = getU32(reader);
+    for (uint32_t i = 0; reader->ok && i < cacheCount; i++)
+        addCache(&function->chunk);
+
+    uint32_t switchTableCount = getU32(reader);
+    for (uint32_t i = 0; reader->ok && i < switchTableCount; i++) {
+        int          tableIndex = addSwitchTable(&function->chunk);
+        SwitchTable* table      = &function->chunk.switchTables[tableIndex];
+        table->enabled          = getU8(reader) != 0;
+        table->defaultOffset    = (int)getU32(reader);
+
+        uint32_t entryCount = getU32(reader);
+        for (uint32_t j = 0; reader->ok && j < entryCount; j++) {
+            Value key;
+            switch (getU8(reader)) {
+            case PHC_CONST_NUMBER:
+                key = NUMBER_VAL(getF64(reader));
+                break;
+            case PHC_CONST_STRING: {
+                ObjString* string = getString(reader);
+                if (string == NULL) {
+                    reader->ok = false;
+                    continue;
+                }
+                key = OBJ_VAL(string);
+                break;
+            }
+            default:
+                reader->ok = false;
+                continue;
+            }
+            int offset = (int)getU32(reader);
+            push(key);
+            tableSet(&table->offsets, key, NUMBER_VAL(offset));
+            writeBarrier((Obj*)function, key);
+            pop();
+        }
+    }
+
+    uint32_t constCount = getU32(reader);
+    for (uint32_t i = 0; reader->ok && i < constCount; i++) {
+        switch (getU8(reader)) {
+        case PHC_CONST_NIL:
+            addConstant(&function->chunk, NIL_VAL);
+            break;
+        case PHC_CONST_FALSE:
+            addConstant(&function->chunk, BOOL_VAL(false));
+            break;
+        case PHC_CONST_TRUE:
+            addConstant(&function->chunk, BOOL_VAL(true));
+            break;
+        case PHC_CONST_NUMBER:
+            addConstant(&function->chunk, NUMBER_VAL(getF64(reader)));
+            break;
+        case PHC_CONST_STRING: {
+            ObjString* string = getString(reader);
+            if (string != NULL) {
+                addConstant(&function->chunk, OBJ_VAL(string));
+                writeBarrier((Obj*)function, OBJ_VAL(string));
+            }
+            break;
+        }
+        case PHC_CONST_FUNCTION: {
+            ObjFunction* constant = getFunction(reader, sourcePath);
+            if (constant != NULL) {
+                addConstant(&function->chunk, OBJ_VAL(constant));
+                writeBarrier((Obj*)function, OBJ_VAL(constant));
+            }
+            break;
+        }
+        default:
+            reader->ok = false;
+            break;
+        }
+    }
+
+    pop();
+    return reader->ok ? function : NULL;
+}
+
+ObjFunction* readChunkCache(const char* sourcePath)
+{
+    struct stat source;
+    if (stat(sourcePath, &source) != 0)
+        return NULL;
+
+    const char* cachePath = ensureExtension(sourcePath, ".phc");
+    int         fd        = open(cachePath, O_RDONLY);
+    free((void*)cachePath);
+    if (fd == -1)
+        return NULL;
+
+    struct stat cache;
+    if (fstat(fd, &cache) != 0 || cache.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* mapped = mmap(NULL, cache.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return NULL;
+
+    CacheReader reader = {
+        (const uint8_t*)mapped,
+        (const uint8_t*)mapped + cache.st_size,
+        true
+    };
+
+    ObjFunction* function = NULL;
+    if (getU32(&reader) == PHC_MAGIC
+        && getU32(&reader) == PHC_VERSION
+        && getU32(&reader) == PHC_OPCODE_COUNT
+        && getI64(&reader) == (int64_t)source.st_mtime
+        && getI64(&reader) == (int64_t)source.st_size
+        && reader.ok) {
+        // Replay the recorded global names; the cached slot operands are only
+        // valid if this VM hands out the same indexes the compiler saw.
+        uint32_t globalCount = getU32(&reader);
+        bool     slotsMatch  = reader.ok;
+        for (uint32_t i = 0; slotsMatch && i < globalCount; i++) {
+            ObjString* name = getString(&reader);
+            if (name == NULL || globalSlot(OBJ_VAL(name)) != i)
+                slotsMatch = false;
+        }
+        if (slotsMatch)
+            function = getFunction(&reader, sourcePath);
+    }
+
+    munmap(mapped, cache.st_size);
+    return function;
+}
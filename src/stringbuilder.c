@@ -0,0 +1,146 @@
+#include "stringbuilder.h"
+#include "memory.h"
+#include "vm.h"
+
+void sbInit(StringBuilder* sb)
+{
+    sb->chars    = sb->seed;
+    sb->length   = 0;
+    sb->capacity = SB_SEED_SIZE;
+}
+
+static bool sbOnHeap(StringBuilder* sb)
+{
+    return sb->chars != sb->seed;
+}
+
+static void sbEnsure(StringBuilder* sb, size_t extra)
+{
+    if (sb->length + extra <= sb->capacity)
+        return;
+
+    size_t capacity = sb->capacity;
+    while (sb->length + extra > capacity)
+        capacity *= 2;
+
+    if (sbOnHeap(sb)) {
+        sb->chars = GROW_ARRAY(char, sb->chars, sb->capacity, capacity);
+    } else {
+        char* heap = ALLOCATE(char, capacity);
+        memcpy(heap, sb->seed, sb->length);
+        sb->chars = heap;
+    }
+    sb->capacity = capacity;
+}
+
+void sbAppend(StringBuilder* sb, const char* bytes, size_t count)
+{
+    sbEnsure(sb, count);
+    memcpy(sb->chars + sb->length, bytes, count);
+    sb->length += count;
+}
+
+void sbAppendChar(StringBuilder* sb, char c)
+{
+    sbEnsure(sb, 1);
+    sb->chars[sb->length++] = c;
+}
+
+void sbAppendCString(StringBuilder* sb, const char* chars)
+{
+    sbAppend(sb, chars, strlen(chars));
+}
+
+void sbAppendNumber(StringBuilder* sb, double number)
+{
+    sbEnsure(sb, 32);
+
+    // Integral values print as plain digits under %.14g up to fourteen
+    // significant digits, so this loop and the fallback agree everywhere
+    // the window overlaps.
+    if (number == (double)(long long)number && number > -1e14 && number < 1e14) {
+        long long value = (long long)number;
+        if (value < 0) {
+            sb->chars[sb->length++] = '-';
+            value = -value;
+        }
+        char digits[16];
+        int  count = 0;
+        do {
+            digits[count++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (count > 0)
+            sb->chars[sb->length++] = digits[--count];
+        return;
+    }
+
+    sb->length += snprintf(sb->chars + sb->length, 32, "%.14g", number);
+}
+
+void sbAppendValue(StringBuilder* sb, Value value)
+{
+    if (IS_BOOL(value)) {
+        sbAppendCString(sb, AS_BOOL(value) ? "true" : "false");
+    } else if (IS_NIL(value)) {
+        sbAppendCString(sb, "nil");
+    } else if (IS_NUMBER(value)) {
+        sbAppendNumber(sb, AS_NUMBER(value));
+    } else if (IS_STRING(value)) {
+        ObjString* string = AS_STRING(value);
+        sbAppend(sb, stringChars(string), string->length);
+    } else if (IS_OBJ(value)) {
+        // objectString can re-enter the VM for instances with a str
+        // method, exactly as stringValue always has.
+        sbAppendCString(sb, objectString(value));
+    } else if (IS_EMPTY(value)) {
+        sbAppendCString(sb, "empty");
+    } else if (IS_POINTER(value)) {
+        char pointer[32];
+        snprintf(pointer, sizeof(pointer), "*%p", AS_POINTER(value));
+        sbAppendCString(sb, pointer);
+    }
+}
+
+void sbAppendVFormat(StringBuilder* sb, const char* format, va_list args)
+{
+    va_list measure;
+    va_copy(measure, args);
+    int count = vsnprintf(NULL, 0, format, measure);
+    va_end(measure);
+    if (count < 0)
+        return;
+
+    sbEnsure(sb, (size_t)count + 1);
+    vsnprintf(sb->chars + sb->length, count + 1, format, args);
+    sb->length += count;
+}
+
+ObjString* sbFinish(StringBuilder* sb)
+{
+    if (!sbOnHeap(sb))
+        return copyString(sb->chars, (int)sb->length);
+
+    // Shrink to the accounting takeString expects and adopt the buffer.
+    sb->chars             = GROW_ARRAY(char, sb->chars, sb->capacity, sb->length + 1);
+    sb->chars[sb->length] = '\0';
+    return takeString(sb->chars, (int)sb->length);
+}
+
+char* sbToCString(StringBuilder* sb)
+{
+    char* copy = malloc(sb->length + 1);
+    if (copy != NULL) {
+        memcpy(copy, sb->chars, sb->length);
+        copy[sb->length] = '\0';
+    }
+    sbDiscard(sb);
+    return copy;
+}
+
+void sbDiscard(StringBuilder* sb)
+{
+    if (sbOnHeap(sb))
+        FREE_ARRAY(char, sb->chars, sb->capacity);
+    sb->chars = sb->seed;
+}
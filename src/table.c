@@ -3,44 +3,95 @@
 #include "memory.h"
 #include "object.h"
 #include "value.h"
+#include "vm.h"
 
 #define TABLE_MAX_LOAD 0.85
 
+// Control bytes carry a seven-bit fragment of each key's hash, so a probe
+// scans a whole group of slots with one comparison and only dereferences an
+// Entry whose fragment already agrees. The sentinels keep the high bit set,
+// which no fragment ever does.
+#define GROUP_WIDTH 16
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+
+static inline uint8_t hashFragment(uint32_t hash)
+{
+    return (uint8_t)(hash >> 25);
+}
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+// Bitmask of the slots in a 16-byte group whose control byte equals byte.
+static inline uint32_t groupMatch(const uint8_t* group, uint8_t byte)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+}
+#else
+static inline uint32_t groupMatch(const uint8_t* group, uint8_t byte)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++) {
+        if (group[i] == byte)
+            mask |= 1u << i;
+    }
+    return mask;
+}
+#endif
+
 void initTable(Table* table)
 {
-    table->count    = 0;
-    table->capacity = 0;
-    table->entries  = NULL;
+    table->count      = 0;
+    table->capacity   = 0;
+    table->tombstones = 0;
+    table->ctrl       = NULL;
+    table->entries    = NULL;
 }
 
 void freeTable(Table* table)
 {
+    FREE_ARRAY(uint8_t, table->ctrl, table->capacity);
     FREE_ARRAY(Entry, table->entries, table->capacity);
     initTable(table);
 }
 
-static Entry* findEntry(Entry* entries, int capacity, Value key)
+static Entry* findEntry(uint8_t* ctrl, Entry* entries, unsigned int capacity, Value key, uint32_t hash)
 {
-    Entry* tombstone = NULL;
+    uint8_t      frag      = hashFragment(hash);
+    unsigned int groups    = capacity / GROUP_WIDTH;
+    unsigned int group     = (hash & (capacity - 1)) / GROUP_WIDTH;
+    Entry*       tombstone = NULL;
 
-    uint32_t index = hashValue(key) & (capacity - 1);
     for (;;) {
-        Entry* entry = &entries[index];
-        if (IS_EMPTY(entry->key)) {
-            if (IS_NIL(entry->value)) {
-                // Empty entry.
-                return tombstone != NULL ? tombstone : entry;
-            } else {
-                // We found a tombstone.
-                if (tombstone == NULL)
-                    tombstone = entry;
+        const uint8_t* base = &ctrl[group * GROUP_WIDTH];
+
+        uint32_t matches = groupMatch(base, frag);
+        while (matches != 0) {
+            Entry* entry = &entries[group * GROUP_WIDTH + __builtin_ctz(matches)];
+            if (valuesEqual(key, entry->key)) {
+                // We found the key.
+                return entry;
             }
-        } else if (valuesEqual(key, entry->key)) {
-            // We found the key.
-            return entry;
+            matches &= matches - 1;
+        }
+
+        uint32_t empty = groupMatch(base, CTRL_EMPTY);
+        if (empty != 0) {
+            // The key is absent; hand back the first reusable slot.
+            if (tombstone != NULL)
+                return tombstone;
+            return &entries[group * GROUP_WIDTH + __builtin_ctz(empty)];
+        }
+
+        if (tombstone == NULL) {
+            uint32_t deleted = groupMatch(base, CTRL_DELETED);
+            if (deleted != 0)
+                tombstone = &entries[group * GROUP_WIDTH + __builtin_ctz(deleted)];
         }
 
-        index = (index + 1) & (capacity - 1);
+        group = (group + 1) & (groups - 1);
     }
 }
 
@@ -49,7 +100,7 @@ bool tableGet(Table* table, Value key, Value* value)
     if (table->count == 0)
         return false;
 
-    Entry* entry = findEntry(table->entries, table->capacity, key);
+    Entry* entry = findEntry(table->ctrl, table->entries, table->capacity, key, hashValue(key));
     if (IS_EMPTY(entry->key))
         return false;
 
@@ -60,40 +111,67 @@ bool tableGet(Table* table, Value key, Value* value)
 
 static void adjustCapacity(Table* table, unsigned int capacity)
 {
+    uint8_t* ctrl = ALLOCATE(uint8_t, capacity);
+    memset(ctrl, CTRL_EMPTY, capacity);
+
     Entry* entries = ALLOCATE(Entry, capacity);
     for (unsigned int i = 0; i < capacity; i++) {
         entries[i].key   = EMPTY_VAL;
         entries[i].value = NIL_VAL;
     }
 
-    table->count = 0;
+    table->count      = 0;
+    table->tombstones = 0;
     for (unsigned int i = 0; i < table->capacity; i++) {
         Entry* entry = &table->entries[i];
         if (IS_EMPTY(entry->key))
             continue;
 
-        Entry* dest = findEntry(entries, capacity, entry->key);
-        dest->key   = entry->key;
-        dest->value = entry->value;
+        uint32_t hash        = hashValue(entry->key);
+        Entry*   dest        = findEntry(ctrl, entries, capacity, entry->key, hash);
+        ctrl[dest - entries] = hashFragment(hash);
+        dest->key            = entry->key;
+        dest->value          = entry->value;
         table->count++;
     }
 
+    FREE_ARRAY(uint8_t, table->ctrl, table->capacity);
     FREE_ARRAY(Entry, table->entries, table->capacity);
+    table->ctrl     = ctrl;
     table->entries  = entries;
     table->capacity = capacity;
 }
 
 bool tableSet(Table* table, Value key, Value value)
 {
-    if (table->count + 1 > table->capacity * TABLE_MAX_LOAD) {
-        int capacity = GROW_CAPACITY(table->capacity);
+    // Tombstones occupy probeable slots until a rebuild sweeps them out, so
+    // they weigh on the load factor too; otherwise steady churn could eat
+    // every empty slot and leave the probe loops with no terminator.
+    if (table->count + table->tombstones + 1 > table->capacity * TABLE_MAX_LOAD) {
+        unsigned int capacity = table->capacity;
+        // Grow only when live entries need the room; a tombstone-heavy
+        // table is rebuilt at its current size, which clears them.
+        if (table->count + 1 > table->capacity * (TABLE_MAX_LOAD / 2))
+            capacity = GROW_CAPACITY(table->capacity);
+        // Group probing needs at least one full group of slots.
+        if (capacity < GROUP_WIDTH)
+            capacity = GROUP_WIDTH;
         adjustCapacity(table, capacity);
     }
 
-    Entry* entry    = findEntry(table->entries, table->capacity, key);
-    bool   isNewKey = IS_EMPTY(entry->key);
-    if (isNewKey && IS_NIL(entry->value))
+    uint32_t hash     = hashValue(key);
+    Entry*   entry    = findEntry(table->ctrl, table->entries, table->capacity, key, hash);
+    bool     isNewKey = IS_EMPTY(entry->key);
+    if (isNewKey) {
+        if (table->ctrl[entry - table->entries] == CTRL_DELETED)
+            table->tombstones--;
         table->count++;
+    }
+
+    markWrite(key);
+    markWrite(value);
+
+    table->ctrl[entry - table->entries] = hashFragment(hash);
 
     entry->key   = key;
     entry->value = value;
@@ -106,14 +184,17 @@ bool tableDelete(Table* table, Value key)
         return false;
 
     // Find the entry.
-    Entry* entry = findEntry(table->entries, table->capacity, key);
+    Entry* entry = findEntry(table->ctrl, table->entries, table->capacity, key, hashValue(key));
     if (IS_EMPTY(entry->key))
         return false;
 
     // Place a tombstone in the entry.
+    table->ctrl[entry - table->entries] = CTRL_DELETED;
+
     entry->key   = EMPTY_VAL;
     entry->value = BOOL_VAL(true);
     table->count--;
+    table->tombstones++;
     return true;
 }
 
@@ -132,23 +213,30 @@ ObjString* tableFindString(Table* table, const char* chars, int length, uint32_t
     if (table->count == 0)
         return NULL;
 
-    uint32_t index = hash & (table->capacity - 1);
+    uint8_t      frag   = hashFragment(hash);
+    unsigned int groups = table->capacity / GROUP_WIDTH;
+    unsigned int group  = (hash & (table->capacity - 1)) / GROUP_WIDTH;
+
     for (;;) {
-        Entry* entry = &table->entries[index];
+        const uint8_t* base = &table->ctrl[group * GROUP_WIDTH];
 
-        if (IS_EMPTY(entry->key)) {
-            // Stop if we find an empty non-tombstone entry.
-            if (IS_NIL(entry->value))
-                return NULL;
+        uint32_t matches = groupMatch(base, frag);
+        while (matches != 0) {
+            Entry*     entry  = &table->entries[group * GROUP_WIDTH + __builtin_ctz(matches)];
+            ObjString* string = AS_STRING(entry->key);
+            if (string->hash == hash && string->length == length
+                && memcmp(string->chars, chars, length) == 0) {
+                // We found it.
+                return string;
+            }
+            matches &= matches - 1;
         }
 
-        ObjString* string = AS_STRING(entry->key);
-        if (string->length == length && memcmp(string->chars, chars, length) == 0) {
-            // We found it.
-            return string;
-        }
+        // Stop at the first group holding an empty non-tombstone slot.
+        if (groupMatch(base, CTRL_EMPTY) != 0)
+            return NULL;
 
-        index = (index + 1) & (table->capacity - 1);
+        group = (group + 1) & (groups - 1);
     }
 }
 
@@ -177,13 +265,23 @@ void printTable(Table* table)
     printf(" }");
 }
 
+// Drop weak entries whose keys did not survive marking, so the intern table
+// never holds dangling pointers into swept memory. During a minor collection
+// the old generation is never marked, so old keys are left alone.
 void tableRemoveWhite(Table* table)
 {
     for (unsigned int i = 0; i < table->capacity; i++) {
         Entry* entry = &table->entries[i];
-        if (IS_EMPTY(entry->key)) {
-            tableDelete(table, entry->key);
-        }
+        if (IS_EMPTY(entry->key) || !IS_OBJ(entry->key))
+            continue;
+
+        Obj* key = AS_OBJ(entry->key);
+        if (key->isMarked)
+            continue;
+        if (vm.gcMinor && key->isOld)
+            continue;
+
+        tableDelete(table, entry->key);
     }
 }
 
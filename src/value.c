@@ -1,12 +1,14 @@
 #include "value.h"
 #include "memory.h"
 #include "object.h"
+#include "stringbuilder.h"
 
 void initValueArray(ValueArray* array)
 {
-    array->values   = NULL;
-    array->capacity = 0;
-    array->count    = 0;
+    array->values     = NULL;
+    array->capacity   = 0;
+    array->count      = 0;
+    array->allNumbers = true;
 }
 
 void writeValueArray(ValueArray* array, Value value)
@@ -17,6 +19,10 @@ void writeValueArray(ValueArray* array, Value value)
         array->values            = GROW_ARRAY(Value, array->values, oldCapacity, array->capacity);
     }
 
+    if (!IS_NUMBER(value))
+        array->allNumbers = false;
+
+    markWrite(value);
     array->values[array->count] = value;
     array->count++;
 }
@@ -33,6 +39,10 @@ void writeValueArrayAt(ValueArray* array, Value value, unsigned int index)
         array->values[i] = array->values[i - 1];
     }
 
+    if (!IS_NUMBER(value))
+        array->allNumbers = false;
+
+    markWrite(value);
     array->values[index] = value;
     array->count++;
 }
@@ -74,6 +84,14 @@ bool arraysEqual(ValueArray* a, ValueArray* b)
         return false;
     }
 
+#ifdef NAN_BOXING
+    // Canonical NaN boxing gives equal numbers equal bit patterns, so two
+    // all-number arrays compare with a single memcmp.
+    if (a->allNumbers && b->allNumbers) {
+        return memcmp(a->values, b->values, a->count * sizeof(Value)) == 0;
+    }
+#endif
+
     for (unsigned int i = 0; i < a->count; i++) {
         if (IS_ARRAY(a->values[i]) && IS_ARRAY(b->values[i])) {
             if (!arraysEqual(&AS_ARRAY(a->values[i])->array, &AS_ARRAY(b->values[i])->array)) {
@@ -109,9 +127,13 @@ uint32_t hashValue(Value value)
     } else if (IS_NUMBER(value)) {
         return hashDouble(AS_NUMBER(value));
     } else if (IS_OBJ(value)) {
+        if (IS_STRING(value))
+            return stringHash(AS_STRING(value));
         return AS_STRING(value)->hash;
     } else if (IS_EMPTY(value)) {
         return 0;
+    } else if (IS_POINTER(value)) {
+        return (uint32_t)(uintptr_t)AS_POINTER(value);
     }
 #else
     switch (value.type) {
@@ -264,17 +286,6 @@ void dumpValue(Value value)
 #endif
 }
 
-char* format_double(double val)
-{
-    char* str = (char*)malloc(50 * sizeof(char));
-    if (str == NULL) {
-        fprintf(stderr, "Malloc failed!\n");
-        return NULL;
-    }
-    sprintf(str, "%.14g", val);
-    return str;
-}
-
 char* stringValue(Value value)
 {
 #ifdef NAN_BOXING
@@ -283,7 +294,10 @@ char* stringValue(Value value)
     } else if (IS_NIL(value)) {
         return "nil";
     } else if (IS_NUMBER(value)) {
-        return format_double(AS_NUMBER(value));
+        StringBuilder sb;
+        sbInit(&sb);
+        sbAppendNumber(&sb, AS_NUMBER(value));
+        return sbToCString(&sb);
     } else if (IS_OBJ(value)) {
         return objectString(value);
     } else if (IS_EMPTY(value)) {
@@ -300,9 +314,10 @@ char* stringValue(Value value)
     case VAL_NIL:
         return "nil";
     case VAL_NUMBER: {
-        char* str = malloc(sizeof(char) * 50);
-        sprintf(str, "%g", AS_NUMBER(value));
-        return str;
+        StringBuilder sb;
+        sbInit(&sb);
+        sbAppendNumber(&sb, AS_NUMBER(value));
+        return sbToCString(&sb);
     }
     case VAL_OBJ:
         return objectString(value);
@@ -321,7 +336,22 @@ char* stringValue(Value value)
 bool valuesEqual(Value a, Value b)
 {
 #ifdef NAN_BOXING
-    return a == b;
+    if (a == b)
+        return true;
+
+    // Interned strings are canonical, but concatenation results defer
+    // interning, so content-equal strings can differ by pointer.
+    if (IS_STRING(a) && IS_STRING(b)) {
+        ObjString* first  = AS_STRING(a);
+        ObjString* second = AS_STRING(b);
+        if (first->interned && second->interned)
+            return false;
+        return first->length == second->length
+            && stringHash(first) == stringHash(second)
+            && memcmp(first->chars, second->chars, first->length) == 0;
+    }
+
+    return false;
 #else
     if (a.type != b.type)
         return false;
@@ -332,8 +362,20 @@ bool valuesEqual(Value a, Value b)
         return true;
     case VAL_NUMBER:
         return AS_NUMBER(a) == AS_NUMBER(b);
-    case VAL_OBJ:
-        return AS_OBJ(a) == AS_OBJ(b);
+    case VAL_OBJ: {
+        if (AS_OBJ(a) == AS_OBJ(b))
+            return true;
+        if (IS_STRING(a) && IS_STRING(b)) {
+            ObjString* first  = AS_STRING(a);
+            ObjString* second = AS_STRING(b);
+            if (first->interned && second->interned)
+                return false;
+            return first->length == second->length
+                && stringHash(first) == stringHash(second)
+                && memcmp(first->chars, second->chars, first->length) == 0;
+        }
+        return false;
+    }
     case VAL_EMPTY:
         return true;
     default:
@@ -1,14 +1,23 @@
 #include <libgen.h>
 #include <math.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "compiler.h"
 #include "debug.h"
+#include "jit.h"
+#include "memory.h"
 #include "ph_string.h"
+#include "serialize.h"
+#include "stringbuilder.h"
 #include "vm.h"
 
-VM vm;
+// One VM per OS thread: worker isolates each run a private interpreter
+// (heap, GC, interned strings) with no locking on the hot paths.
+__thread VM vm;
 
 static void resetStack(void)
 {
@@ -31,7 +40,7 @@ void runtimeError(const char* format, ...)
         ObjFunction* function    = frame->closure->function;
         size_t       instruction = frame->ip - function->chunk.code - 1;
         fprintf(stderr, "[line %d] in ",
-            (int)AS_NUMBER(function->chunk.lines.values[instruction]));
+            getLine(&function->chunk, (int)instruction));
         if (function->name == NULL) {
             fprintf(stderr, "%s\n", basename((char*)function->source));
         } else {
@@ -59,8 +68,49 @@ static void initNative(void)
     }
 }
 
-void initVM(void)
+// Resolves a global name to its index in vm.globalSlots, allocating a new
+// slot on first sight. Slots start out empty and are seeded from the
+// vm.globals name table, so natives and definitions from earlier scripts
+// stay visible without per-access hashing.
+uint16_t globalSlot(Value name)
 {
+    Value index;
+    if (tableGet(&vm.globalIndexes, name, &index)) {
+        return (uint16_t)AS_NUMBER(index);
+    }
+
+    uint16_t slot = (uint16_t)vm.globalSlots.count;
+    push(name);
+    tableSet(&vm.globalIndexes, name, NUMBER_VAL(slot));
+    writeValueArray(&vm.globalNames, name);
+
+    Value value;
+    if (!tableGet(&vm.globals, name, &value)) {
+        value = EMPTY_VAL;
+    }
+    writeValueArray(&vm.globalSlots, value);
+    pop();
+
+    return slot;
+}
+
+void initVM(int frameLimit, size_t stackSlots)
+{
+    vm.frameLimit = frameLimit > 0 ? frameLimit : FRAMES_MAX;
+    vm.stackSlots = stackSlots > 0 ? stackSlots : STACK_MAX;
+
+    vm.frameCapacity = FRAMES_INITIAL < vm.frameLimit ? FRAMES_INITIAL : vm.frameLimit;
+    vm.frames        = malloc(sizeof(CallFrame) * vm.frameCapacity);
+
+    // One reservation for the whole stack; pages are only faulted in as
+    // the script actually uses them, and the block never moves.
+    vm.stack = mmap(NULL, vm.stackSlots * sizeof(Value), PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (vm.frames == NULL || vm.stack == MAP_FAILED) {
+        fprintf(stderr, "Could not allocate the VM stack.\n");
+        exit(1);
+    }
+
     resetStack();
     vm.objects = NULL;
 
@@ -71,9 +121,30 @@ void initVM(void)
     vm.grayStack      = NULL;
     vm.errorState     = false;
 
+    vm.objectCount        = 0;
+    vm.objectCapacity     = 0;
+    vm.oldCount           = 0;
+    vm.oldBytes           = 0;
+    vm.gcMinor            = false;
+    vm.gcMarking          = false;
+    vm.rememberedCount    = 0;
+    vm.rememberedCapacity = 0;
+    vm.rememberedSet      = NULL;
+
     initTable(&vm.globals);
+    initTable(&vm.globalIndexes);
+    initValueArray(&vm.globalSlots);
+    initValueArray(&vm.globalNames);
+    initTable(&vm.modules);
     initTable(&vm.strings);
 
+    vm.indexCacheString = NULL;
+    vm.indexCacheCp     = 0;
+    vm.indexCacheByte   = 0;
+
+    vm.rootShape = NULL;
+    vm.rootShape = newShape(NULL, NIL_VAL);
+
     vm.initString   = NULL;
     vm.initString   = copyString("init", 4);
     vm.strString    = NULL;
@@ -118,8 +189,20 @@ void initVM(void)
 
 void freeVM(void)
 {
+#ifdef DEBUG_DISPATCH_STATS
+    // Dump once per process: the reset keeps worker VMs tearing down later
+    // from repeating the table.
+    dispatchStatsDump(stderr);
+    dispatchStatsReset();
+#endif
+
     freeTable(&vm.globals);
+    freeTable(&vm.globalIndexes);
+    freeValueArray(&vm.globalSlots);
+    freeValueArray(&vm.globalNames);
+    freeTable(&vm.modules);
     freeTable(&vm.strings);
+    vm.rootShape    = NULL;
     vm.initString   = NULL;
     vm.strString    = NULL;
     vm.addString    = NULL;
@@ -140,6 +223,12 @@ void freeVM(void)
     vm.rshiftString = NULL;
     vm.lshiftString = NULL;
     freeObjects();
+
+    free(vm.frames);
+    vm.frames = NULL;
+    munmap(vm.stack, vm.stackSlots * sizeof(Value));
+    vm.stack    = NULL;
+    vm.stackTop = NULL;
 }
 
 __attribute__((always_inline)) inline void push(Value value)
@@ -166,19 +255,36 @@ bool call(ObjClosure* closure, int argCount)
         return false;
     }
 
-    if (vm.frameCount == FRAMES_MAX) {
-        runtimeError("Stack overflow.");
-        return false;
+    if (vm.frameCount == vm.frameCapacity) {
+        if (vm.frameCapacity == vm.frameLimit) {
+            runtimeError("Stack overflow.");
+            return false;
+        }
+        int newCapacity = vm.frameCapacity * 2;
+        if (newCapacity > vm.frameLimit) {
+            newCapacity = vm.frameLimit;
+        }
+        vm.frames        = realloc(vm.frames, sizeof(CallFrame) * newCapacity);
+        vm.frameCapacity = newCapacity;
+        if (vm.frames == NULL) {
+            fprintf(stderr, "Could not grow the call-frame array.\n");
+            exit(1);
+        }
     }
 
     if (vm.errorState) {
         return false;
     }
 
-    CallFrame* frame = &vm.frames[vm.frameCount++];
+    // Fill the frame before publishing frameCount so the sampling profiler's
+    // signal handler never observes a half-initialized top frame.
+    CallFrame* frame = &vm.frames[vm.frameCount];
     frame->closure   = closure;
     frame->ip        = closure->function->chunk.code;
     frame->slots     = vm.stackTop - argCount - 1;
+    __asm__ volatile("" ::: "memory");
+    vm.frameCount++;
+    jitCountHot(closure->function);
     return true;
 }
 
@@ -196,7 +302,7 @@ static bool callValue(Value callee, int argCount)
             vm.stackTop[-argCount - 1] = OBJ_VAL(newInstance(klass));
 
             Value initializer;
-            if (tableGet(&klass->methods, OBJ_VAL(vm.initString), &initializer)) {
+            if (classMethod(klass, OBJ_VAL(vm.initString), &initializer)) {
                 return call(AS_CLOSURE(initializer), argCount);
             } else if (argCount != 0) {
                 runtimeError("Expected 0 arguments but got %d.", argCount);
@@ -213,7 +319,10 @@ static bool callValue(Value callee, int argCount)
                 vm.stackTop -= argCount;
                 return true;
             } else {
-                runtimeError(AS_STRING(vm.stackTop[-argCount - 1])->chars);
+                // A callback run inside the native may already have raised
+                // (and reset the stack); the message slot is gone then.
+                if (!vm.errorState)
+                    runtimeError(AS_CSTRING(vm.stackTop[-argCount - 1]));
                 return false;
             }
         }
@@ -225,17 +334,50 @@ static bool callValue(Value callee, int argCount)
     return false;
 }
 
+__attribute__((always_inline)) inline static bool cacheGet(InlineCache* cache, Obj* klass, Value* value)
+{
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        if (cache->entries[i].klass == klass) {
+            *value = cache->entries[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void cacheStore(InlineCache* cache, Obj* klass, Value value)
+{
+    // Caches always belong to the function executing in the top frame; keep
+    // the remembered set aware of young keys landing in old functions.
+    Obj* owner = (Obj*)vm.frames[vm.frameCount - 1].closure->function;
+    writeBarrier(owner, OBJ_VAL(klass));
+    writeBarrier(owner, value);
+
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        if (cache->entries[i].klass == NULL) {
+            cache->entries[i].klass = klass;
+            cache->entries[i].value = value;
+            return;
+        }
+    }
+
+    // Polymorphic site with all entries taken: evict the older entry.
+    cache->entries[1]       = cache->entries[0];
+    cache->entries[0].klass = klass;
+    cache->entries[0].value = value;
+}
+
 static bool invokeFromClass(ObjClass* klass, Value name, int argCount)
 {
     Value method;
-    if (!tableGet(&klass->methods, name, &method)) {
+    if (!classMethod(klass, name, &method)) {
         runtimeError("1Undefined property '%s'.", stringValue(name));
         return false;
     }
     return call(AS_CLOSURE(method), argCount);
 }
 
-static bool invoke(Value name, int argCount)
+static bool invoke(Value name, int argCount, InlineCache* cache)
 {
     Value receiver = peek(argCount);
 
@@ -244,12 +386,24 @@ static bool invoke(Value name, int argCount)
         ObjInstance* instance = AS_INSTANCE(receiver);
 
         Value value;
-        if (tableGet(&instance->fields, name, &value)) {
+        if (instanceGetField(instance, name, &value)) {
             vm.stackTop[-argCount - 1] = value;
             return callValue(value, argCount);
         }
 
-        return invokeFromClass(instance->klass, name, argCount);
+        Value method;
+        if (cache != NULL && cacheGet(cache, (Obj*)instance->klass, &method)) {
+            return call(AS_CLOSURE(method), argCount);
+        }
+
+        if (!classMethod(instance->klass, name, &method)) {
+            runtimeError("1Undefined property '%s'.", stringValue(name));
+            return false;
+        }
+
+        if (cache != NULL)
+            cacheStore(cache, (Obj*)instance->klass, method);
+        return call(AS_CLOSURE(method), argCount);
     }
     case OBJ_TABLE: {
         ObjTable* table = AS_TABLE(receiver);
@@ -272,7 +426,7 @@ static bool invoke(Value name, int argCount)
 static bool bindMethod(ObjClass* klass, Value name)
 {
     Value method;
-    if (!tableGet(&klass->methods, name, &method)) {
+    if (!classMethod(klass, name, &method)) {
         runtimeError("Undefined property '%s'.", stringValue(name));
         return false;
     }
@@ -294,7 +448,8 @@ bool valueSlice(Value start, Value end)
             int j = (int)AS_NUMBER(end);
 
             ObjString* string     = AS_STRING(value);
-            int        str_length = utf8len(string->chars);
+            char*      chars      = stringChars(string);
+            int        str_length = string->ascii ? string->length : (int)utf8len(chars);
 
             if (j < 0)
                 j = (str_length) + j;
@@ -307,7 +462,13 @@ bool valueSlice(Value start, Value end)
                 return false;
             }
 
-            char* substring = substring_utf8(string->chars, i, j);
+            // ASCII slices copy bytes directly; codepoints and bytes agree.
+            if (string->ascii) {
+                push(OBJ_VAL(copyString(chars + i, j > i ? j - i : 0)));
+                return true;
+            }
+
+            char* substring = substring_utf8(chars, i, j);
             push(OBJ_VAL(takeString(substring, strlen(substring))));
             return true;
             break;
@@ -373,15 +534,63 @@ static void closeUpvalues(Value* last)
         ObjUpvalue* upvalue = vm.openUpvalues;
         upvalue->closed     = *upvalue->location;
         upvalue->location   = &upvalue->closed;
+        writeBarrier((Obj*)upvalue, upvalue->closed);
         vm.openUpvalues     = upvalue->next;
     }
 }
 
+// Maps a dunder method name to its slot in the class operator vtable, or
+// -1 for ordinary methods. Names are interned, so pointer compares suffice.
+static int operatorId(ObjString* name)
+{
+    if (name == vm.addString)
+        return OPERATOR_ADD;
+    if (name == vm.subString)
+        return OPERATOR_SUB;
+    if (name == vm.mulString)
+        return OPERATOR_MUL;
+    if (name == vm.divString)
+        return OPERATOR_DIV;
+    if (name == vm.gtString)
+        return OPERATOR_GT;
+    if (name == vm.gteString)
+        return OPERATOR_GTE;
+    if (name == vm.ltString)
+        return OPERATOR_LT;
+    if (name == vm.lteString)
+        return OPERATOR_LTE;
+    if (name == vm.eqString)
+        return OPERATOR_EQ;
+    if (name == vm.neqString)
+        return OPERATOR_NEQ;
+    if (name == vm.andString)
+        return OPERATOR_AND;
+    if (name == vm.orString)
+        return OPERATOR_OR;
+    if (name == vm.xorString)
+        return OPERATOR_XOR;
+    if (name == vm.modString)
+        return OPERATOR_MOD;
+    if (name == vm.notString)
+        return OPERATOR_NOT;
+    if (name == vm.rshiftString)
+        return OPERATOR_RSHIFT;
+    if (name == vm.lshiftString)
+        return OPERATOR_LSHIFT;
+    return -1;
+}
+
 static void defineMethod(ObjString* name)
 {
     Value     method = peek(0);
     ObjClass* klass  = AS_CLASS(peek(1));
     tableSet(&klass->methods, OBJ_VAL(name), method);
+    writeBarrier((Obj*)klass, method);
+
+    int id = operatorId(name);
+    if (id != -1 && IS_CLOSURE(method)) {
+        klass->operators[id] = AS_CLOSURE(method);
+    }
     pop();
 }
 
@@ -395,18 +604,150 @@ static void concatenate(void)
     ObjString* b = AS_STRING(peek(0));
     ObjString* a = AS_STRING(peek(1));
 
-    int   length = a->length + b->length;
-    char* chars  = ALLOCATE(char, length + 1);
-    memcpy(chars, a->chars, a->length);
-    memcpy(chars + a->length, b->chars, b->length);
-    chars[length] = '\0';
-
-    ObjString* result = takeString(chars, length);
+    ObjString* result = concatStrings(a, b);
     pop();
     pop();
     push(OBJ_VAL(result));
 }
 
+#ifdef DEBUG_DISPATCH_STATS
+// Dispatch statistics: every dispatch bumps a per-opcode counter and the
+// counter for the (previous, current) opcode pair; conditional jumps also
+// record how often they were taken. Counters are process-wide and updated
+// without synchronization, so under workers they are approximate — fine for
+// distribution data. The tables are dumped at exit and on demand through
+// debug.dispatchStats().
+
+static const char* opcodeNames[] = {
+#define OPCODE(op) #op,
+#include "opcodes.h"
+#undef OPCODE
+};
+
+#define OPCODE_COUNT ((int)(sizeof(opcodeNames) / sizeof(opcodeNames[0])))
+
+static uint64_t opcodeCounts[OPCODE_COUNT];
+static uint64_t opcodePairs[OPCODE_COUNT][OPCODE_COUNT];
+static uint64_t branchTotals[OPCODE_COUNT];
+static uint64_t branchTakens[OPCODE_COUNT];
+
+static __thread int dispatchPrevious = -1;
+
+#define COUNT_DISPATCH(op)                     \
+    do {                                       \
+        opcodeCounts[op]++;                    \
+        if (dispatchPrevious >= 0)             \
+            opcodePairs[dispatchPrevious][op]++; \
+        dispatchPrevious = (op);               \
+    } while (false)
+
+#define COUNT_BRANCH(op, taken)  \
+    do {                         \
+        branchTotals[op]++;      \
+        if (taken)               \
+            branchTakens[op]++;  \
+    } while (false)
+
+uint64_t dispatchStatsTotal(void)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < OPCODE_COUNT; i++) {
+        total += opcodeCounts[i];
+    }
+    return total;
+}
+
+void dispatchStatsReset(void)
+{
+    memset(opcodeCounts, 0, sizeof(opcodeCounts));
+    memset(opcodePairs, 0, sizeof(opcodePairs));
+    memset(branchTotals, 0, sizeof(branchTotals));
+    memset(branchTakens, 0, sizeof(branchTakens));
+}
+
+void dispatchStatsDump(FILE* out)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < OPCODE_COUNT; i++) {
+        total += opcodeCounts[i];
+    }
+    if (total == 0)
+        return;
+
+    fprintf(out, "== opcodes (%llu dispatches) ==\n", (unsigned long long)total);
+    bool printed[OPCODE_COUNT] = { false };
+    for (;;) {
+        int best = -1;
+        for (int i = 0; i < OPCODE_COUNT; i++) {
+            if (!printed[i] && opcodeCounts[i] > 0
+                && (best < 0 || opcodeCounts[i] > opcodeCounts[best]))
+                best = i;
+        }
+        if (best < 0)
+            break;
+        printed[best] = true;
+        fprintf(out, "%12llu  %5.2f%%  %s\n",
+            (unsigned long long)opcodeCounts[best],
+            100.0 * (double)opcodeCounts[best] / (double)total,
+            opcodeNames[best]);
+    }
+
+    // Selection over the pair matrix: each printed pair is zeroed to find
+    // the next one, then restored so a dump never consumes the data.
+    fprintf(out, "== top opcode pairs ==\n");
+    int      pairA[20], pairB[20];
+    uint64_t pairCount[20];
+    int      pairs = 0;
+    for (int rank = 0; rank < 20; rank++) {
+        int      bestA = -1, bestB = -1;
+        uint64_t bestCount = 0;
+        for (int a = 0; a < OPCODE_COUNT; a++) {
+            for (int b = 0; b < OPCODE_COUNT; b++) {
+                if (opcodePairs[a][b] > bestCount) {
+                    bestCount = opcodePairs[a][b];
+                    bestA     = a;
+                    bestB     = b;
+                }
+            }
+        }
+        if (bestA < 0)
+            break;
+        fprintf(out, "%12llu  %5.2f%%  %s -> %s\n",
+            (unsigned long long)bestCount,
+            100.0 * (double)bestCount / (double)total,
+            opcodeNames[bestA], opcodeNames[bestB]);
+        pairA[pairs]     = bestA;
+        pairB[pairs]     = bestB;
+        pairCount[pairs] = bestCount;
+        pairs++;
+        opcodePairs[bestA][bestB] = 0;
+    }
+    for (int i = 0; i < pairs; i++) {
+        opcodePairs[pairA[i]][pairB[i]] = pairCount[i];
+    }
+
+    fprintf(out, "== branches ==\n");
+    for (int i = 0; i < OPCODE_COUNT; i++) {
+        if (branchTotals[i] == 0)
+            continue;
+        fprintf(out, "%12llu  taken %5.2f%%  %s\n",
+            (unsigned long long)branchTotals[i],
+            100.0 * (double)branchTakens[i] / (double)branchTotals[i],
+            opcodeNames[i]);
+    }
+}
+
+#else
+
+#define COUNT_DISPATCH(op) \
+    do {                   \
+    } while (false)
+#define COUNT_BRANCH(op, taken) \
+    do {                        \
+    } while (false)
+
+#endif
+
 InterpretResult run(void)
 {
     register CallFrame*   frame;
@@ -426,6 +767,18 @@ InterpretResult run(void)
 
 #define STORE_FRAME() frame->ip = ip
 
+// After a call lands at the top of a jitted function, run the native
+// translation instead; it hands back the bytecode offset to resume from
+// (the first opcode it could not translate, or a type-guard deopt site).
+#ifdef JIT_AVAILABLE
+#define JIT_ENTER_FRAME()                                             \
+    if (jitReady(fn->jit) && ip == fn->chunk.code) {                  \
+        ip = fn->chunk.code + jitEnter(fn, stackStart, &vm.stackTop); \
+    }
+#else
+#define JIT_ENTER_FRAME()
+#endif
+
 #define PUSH(value) (*vm.stackTop++ = value)
 #define POP() (*(--vm.stackTop))
 #define DROP() (--vm.stackTop)
@@ -463,7 +816,7 @@ InterpretResult run(void)
         PUSH(valueType(a op b));                         \
     } while (false)
 
-#define INVOKE_DUNDER(dunderMethod)                                            \
+#define INVOKE_DUNDER(operator, dunderMethod)                                  \
     Obj* this  = AS_OBJ(PEEK2());                                              \
     Obj* other = AS_OBJ(PEEK());                                               \
     if (this->type == OBJ_INSTANCE && other->type == OBJ_INSTANCE) {           \
@@ -474,10 +827,13 @@ InterpretResult run(void)
             runtimeError("Operands must be two instances of the same class."); \
             return INTERPRET_RUNTIME_ERROR;                                    \
         }                                                                      \
-        Value method   = OBJ_VAL(dunderMethod);                                \
-        int   argCount = 1;                                                    \
+        ObjClosure* operatorMethod = thisInstance->klass->operators[operator]; \
         STORE_FRAME();                                                         \
-        if (!invoke(method, argCount)) {                                       \
+        if (operatorMethod != NULL) {                                          \
+            if (!call(operatorMethod, 1)) {                                    \
+                return INTERPRET_RUNTIME_ERROR;                                \
+            }                                                                  \
+        } else if (!invoke(OBJ_VAL(dunderMethod), 1, NULL)) {                  \
             return INTERPRET_RUNTIME_ERROR;                                    \
         }                                                                      \
         LOAD_FRAME();                                                          \
@@ -517,19 +873,23 @@ InterpretResult run(void)
 
 #define INTERPRET_LOOP DISPATCH();
 #define CASE_CODE(name) code_##name
-#define DISPATCH()                                              \
-    TRACE_EXECUTION();                                          \
-    if (!vm.errorState) {                                       \
-        goto* dispatchTable[instruction = (OpCode)READ_BYTE()]; \
-    } else {                                                    \
-        return INTERPRET_RUNTIME_ERROR;                         \
+#define DISPATCH()                             \
+    TRACE_EXECUTION();                         \
+    if (!vm.errorState) {                      \
+        instruction = (OpCode)READ_BYTE();     \
+        COUNT_DISPATCH(instruction);           \
+        goto* dispatchTable[instruction];      \
+    } else {                                   \
+        return INTERPRET_RUNTIME_ERROR;        \
     }
 
 #else
-#define INTERPRET_LOOP \
-    loop:              \
-    TRACE_EXECUTION(); \
-    switch (instruction = (OpCode)READ_BYTE())
+#define INTERPRET_LOOP                 \
+    loop:                              \
+    TRACE_EXECUTION();                 \
+    instruction = (OpCode)READ_BYTE(); \
+    COUNT_DISPATCH(instruction);       \
+    switch (instruction)
 
 #define CASE_CODE(name) case OP_##name
 #define DISPATCH()                      \
@@ -586,8 +946,10 @@ InterpretResult run(void)
         CASE_CODE(SET_UPVALUE)
             :
         {
-            uint16_t slot                             = READ_SHORT();
-            *frame->closure->upvalues[slot]->location = PEEK();
+            uint16_t    slot    = READ_SHORT();
+            ObjUpvalue* upvalue = frame->closure->upvalues[slot];
+            *upvalue->location  = PEEK();
+            writeBarrier((Obj*)upvalue, PEEK());
             DISPATCH();
         }
 
@@ -595,7 +957,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.neqString);
+                INVOKE_DUNDER(OPERATOR_NEQ, vm.neqString);
             } else if (IS_ARRAY(PEEK()) && IS_ARRAY(PEEK2())) {
                 ObjArray* b = AS_ARRAY(POP());
                 ObjArray* a = AS_ARRAY(POP());
@@ -612,7 +974,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.eqString);
+                INVOKE_DUNDER(OPERATOR_EQ, vm.eqString);
             } else if (IS_ARRAY(PEEK()) && IS_ARRAY(PEEK2())) {
                 ObjArray* b = AS_ARRAY(POP());
                 ObjArray* a = AS_ARRAY(POP());
@@ -629,7 +991,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.gtString);
+                INVOKE_DUNDER(OPERATOR_GT, vm.gtString);
             } else {
                 BINARY_OP(BOOL_VAL, >);
             }
@@ -640,7 +1002,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.gteString);
+                INVOKE_DUNDER(OPERATOR_GTE, vm.gteString);
             } else {
                 BINARY_OP(BOOL_VAL, >=);
             }
@@ -650,8 +1012,12 @@ InterpretResult run(void)
         CASE_CODE(LESS)
             :
         {
-            if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.ltString);
+            if (IS_INT(PEEK()) && IS_INT(PEEK2())) {
+                int32_t b = AS_INT(POP());
+                int32_t a = AS_INT(POP());
+                PUSH(BOOL_VAL(a < b));
+            } else if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
+                INVOKE_DUNDER(OPERATOR_LT, vm.ltString);
             } else {
                 BINARY_OP(BOOL_VAL, <);
             }
@@ -662,7 +1028,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.lteString);
+                INVOKE_DUNDER(OPERATOR_LTE, vm.lteString);
             } else {
                 BINARY_OP(BOOL_VAL, <=);
             }
@@ -672,28 +1038,40 @@ InterpretResult run(void)
         CASE_CODE(ADD)
             :
         {
-            if (IS_STRING(PEEK()) && IS_STRING(PEEK2())) {
-                concatenate();
-            } else if (IS_NUMBER(PEEK()) && IS_NUMBER(PEEK2())) {
-                double b = AS_NUMBER(POP());
-                double a = AS_NUMBER(POP());
-                PUSH(NUMBER_VAL(a + b));
+            // Quicken the common cases: rewrite this site into a
+            // specialized opcode and re-dispatch it.
+            if (IS_NUMBER(PEEK()) && IS_NUMBER(PEEK2())) {
+                ip[-1] = OP_ADD_NUMBER;
+                ip--;
+                DISPATCH();
+            } else if (IS_STRING(PEEK()) && IS_STRING(PEEK2())) {
+                ip[-1] = OP_ADD_STRING;
+                ip--;
+                DISPATCH();
+            } else if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
+                ip[-1] = OP_ADD_DUNDER;
+                ip--;
+                DISPATCH();
             } else if (IS_TABLE(PEEK()) && IS_TABLE(PEEK2())) {
-                ObjTable* b   = AS_TABLE(POP());
-                ObjTable* a   = AS_TABLE(POP());
+                // Leave the operands rooted until the join is complete; the
+                // copies allocate and can trigger a collection.
+                ObjTable* b   = AS_TABLE(PEEK());
+                ObjTable* a   = AS_TABLE(PEEK2());
                 ObjTable* new = newTable();
+                PUSH(OBJ_VAL(new));
                 tableAddAll(&b->table, &new->table);
                 tableAddAll(&a->table, &new->table);
-                PUSH(OBJ_VAL(new));
+                vm.stackTop[-3] = vm.stackTop[-1];
+                vm.stackTop -= 2;
             } else if (IS_ARRAY(PEEK()) && IS_ARRAY(PEEK2())) {
-                ObjArray* b   = AS_ARRAY(POP());
-                ObjArray* a   = AS_ARRAY(POP());
+                ObjArray* b   = AS_ARRAY(PEEK());
+                ObjArray* a   = AS_ARRAY(PEEK2());
                 ObjArray* new = newArray();
+                PUSH(OBJ_VAL(new));
                 joinValueArray(&new->array, &a->array);
                 joinValueArray(&new->array, &b->array);
-                PUSH(OBJ_VAL(new));
-            } else if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.addString);
+                vm.stackTop[-3] = vm.stackTop[-1];
+                vm.stackTop -= 2;
             } else {
                 STORE_FRAME();
                 runtimeError(
@@ -703,11 +1081,70 @@ InterpretResult run(void)
             DISPATCH();
         }
 
+        CASE_CODE(ADD_NUMBER)
+            :
+        {
+            if (!IS_NUMBER(PEEK()) || !IS_NUMBER(PEEK2())) {
+                // Type miss: deopt back to the generic form.
+                ip[-1] = OP_ADD;
+                ip--;
+                DISPATCH();
+            }
+            if (IS_INT(PEEK()) && IS_INT(PEEK2())) {
+                int32_t b = AS_INT(POP());
+                int32_t a = AS_INT(POP());
+                int32_t sum;
+                if (__builtin_add_overflow(a, b, &sum)) {
+                    PUSH(NUMBER_VAL((double)a + (double)b));
+                } else {
+                    PUSH(INT_VAL(sum));
+                }
+            } else {
+                double b = AS_NUMBER(POP());
+                double a = AS_NUMBER(POP());
+                PUSH(NUMBER_VAL(a + b));
+            }
+            DISPATCH();
+        }
+
+        CASE_CODE(ADD_STRING)
+            :
+        {
+            if (!IS_STRING(PEEK()) || !IS_STRING(PEEK2())) {
+                ip[-1] = OP_ADD;
+                ip--;
+                DISPATCH();
+            }
+            concatenate();
+            DISPATCH();
+        }
+
+        CASE_CODE(ADD_DUNDER)
+            :
+        {
+            if (!IS_INSTANCE(PEEK()) || !IS_INSTANCE(PEEK2())) {
+                ip[-1] = OP_ADD;
+                ip--;
+                DISPATCH();
+            }
+            INVOKE_DUNDER(OPERATOR_ADD, vm.addString);
+            DISPATCH();
+        }
+
         CASE_CODE(SUBTRACT)
             :
         {
-            if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.subString);
+            if (IS_INT(PEEK()) && IS_INT(PEEK2())) {
+                int32_t b = AS_INT(POP());
+                int32_t a = AS_INT(POP());
+                int32_t diff;
+                if (__builtin_sub_overflow(a, b, &diff)) {
+                    PUSH(NUMBER_VAL((double)a - (double)b));
+                } else {
+                    PUSH(INT_VAL(diff));
+                }
+            } else if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
+                INVOKE_DUNDER(OPERATOR_SUB, vm.subString);
             } else {
                 BINARY_OP(NUMBER_VAL, -);
             }
@@ -718,7 +1155,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.mulString);
+                INVOKE_DUNDER(OPERATOR_MUL, vm.mulString);
             } else {
                 BINARY_OP(NUMBER_VAL, *);
             }
@@ -729,7 +1166,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.divString);
+                INVOKE_DUNDER(OPERATOR_DIV, vm.divString);
             } else {
                 BINARY_OP(NUMBER_VAL, /);
             }
@@ -740,7 +1177,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.modString);
+                INVOKE_DUNDER(OPERATOR_MOD, vm.modString);
             } else {
                 BINARY_OP_INT(NUMBER_VAL, %);
             }
@@ -751,7 +1188,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.andString);
+                INVOKE_DUNDER(OPERATOR_AND, vm.andString);
             } else {
                 BINARY_OP_INT(NUMBER_VAL, &);
             }
@@ -762,7 +1199,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.orString);
+                INVOKE_DUNDER(OPERATOR_OR, vm.orString);
             } else {
                 BINARY_OP_INT(NUMBER_VAL, |);
             }
@@ -773,7 +1210,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.xorString);
+                INVOKE_DUNDER(OPERATOR_XOR, vm.xorString);
             } else {
                 BINARY_OP_INT(NUMBER_VAL, ^);
             }
@@ -784,7 +1221,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.lshiftString);
+                INVOKE_DUNDER(OPERATOR_LSHIFT, vm.lshiftString);
             } else {
                 BINARY_OP_INT(NUMBER_VAL, <<);
             }
@@ -795,7 +1232,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.rshiftString);
+                INVOKE_DUNDER(OPERATOR_RSHIFT, vm.rshiftString);
             } else {
                 BINARY_OP_INT(NUMBER_VAL, >>);
             }
@@ -806,7 +1243,7 @@ InterpretResult run(void)
             :
         {
             if (IS_INSTANCE(PEEK()) && IS_INSTANCE(PEEK2())) {
-                INVOKE_DUNDER(vm.notString);
+                INVOKE_DUNDER(OPERATOR_NOT, vm.notString);
             } else {
                 push(BOOL_VAL(isFalsey(pop())));
             }
@@ -828,6 +1265,10 @@ InterpretResult run(void)
         CASE_CODE(INCREMENT)
             :
         {
+            if (IS_INT(PEEK()) && AS_INT(PEEK()) != INT32_MAX) {
+                push(INT_VAL(AS_INT(pop()) + 1));
+                DISPATCH();
+            }
             if (!IS_NUMBER(PEEK())) {
                 STORE_FRAME();
                 runtimeError("Operand must be a number.");
@@ -840,6 +1281,10 @@ InterpretResult run(void)
         CASE_CODE(DECREMENT)
             :
         {
+            if (IS_INT(PEEK()) && AS_INT(PEEK()) != INT32_MIN) {
+                push(INT_VAL(AS_INT(pop()) - 1));
+                DISPATCH();
+            }
             if (!IS_NUMBER(PEEK())) {
                 STORE_FRAME();
                 runtimeError("Operand must be a number.");
@@ -849,6 +1294,100 @@ InterpretResult run(void)
             DISPATCH();
         }
 
+        CASE_CODE(GET_LOCAL_CONSTANT_ADD)
+            :
+        {
+            uint16_t slot     = READ_SHORT();
+            Value    constant = READ_CONSTANT();
+            ip += 2; // padding
+            Value local = stackStart[slot];
+            if (IS_INT(local) && IS_INT(constant)) {
+                int32_t sum;
+                if (__builtin_add_overflow(AS_INT(local), AS_INT(constant), &sum)) {
+                    PUSH(NUMBER_VAL(AS_NUMBER(local) + AS_NUMBER(constant)));
+                } else {
+                    PUSH(INT_VAL(sum));
+                }
+            } else if (IS_NUMBER(local)) {
+                PUSH(NUMBER_VAL(AS_NUMBER(local) + AS_NUMBER(constant)));
+            } else {
+                STORE_FRAME();
+                runtimeError("Operands must be two joinable types.");
+                return INTERPRET_RUNTIME_ERROR;
+            }
+            DISPATCH();
+        }
+
+        CASE_CODE(LESS_JUMP_IF_FALSE)
+            :
+        {
+            if (IS_NUMBER(PEEK()) && IS_NUMBER(PEEK2())) {
+                uint16_t offset = READ_SHORT();
+                ip += 1; // padding
+                bool less;
+                if (IS_INT(PEEK()) && IS_INT(PEEK2())) {
+                    int32_t b = AS_INT(POP());
+                    int32_t a = AS_INT(POP());
+                    less      = a < b;
+                } else {
+                    double b = AS_NUMBER(POP());
+                    double a = AS_NUMBER(POP());
+                    less     = a < b;
+                }
+                PUSH(BOOL_VAL(less));
+                COUNT_BRANCH(instruction, !less);
+                if (!less)
+                    ip += offset;
+                DISPATCH();
+            }
+
+            // Unexpected operand types (e.g. an instance with __lt):
+            // restore the original LESS; JUMP_IF_FALSE pair and re-run it.
+            uint8_t hi = ip[0];
+            uint8_t lo = ip[1];
+            ip[-1]     = OP_LESS;
+            ip[0]      = OP_JUMP_IF_FALSE;
+            ip[1]      = hi;
+            ip[2]      = lo;
+            ip--;
+            DISPATCH();
+        }
+
+        CASE_CODE(CONSTANT_CALL)
+            :
+        {
+            Value constant = READ_CONSTANT();
+            PUSH(constant);
+            int argCount = READ_SHORT();
+            ip += 1; // padding
+            STORE_FRAME();
+
+            if (!callValue(peek(argCount), argCount)) {
+                return INTERPRET_RUNTIME_ERROR;
+            }
+
+            LOAD_FRAME();
+            JIT_ENTER_FRAME();
+            DISPATCH();
+        }
+
+        CASE_CODE(INCREMENT_SET_LOCAL_POP)
+            :
+        {
+            uint16_t slot = READ_SHORT();
+            ip += 2; // padding
+            if (IS_INT(PEEK()) && AS_INT(PEEK()) != INT32_MAX) {
+                stackStart[slot] = INT_VAL(AS_INT(POP()) + 1);
+            } else if (IS_NUMBER(PEEK())) {
+                stackStart[slot] = NUMBER_VAL(AS_NUMBER(POP()) + 1);
+            } else {
+                STORE_FRAME();
+                runtimeError("Operand must be a number.");
+                return INTERPRET_RUNTIME_ERROR;
+            }
+            DISPATCH();
+        }
+
         CASE_CODE(POP)
             :
         {
@@ -962,11 +1501,11 @@ InterpretResult run(void)
         CASE_CODE(GET_GLOBAL)
             :
         {
-            Value name = READ_CONSTANT();
-            Value value;
-            if (!tableGet(&vm.globals, name, &value)) {
+            uint16_t slot  = READ_SHORT();
+            Value    value = vm.globalSlots.values[slot];
+            if (IS_EMPTY(value)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(name));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slot]));
                 return INTERPRET_RUNTIME_ERROR;
             }
             PUSH(value);
@@ -976,21 +1515,22 @@ InterpretResult run(void)
         CASE_CODE(GET_GLOBAL_2)
             :
         {
-            Value nameA = READ_CONSTANT();
-            Value valueA;
-            if (!tableGet(&vm.globals, nameA, &valueA)) {
+            uint16_t slotA  = READ_SHORT();
+            Value    valueA = vm.globalSlots.values[slotA];
+            if (IS_EMPTY(valueA)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameA));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotA]));
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            Value nameB = READ_CONSTANT();
-            Value valueB;
-            if (!tableGet(&vm.globals, nameB, &valueB)) {
+            uint16_t slotB  = READ_SHORT();
+            Value    valueB = vm.globalSlots.values[slotB];
+            if (IS_EMPTY(valueB)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameB));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotB]));
                 return INTERPRET_RUNTIME_ERROR;
             }
+
             PUSH(valueA);
             PUSH(valueB);
             DISPATCH();
@@ -999,29 +1539,30 @@ InterpretResult run(void)
         CASE_CODE(GET_GLOBAL_3)
             :
         {
-            Value nameA = READ_CONSTANT();
-            Value valueA;
-            if (!tableGet(&vm.globals, nameA, &valueA)) {
+            uint16_t slotA  = READ_SHORT();
+            Value    valueA = vm.globalSlots.values[slotA];
+            if (IS_EMPTY(valueA)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameA));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotA]));
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            Value nameB = READ_CONSTANT();
-            Value valueB;
-            if (!tableGet(&vm.globals, nameB, &valueB)) {
+            uint16_t slotB  = READ_SHORT();
+            Value    valueB = vm.globalSlots.values[slotB];
+            if (IS_EMPTY(valueB)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameB));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotB]));
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            Value nameC = READ_CONSTANT();
-            Value valueC;
-            if (!tableGet(&vm.globals, nameC, &valueC)) {
+            uint16_t slotC  = READ_SHORT();
+            Value    valueC = vm.globalSlots.values[slotC];
+            if (IS_EMPTY(valueC)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameC));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotC]));
                 return INTERPRET_RUNTIME_ERROR;
             }
+
             PUSH(valueA);
             PUSH(valueB);
             PUSH(valueC);
@@ -1031,37 +1572,38 @@ InterpretResult run(void)
         CASE_CODE(GET_GLOBAL_4)
             :
         {
-            Value nameA = READ_CONSTANT();
-            Value valueA;
-            if (!tableGet(&vm.globals, nameA, &valueA)) {
+            uint16_t slotA  = READ_SHORT();
+            Value    valueA = vm.globalSlots.values[slotA];
+            if (IS_EMPTY(valueA)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameA));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotA]));
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            Value nameB = READ_CONSTANT();
-            Value valueB;
-            if (!tableGet(&vm.globals, nameB, &valueB)) {
+            uint16_t slotB  = READ_SHORT();
+            Value    valueB = vm.globalSlots.values[slotB];
+            if (IS_EMPTY(valueB)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameB));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotB]));
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            Value nameC = READ_CONSTANT();
-            Value valueC;
-            if (!tableGet(&vm.globals, nameC, &valueC)) {
+            uint16_t slotC  = READ_SHORT();
+            Value    valueC = vm.globalSlots.values[slotC];
+            if (IS_EMPTY(valueC)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameC));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotC]));
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            Value nameD = READ_CONSTANT();
-            Value valueD;
-            if (!tableGet(&vm.globals, nameD, &valueD)) {
+            uint16_t slotD  = READ_SHORT();
+            Value    valueD = vm.globalSlots.values[slotD];
+            if (IS_EMPTY(valueD)) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(nameD));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slotD]));
                 return INTERPRET_RUNTIME_ERROR;
             }
+
             PUSH(valueA);
             PUSH(valueB);
             PUSH(valueC);
@@ -1072,8 +1614,10 @@ InterpretResult run(void)
         CASE_CODE(DEFINE_GLOBAL)
             :
         {
-            Value name = READ_CONSTANT();
-            tableSet(&vm.globals, name, PEEK());
+            uint16_t slot                = READ_SHORT();
+            vm.globalSlots.values[slot]  = PEEK();
+            // keep the name table in sync for REPL late binding
+            tableSet(&vm.globals, vm.globalNames.values[slot], PEEK());
             DROP();
             DISPATCH();
         }
@@ -1081,13 +1625,13 @@ InterpretResult run(void)
         CASE_CODE(SET_GLOBAL)
             :
         {
-            Value name = READ_CONSTANT();
-            if (tableSet(&vm.globals, name, PEEK())) {
-                tableDelete(&vm.globals, name);
+            uint16_t slot = READ_SHORT();
+            if (IS_EMPTY(vm.globalSlots.values[slot])) {
                 STORE_FRAME();
-                runtimeError("Undefined variable '%s'.", stringValue(name));
+                runtimeError("Undefined variable '%s'.", stringValue(vm.globalNames.values[slot]));
                 return INTERPRET_RUNTIME_ERROR;
             }
+            vm.globalSlots.values[slot] = PEEK();
             DISPATCH();
         }
 
@@ -1099,27 +1643,46 @@ InterpretResult run(void)
             case OBJ_INSTANCE: {
                 ObjInstance* instance = AS_INSTANCE(PEEK());
                 Value        name     = READ_CONSTANT();
+                InlineCache* cache    = &fn->chunk.caches[READ_SHORT()];
 
-                Value value;
-                if (tableGet(&instance->fields, name, &value)) {
+                Value cached;
+                if (cacheGet(cache, (Obj*)instance->shape, &cached)) {
                     DROP();
-                    PUSH(value);
+                    PUSH(instance->slots[(int)AS_NUMBER(cached)]);
                     break;
                 }
 
-                if (!bindMethod(instance->klass, name)) {
-                    return INTERPRET_RUNTIME_ERROR;
+                Value slot;
+                if (tableGet(&instance->shape->slots, name, &slot)) {
+                    cacheStore(cache, (Obj*)instance->shape, slot);
+                    DROP();
+                    PUSH(instance->slots[(int)AS_NUMBER(slot)]);
+                    break;
+                }
+
+                Value method;
+                if (!cacheGet(cache, (Obj*)instance->klass, &method)) {
+                    if (!classMethod(instance->klass, name, &method)) {
+                        STORE_FRAME();
+                        runtimeError("Undefined property '%s'.", stringValue(name));
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                    cacheStore(cache, (Obj*)instance->klass, method);
                 }
 
+                ObjBoundMethod* bound = newBoundMethod(PEEK(), AS_CLOSURE(method));
+                DROP();
+                PUSH(OBJ_VAL(bound));
                 break;
             }
             case OBJ_TABLE: {
                 ObjTable* table = AS_TABLE(PEEK());
                 Value     index = READ_CONSTANT();
-                Value     value;
+                ip += 2; // skip the unused cache slot
+                Value value;
                 if (!tableGet(&table->table, index, &value)) {
                     STORE_FRAME();
-                    runtimeError("3Undefined property '%s'.", AS_STRING(index)->chars);
+                    runtimeError("3Undefined property '%s'.", AS_CSTRING(index));
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 DROP();
@@ -1144,7 +1707,24 @@ InterpretResult run(void)
             switch (value->type) {
             case OBJ_INSTANCE: {
                 ObjInstance* instance = AS_INSTANCE(PEEK2());
-                tableSet(&instance->fields, READ_CONSTANT(), PEEK());
+                Value        name     = READ_CONSTANT();
+                InlineCache* cache    = &fn->chunk.caches[READ_SHORT()];
+
+                Value cached;
+                if (cacheGet(cache, (Obj*)instance->shape, &cached)) {
+                    instance->slots[(int)AS_NUMBER(cached)] = PEEK();
+                    writeBarrier((Obj*)instance, PEEK());
+                } else {
+                    Value slot;
+                    if (tableGet(&instance->shape->slots, name, &slot)) {
+                        cacheStore(cache, (Obj*)instance->shape, slot);
+                        instance->slots[(int)AS_NUMBER(slot)] = PEEK();
+                        writeBarrier((Obj*)instance, PEEK());
+                    } else {
+                        instanceSetField(instance, name, PEEK());
+                    }
+                }
+
                 Value value = POP();
                 DROP();
                 PUSH(value);
@@ -1153,7 +1733,11 @@ InterpretResult run(void)
 
             case OBJ_TABLE: {
                 ObjTable* table = AS_TABLE(PEEK2());
-                tableSet(&table->table, READ_CONSTANT(), PEEK());
+                Value     key   = READ_CONSTANT();
+                tableSet(&table->table, key, PEEK());
+                writeBarrier((Obj*)table, key);
+                writeBarrier((Obj*)table, PEEK());
+                ip += 2; // skip the unused cache slot
                 Value value = POP();
                 DROP();
                 PUSH(value);
@@ -1164,13 +1748,20 @@ InterpretResult run(void)
                 if (IS_CLASS(PEEK())) {
                     ObjClass* klass = AS_CLASS(PEEK());
                     printf("name: %s\n", klass->name->chars);
-                    tableSet(&klass->fields, READ_CONSTANT(), PEEK2());
+                    Value key = READ_CONSTANT();
+                    tableSet(&klass->fields, key, PEEK2());
+                    writeBarrier((Obj*)klass, key);
+                    writeBarrier((Obj*)klass, PEEK2());
                     POP();
                 } else {
                     ObjClass* klass = AS_CLASS(PEEK2());
-                    tableSet(&klass->fields, READ_CONSTANT(), PEEK());
+                    Value     key   = READ_CONSTANT();
+                    tableSet(&klass->fields, key, PEEK());
+                    writeBarrier((Obj*)klass, key);
+                    writeBarrier((Obj*)klass, PEEK());
                     POP();
                 }
+                ip += 2; // skip the unused cache slot
                 break;
             }
 
@@ -1195,6 +1786,54 @@ InterpretResult run(void)
             DISPATCH();
         }
 
+        CASE_CODE(SWITCH)
+            :
+        {
+            // One hash lookup routes straight to the matching case body.
+            // A disabled table (non-literal case values) falls through to
+            // the compare chain that still follows the operand.
+            uint16_t     index = READ_SHORT();
+            SwitchTable* table = &fn->chunk.switchTables[index];
+            if (table->enabled) {
+                Value target;
+                if (tableGet(&table->offsets, PEEK(), &target)) {
+                    ip = fn->chunk.code + (int)AS_NUMBER(target);
+                } else {
+                    ip = fn->chunk.code + table->defaultOffset;
+                }
+            }
+            DISPATCH();
+        }
+
+        CASE_CODE(FOR_LOOP)
+            :
+        {
+            // Fused counting-loop back edge: increment the induction
+            // local, re-test it against the limit, and branch back to the
+            // body start, all in one dispatch.
+            uint16_t slot         = READ_SHORT();
+            uint8_t  limitIsConst = READ_BYTE();
+            uint16_t limitArg     = READ_SHORT();
+            uint16_t back         = READ_SHORT();
+
+            Value induction = stackStart[slot];
+            Value limit     = limitIsConst ? fn->chunk.constants.values[limitArg]
+                                           : stackStart[limitArg];
+            if (!IS_NUMBER(induction) || !IS_NUMBER(limit)) {
+                STORE_FRAME();
+                runtimeError("Operands must be numbers.");
+                return INTERPRET_RUNTIME_ERROR;
+            }
+
+            double next      = AS_NUMBER(induction) + 1;
+            stackStart[slot] = NUMBER_VAL(next);
+            if (next < AS_NUMBER(limit)) {
+                ip -= back;
+                jitCountHot(fn);
+            }
+            DISPATCH();
+        }
+
         CASE_CODE(JUMP)
             :
         {
@@ -1207,7 +1846,9 @@ InterpretResult run(void)
             :
         {
             uint16_t offset = READ_SHORT();
-            if (isFalsey(PEEK()))
+            bool     jump   = isFalsey(PEEK());
+            COUNT_BRANCH(instruction, jump);
+            if (jump)
                 ip += offset;
             DISPATCH();
         }
@@ -1217,6 +1858,7 @@ InterpretResult run(void)
         {
             uint16_t offset = READ_SHORT();
             ip -= offset;
+            jitCountHot(fn);
             DISPATCH();
         }
 
@@ -1238,6 +1880,48 @@ InterpretResult run(void)
                 return INTERPRET_RUNTIME_ERROR;
             }
 
+            LOAD_FRAME();
+            JIT_ENTER_FRAME();
+            DISPATCH();
+        }
+
+        CASE_CODE(TAIL_CALL)
+            :
+        {
+            int   argCount = READ_SHORT();
+            Value callee   = peek(argCount);
+
+            // A closure called in tail position reuses the current frame:
+            // the caller's slots are dead once the call's result is all
+            // that remains, so the callee and its arguments slide down
+            // into them and recursion runs in constant frame space.
+            if (IS_CLOSURE(callee)) {
+                ObjClosure* closure = AS_CLOSURE(callee);
+                if (argCount != closure->function->arity) {
+                    STORE_FRAME();
+                    runtimeError("Expected %d arguments but got %d.", closure->function->arity, argCount);
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+
+                closeUpvalues(stackStart);
+                Value* moving = vm.stackTop - argCount - 1;
+                for (int i = 0; i <= argCount; i++) {
+                    stackStart[i] = moving[i];
+                }
+                vm.stackTop = stackStart + argCount + 1;
+
+                frame->closure = closure;
+                frame->ip      = closure->function->chunk.code;
+                ip             = frame->ip;
+                fn             = closure->function;
+                DISPATCH();
+            }
+
+            // Natives, classes and bound methods keep the plain call path.
+            STORE_FRAME();
+            if (!callValue(callee, argCount)) {
+                return INTERPRET_RUNTIME_ERROR;
+            }
             LOAD_FRAME();
             DISPATCH();
         }
@@ -1275,19 +1959,39 @@ InterpretResult run(void)
                             return INTERPRET_RUNTIME_ERROR;
                         }
 
-                        int          index = 0;
-                        utf8_int32_t codepoint;
-                        utf8_int8_t* str = utf8codepoint(string->chars, &codepoint);
-                        while (str != NULL) {
-                            if (index == i)
-                                break;
+                        // ASCII strings index straight into the bytes.
+                        if (string->ascii) {
+                            PUSH(OBJ_VAL(copyString(string->chars + i, 1)));
+                            break;
+                        }
+
+                        // Resume from the position cache when this string
+                        // is being walked forward, so sequential scans are
+                        // O(1) per character instead of O(i).
+                        char* chars  = stringChars(string);
+                        char* cursor = chars;
+                        int   cp     = 0;
+                        if (vm.indexCacheString == string && vm.indexCacheCp <= i) {
+                            cursor = chars + vm.indexCacheByte;
+                            cp     = vm.indexCacheCp;
+                        }
 
-                            str = utf8codepoint(str, &codepoint);
-                            index++;
+                        utf8_int32_t codepoint = 0;
+                        while (cp < i && *cursor != '\0') {
+                            cursor = (char*)utf8codepoint(cursor, &codepoint);
+                            cp++;
                         }
 
-                        char* output = malloc(5);
-                        utf8catcodepoint(output, codepoint, 2);
+                        vm.indexCacheString = string;
+                        vm.indexCacheCp     = cp;
+                        vm.indexCacheByte   = (int)(cursor - chars);
+
+                        utf8codepoint(cursor, &codepoint);
+
+                        // utf8catcodepoint appends to an existing string,
+                        // so the scratch buffer must start empty.
+                        char output[5] = { 0 };
+                        utf8catcodepoint(output, codepoint, 4);
 
                         PUSH(OBJ_VAL(copyString(output, strlen(output))));
                     }
@@ -1342,6 +2046,8 @@ InterpretResult run(void)
                 Value     index = POP();
                 ObjTable* table = AS_TABLE(POP());
                 tableSet(&table->table, index, value);
+                writeBarrier((Obj*)table, index);
+                writeBarrier((Obj*)table, value);
                 PUSH(OBJ_VAL(table));
                 break;
             }
@@ -1360,7 +2066,10 @@ InterpretResult run(void)
                     runtimeError("Index out of bounds.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
+                if (!IS_NUMBER(value))
+                    array->array.allNumbers = false;
                 array->array.values[(int)AS_NUMBER(index)] = value;
+                writeBarrier((Obj*)array, value);
                 PUSH(OBJ_VAL(array));
                 break;
             }
@@ -1407,16 +2116,18 @@ InterpretResult run(void)
         CASE_CODE(INVOKE)
             :
         {
-            Value method   = READ_CONSTANT();
-            int   argCount = READ_SHORT();
+            Value        method   = READ_CONSTANT();
+            int          argCount = READ_SHORT();
+            InlineCache* cache    = &fn->chunk.caches[READ_SHORT()];
             STORE_FRAME();
 
-            if (!invoke(method, argCount)) {
+            if (!invoke(method, argCount, cache)) {
                 vm.errorState = true;
                 return INTERPRET_RUNTIME_ERROR;
             }
 
             LOAD_FRAME();
+            JIT_ENTER_FRAME();
             DISPATCH();
         }
 
@@ -1470,19 +2181,20 @@ InterpretResult run(void)
             int       elemsCount = READ_SHORT();
             ObjTable* table      = newTable();
 
-            if (elemsCount > 0) {
-                for (int i = elemsCount - 1; i >= 0; i--) {
-                    // if (!IS_STRING(PEEK2())) {
-                    //     runtimeError("Table key must be a string.");
-                    //     return INTERPRET_RUNTIME_ERROR;
-                    // }
-                    tableSet(&table->table, PEEK2(), PEEK());
-                    DROP();
-                    DROP();
-                }
+            // Keep the table on the stack while it is populated; every
+            // insertion can allocate and trigger a collection.
+            PUSH(OBJ_VAL(table));
+
+            for (int i = elemsCount - 1; i >= 0; i--) {
+                // if (!IS_STRING(PEEK2())) {
+                //     runtimeError("Table key must be a string.");
+                //     return INTERPRET_RUNTIME_ERROR;
+                // }
+                tableSet(&table->table, vm.stackTop[-3], vm.stackTop[-2]);
+                vm.stackTop[-3] = vm.stackTop[-1];
+                vm.stackTop -= 2;
             }
 
-            PUSH(OBJ_VAL(table));
             DISPATCH();
         }
 
@@ -1492,17 +2204,16 @@ InterpretResult run(void)
             int       elemsCount = READ_SHORT();
             ObjArray* array      = newArray();
 
-            if (elemsCount > 0) {
-                for (int i = elemsCount - 1; i >= 0; i--) {
-                    writeValueArray(&array->array, peek(i));
-                }
+            // Keep the array on the stack while it is populated; every
+            // append can allocate and trigger a collection.
+            PUSH(OBJ_VAL(array));
 
-                for (int i = elemsCount - 1; i >= 0; i--) {
-                    DROP();
-                }
+            for (int i = elemsCount; i >= 1; i--) {
+                writeValueArray(&array->array, peek(i));
             }
 
-            PUSH(OBJ_VAL(array));
+            vm.stackTop[-elemsCount - 1] = vm.stackTop[-1];
+            vm.stackTop -= elemsCount;
             DISPATCH();
         }
 
@@ -1553,8 +2264,18 @@ InterpretResult run(void)
             ObjClass* subClass   = AS_CLASS(PEEK());
             ObjClass* superClass = AS_CLASS(PEEK2());
 
-            tableAddAll(&superClass->methods, &subClass->methods);
-            tableAddAll(&superClass->fields, &subClass->fields);
+            // Link rather than copy: methods and field defaults resolve up
+            // the superclass chain on demand, so defining a subclass costs
+            // O(1) regardless of how much the parent declares. Operators
+            // stay a flat per-class vtable and are still copied eagerly.
+            subClass->superclass = superClass;
+            writeBarrier((Obj*)subClass, OBJ_VAL(superClass));
+            for (int i = 0; i < OPERATOR_COUNT; i++) {
+                subClass->operators[i] = superClass->operators[i];
+                if (subClass->operators[i] != NULL) {
+                    writeBarrier((Obj*)subClass, OBJ_VAL(subClass->operators[i]));
+                }
+            }
             POP(); // Subclass.
             DISPATCH();
         }
@@ -1590,24 +2311,40 @@ InterpretResult run(void)
             uint16_t argCount   = READ_SHORT();
             ObjString* template = AS_STRING(peek(argCount));
 
-            char* buffer = (char*)malloc(template->length + TEMPLATE_BUFFER * sizeof(char));
-            if (buffer == NULL) {
-                fprintf(stderr, "Malloc failed!\n");
-                return INTERPRET_RUNTIME_ERROR;
-            }
-
-            strcpy(buffer, template->chars);
-
-            for (int i = argCount; i >= 0; i--) {
-                Value arg    = peek(i - 1);
-                char* string = stringValue(arg);
-                replace_placeholder(buffer, string);
+            // One left-to-right pass: literal runs and interpolated
+            // values append into a single builder, so output size is
+            // unbounded (the old fixed TEMPLATE_BUFFER slack could
+            // overflow) and values containing "{}" are never rescanned.
+            StringBuilder sb;
+            sbInit(&sb);
+
+            const char* at       = stringChars(template);
+            const char* end      = at + template->length;
+            int         argIndex = 0;
+            while (at < end) {
+                const char* brace = memchr(at, '{', end - at);
+                if (brace == NULL || brace + 1 >= end || brace[1] != '}') {
+                    const char* stop = brace == NULL ? end : brace + 1;
+                    sbAppend(&sb, at, stop - at);
+                    at = stop;
+                    continue;
+                }
+                sbAppend(&sb, at, brace - at);
+                at = brace + 2;
+                if (argIndex < argCount) {
+                    sbAppendValue(&sb, peek(argCount - 1 - argIndex));
+                    argIndex++;
+                } else {
+                    // More placeholders than arguments: keep the braces,
+                    // as the old replacer did.
+                    sbAppend(&sb, "{}", 2);
+                }
             }
 
             for (int i = 0; i < argCount + 1; i++)
                 POP();
 
-            PUSH(OBJ_VAL(takeString(buffer, strlen(buffer))));
+            PUSH(OBJ_VAL(sbFinish(&sb)));
 
             DISPATCH();
         }
@@ -1617,18 +2354,42 @@ InterpretResult run(void)
         {
             ObjString*   fileName   = AS_STRING(POP());
             ObjFunction* parentFunc = fn;
-            const char*  sourcePath = resolveRelativePath(fileName->chars, parentFunc->source);
-            char*        source     = readFile(sourcePath);
-            ObjFunction* function   = compile(sourcePath, source);
-            if (function == NULL)
-                return INTERPRET_COMPILE_ERROR;
+            const char*  sourcePath = resolveRelativePath(stringChars(fileName), parentFunc->source);
+            ObjString*   modulePath = copyString(sourcePath, strlen(sourcePath));
+            Value        loaded;
+            if (tableGet(&vm.modules, OBJ_VAL(modulePath), &loaded)) {
+                // The module already ran; mirror the stack effect of its
+                // implicit nil return without compiling or running it again.
+                // sourcePath is interned by resolveRelativePath, not ours
+                // to free.
+                vm.stackTop[-1] = NIL_VAL;
+                DISPATCH();
+            }
+            // Register before running so diamond and circular imports only
+            // ever load a module once.
+            PUSH(OBJ_VAL(modulePath));
+            tableSet(&vm.modules, OBJ_VAL(modulePath), BOOL_VAL(true));
+            POP();
+            ObjFunction* function = NULL;
+#ifdef CHUNK_CACHE
+            function = readChunkCache(sourcePath);
+#endif
+            if (function == NULL) {
+                char* source = readFile(sourcePath);
+                function     = compile(sourcePath, source);
+                if (function == NULL)
+                    return INTERPRET_COMPILE_ERROR;
+#ifdef CHUNK_CACHE
+                writeChunkCache(sourcePath, function);
+#endif
+                free(source);
+            }
             PUSH(OBJ_VAL(function));
             ObjClosure* closure = newClosure(function);
             POP();
             STORE_FRAME();
             call(closure, 0);
             LOAD_FRAME();
-            free(source);
             DISPATCH();
         }
     }
@@ -1653,11 +2414,214 @@ InterpretResult run(void)
 #undef LOAD_FRAME
 }
 
+// Sampling profiler: a SIGPROF handler snapshots the frame stack at a fixed
+// frequency into a preallocated buffer, and profileStop() aggregates the
+// snapshots into a flamegraph-compatible collapsed-stack report. The buffers
+// come from the system allocator so the handler never touches the collector;
+// sampled functions are kept alive through markProfilerRoots(). Frame ip is
+// only synced to the frame array at call boundaries, so leaf line numbers are
+// accurate to the last frame sync, not the exact interrupted instruction.
+
+#define PROFILE_MAX_SAMPLES 16384
+#define PROFILE_MAX_DEPTH 32
+#define PROFILE_DEFAULT_HZ 99
+
+typedef struct {
+    ObjFunction* function;
+    int          offset;
+} ProfileFrame;
+
+typedef struct {
+    bool          active;
+    VM*           owner;
+    int           sampleCount;
+    int           dropped;
+    uint8_t*      depths;
+    ProfileFrame* frames;
+} Profiler;
+
+static Profiler profiler;
+
+// Async-signal-safe: reads the VM, writes only into the preallocated buffer,
+// and publishes each sample by bumping sampleCount last. ITIMER_PROF can
+// deliver on any thread; samples are only taken on the thread that started
+// the profiler, so worker isolates go uncounted.
+static void profileSample(int sig)
+{
+    (void)sig;
+    if (!profiler.active || profiler.owner != &vm)
+        return;
+    if (profiler.sampleCount >= PROFILE_MAX_SAMPLES) {
+        profiler.dropped++;
+        return;
+    }
+
+    int count = vm.frameCount;
+    if (count <= 0)
+        return;
+
+    // Deep stacks keep the innermost frames; the root side truncates.
+    int first = count > PROFILE_MAX_DEPTH ? count - PROFILE_MAX_DEPTH : 0;
+
+    ProfileFrame* out   = &profiler.frames[profiler.sampleCount * PROFILE_MAX_DEPTH];
+    int           depth = 0;
+    for (int i = first; i < count; i++) {
+        CallFrame*  frame   = &vm.frames[i];
+        ObjClosure* closure = frame->closure;
+        if (closure == NULL)
+            continue;
+        out[depth].function = closure->function;
+        out[depth].offset   = (int)(frame->ip - closure->function->chunk.code) - 1;
+        depth++;
+    }
+    if (depth == 0)
+        return;
+
+    profiler.depths[profiler.sampleCount] = (uint8_t)depth;
+    profiler.sampleCount++;
+}
+
+bool profileStart(int hz)
+{
+    if (profiler.active)
+        return false;
+    if (hz <= 0)
+        hz = PROFILE_DEFAULT_HZ;
+
+    profiler.owner       = &vm;
+    profiler.sampleCount = 0;
+    profiler.dropped     = 0;
+    profiler.depths      = malloc(PROFILE_MAX_SAMPLES);
+    profiler.frames      = malloc(sizeof(ProfileFrame) * PROFILE_MAX_SAMPLES * PROFILE_MAX_DEPTH);
+    if (profiler.depths == NULL || profiler.frames == NULL) {
+        free(profiler.depths);
+        free(profiler.frames);
+        profiler.depths = NULL;
+        profiler.frames = NULL;
+        return false;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profileSample;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    profiler.active = true;
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec  = 0;
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value            = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+    return true;
+}
+
+ObjString* profileStop(void)
+{
+    if (!profiler.active || profiler.owner != &vm)
+        return NULL;
+
+    struct itimerval off;
+    memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_PROF, &off, NULL);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPROF, &action, NULL);
+
+    // Buffers stay live (and their functions marked) through aggregation;
+    // active goes false first so a straggling signal is a no-op.
+    profiler.active = false;
+
+    // Fold identical stacks together in a table keyed by the collapsed line.
+    ObjTable* counts = newTable();
+    push(OBJ_VAL(counts));
+
+    for (int i = 0; i < profiler.sampleCount; i++) {
+        ProfileFrame* sample = &profiler.frames[i * PROFILE_MAX_DEPTH];
+
+        StringBuilder sb;
+        sbInit(&sb);
+        for (int d = 0; d < profiler.depths[i]; d++) {
+            ObjFunction* function = sample[d].function;
+
+            int offset = sample[d].offset;
+            if (offset < 0)
+                offset = 0;
+            if (offset >= (int)function->chunk.count)
+                offset = (int)function->chunk.count - 1;
+
+            if (d > 0)
+                sbAppendChar(&sb, ';');
+            sbAppendCString(&sb, function->name != NULL ? function->name->chars : "<script>");
+            sbAppendChar(&sb, '@');
+            sbAppendCString(&sb, function->source);
+            sbAppendChar(&sb, ':');
+            sbAppendNumber(&sb, getLine(&function->chunk, offset));
+        }
+
+        push(OBJ_VAL(sbFinish(&sb)));
+        Value seen;
+        if (!tableGet(&counts->table, vm.stackTop[-1], &seen))
+            seen = NUMBER_VAL(0);
+        tableSet(&counts->table, vm.stackTop[-1], NUMBER_VAL(AS_NUMBER(seen) + 1));
+        writeBarrier((Obj*)counts, vm.stackTop[-1]);
+        pop();
+    }
+
+    // One "stack count" line per unique stack, flamegraph.pl's input format.
+    StringBuilder report;
+    sbInit(&report);
+    for (unsigned int i = 0; i < counts->table.capacity; i++) {
+        Entry* entry = &counts->table.entries[i];
+        if (IS_EMPTY(entry->key))
+            continue;
+        ObjString* stack = AS_STRING(entry->key);
+        sbAppend(&report, stack->chars, stack->length);
+        sbAppendChar(&report, ' ');
+        sbAppendNumber(&report, AS_NUMBER(entry->value));
+        sbAppendChar(&report, '\n');
+    }
+
+    free(profiler.depths);
+    free(profiler.frames);
+    profiler.depths = NULL;
+    profiler.frames = NULL;
+
+    pop(); // counts; the report bytes are already in the builder.
+    return sbFinish(&report);
+}
+
+void markProfilerRoots(void)
+{
+    if (profiler.frames == NULL || profiler.owner != &vm)
+        return;
+    for (int i = 0; i < profiler.sampleCount; i++) {
+        ProfileFrame* sample = &profiler.frames[i * PROFILE_MAX_DEPTH];
+        for (int d = 0; d < profiler.depths[i]; d++) {
+            markObject((Obj*)sample[d].function);
+        }
+    }
+}
+
 InterpretResult interpret(const char* sourcePath, utf8_int8_t* source)
 {
+#ifdef CHUNK_CACHE
+    ObjFunction* function = readChunkCache(sourcePath);
+    if (function == NULL) {
+        function = compile(sourcePath, source);
+        if (function == NULL)
+            return INTERPRET_COMPILE_ERROR;
+        writeChunkCache(sourcePath, function);
+    }
+#else
     ObjFunction* function = compile(sourcePath, source);
     if (function == NULL)
         return INTERPRET_COMPILE_ERROR;
+#endif
 
     push(OBJ_VAL(function));
 